@@ -18,6 +18,18 @@
 #include <unistd.h>
 #include <ctype.h>
 #include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <sched.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <throw.h>
 
 
@@ -28,1085 +40,9004 @@
 #endif
 
 
+/*
+ * receive buffer is kept for the whole life of the connection, so the data
+ * are read directly behind the unprocessed part of the previous read and
+ * messages are returned as pointers into the buffer without any allocation
+ */
+#define XTB_BUFFER_INIT_SIZE 4096
+#define XTB_BUFFER_READ_SIZE 16384
+
+
 typedef struct {
-    SSL_CTX * ctx;
-    SSL     * ssl;
-    BIO     * bio;
-}XTB_Api;
+    char * data;
+    size_t capacity;
+    size_t begin;
+    size_t end;
+    size_t scan;
+}XTB_Buffer;
 
 
-static bool xtb_api_connect(XTB_Api * self, const char * url) {
-    SSL_library_init();
-    SSL_load_error_strings();
-    OpenSSL_add_all_algorithms();
+static bool xtb_buffer_reserve(XTB_Buffer * self, size_t size) {
+    /*
+     * one byte more is reserved for the terminating '\0' of the message
+     */
+    if(self->capacity - self->end > size) {
+        return true;
+    }
 
-    if((self->ctx = SSL_CTX_new(TLS_client_method())) == NULL) {
-        return false;
-	}
+    /*
+     * move unprocessed data to the beginning of buffer before growing
+     */
+    if(self->begin > 0) {
+        memmove(self->data, self->data + self->begin, self->end - self->begin);
 
-	if((self->bio = BIO_new_ssl_connect(self->ctx)) == NULL)  {
-        return false;
-	}
+        self->end  -= self->begin;
+        self->scan -= self->begin;
+        self->begin = 0;
 
-    BIO_set_conn_hostname(self->bio, url);
-	BIO_set_conn_mode(self->bio, BIO_SOCK_NODELAY);
+        if(self->capacity - self->end > size) {
+            return true;
+        }
+    }
 
-	if (BIO_do_connect(self->bio) <= 0) { 
-		SSL_CTX_free(self->ctx); 
-	    BIO_free_all(self->bio);
+    size_t capacity = self->capacity > 0 ? self->capacity : XTB_BUFFER_INIT_SIZE;
 
-        return false;
-  	}
+    while(capacity - self->end <= size) {
+        capacity *= 2;
+    }
 
-	BIO_get_ssl(self->bio, &self->ssl);
-	SSL_set_mode(self->ssl, SSL_MODE_AUTO_RETRY);
+    char * data = realloc(self->data, capacity);
 
-    return true;
-}
+    if(data == NULL) {
+        return false;
+    }
 
+    self->data     = data;
+    self->capacity = capacity;
 
-static void xtb_api_close(XTB_Api * self) {
-    SSL_CTX_free(self->ctx); 
-    BIO_free_all(self->bio);
+    return true;
 }
 
 
-static char * xtb_api_receive(XTB_Api * self) {
-    size_t length = 0;
-    size_t rcv_len;
-    char * resp = malloc(1024);
+/*
+ * searches the delimiter "\n\n" only in the data which were not scanned 
+ * before, so the delimiter splitted by two reads is found too
+ */
+static char * xtb_buffer_find_delimiter(XTB_Buffer * self) {
+    if(self->end - self->begin < 2) {
+        return NULL;
+    }
 
-    while((rcv_len = SSL_read(self->ssl, resp + length, 1024)) > 0) {
-        length += rcv_len;
+    char * it  = self->data + self->scan;
+    char * end = self->data + self->end;
 
-        if((resp[length - 2] == '\n' && resp[length - 1] == '\n')) {
-            break;
-        } else {
-            resp = realloc(resp, length + 1024);
+    while(it + 1 < end && (it = memchr(it, '\n', end - it - 1)) != NULL) {
+        if(it[1] == '\n') {
+            return it;
         }
+
+        it++;
     }
 
-    resp[length] = '\0';
+    self->scan = self->end - 1;
 
-    if(length == 0) {
-        __assert("receive error\n");
-        free(resp);
-        return NULL;
-    } else {
-        return resp;
-    }
+    return NULL;
 }
 
 
-static inline bool xtb_api_send(XTB_Api * self, const char * msg) {
-    if(SSL_write(self->ssl, msg, strlen(msg)) <= 0) {
-        __assert("write command error\n");
-        return false;
-    } else {
-        return true;
-    }
+static inline bool xtb_buffer_has_frame(XTB_Buffer * self) {
+    return xtb_buffer_find_delimiter(self) != NULL;
 }
 
 
-static Json * xtb_api_transaction(XTB_Api * self, const char * cmd) {
-    if(xtb_api_send(self, cmd) == false)
-        return NULL;
-
-    char * resp = xtb_api_receive(self);
+/*
+ * returns next complete message or NULL if the message is not received 
+ * whole yet, returned message is valid until the next read into the buffer
+ */
+static char * xtb_buffer_next_frame(XTB_Buffer * self) {
+    char * delimiter = xtb_buffer_find_delimiter(self);
 
-    if(resp != NULL) {
-        Json * json_resp = json_parse(resp);
-        free(resp);
-        return json_resp;
-    } else {
+    if(delimiter == NULL) {
         return NULL;
     }
-}
-
 
-static bool read_status(Json * json) {
-    if(json == NULL) {
-        return false;
-    } else {
-        Json * json_status = json_lookup(json, "status");
+    char * frame = self->data + self->begin;
 
-        if(json_is_type(json_status, JsonBool) == false || strcmp(json_status->string, "true") != 0) {
-            return false;
-        }
+    *delimiter  = '\0';
+    self->begin = (delimiter + 2) - self->data;
 
-        return true;
+    /*
+     * everything is processed, so the next read can start from the 
+     * beginning without moving of data
+     */
+    if(self->begin == self->end) {
+        self->begin = self->end = 0;
     }
+
+    self->scan = self->begin;
+
+    return frame;
 }
 
 
-static Json * extract_return_data(Json * json) {
-    /*
-     * cut off the returnData 
-     */
-    Json * return_data = json_lookup(json, "returnData");
+static void xtb_buffer_delete(XTB_Buffer * self) {
+    free(self->data);
+    *self = (XTB_Buffer) {0};
+}
 
-    json_object_set(json, "returnData", NULL);
-    json_delete(json);
 
-    return return_data;
+static inline int64_t xtb_clock_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 }
 
 
-#define CMD_BUFFER_SIZE 1024
+static inline int64_t xtb_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
 
+    return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 
-struct XTB_StreamClient {
-    XTB_Api api;
-    char * stream_session_id;
 
-    StreamClientCallback callback;
-    void * param;
+/*
+ * one TLS context is shared by all main and stream connections, the context is
+ * created together with initialization of OpenSSL at the first connect
+ */
+static pthread_once_t xtb_tls_once = PTHREAD_ONCE_INIT;
+static SSL_CTX * xtb_tls_ctx = NULL;
 
-    char cmd_buffer[CMD_BUFFER_SIZE];
 
-    XTB_StreamClient * prev;
-    XTB_StreamClient * next;
-};
+/*
+ * the last session ticket received from every server is kept, so following 
+ * connections to the same address resume the session instead of full handshake
+ */
+#define XTB_TLS_SESSION_CACHE_SIZE 8
 
 
-struct XTB_Client {
-    XTB_Api api;
-    XTB_AccountMode mode;
+typedef struct {
+    char * url;
+    SSL_SESSION * session;
+}XTB_TlsSession;
 
-    char * id;
-    char * password;
-    char * stream_session_id;
 
-    char cmd_buffer[CMD_BUFFER_SIZE];
+static struct {
+    pthread_mutex_t mutex;
+    size_t size;
+    XTB_TlsSession entry[XTB_TLS_SESSION_CACHE_SIZE];
+} xtb_tls_session_cache = {.mutex = PTHREAD_MUTEX_INITIALIZER};
 
-    XTB_StreamClient * stream_client;
-};
 
+static int xtb_tls_new_session(SSL * ssl, SSL_SESSION * session) {
+    const char * url = SSL_get_app_data(ssl);
+    int stored = 0;
 
-static void xtb_client_logout(XTB_Client * self) {
-    if(self->stream_session_id != NULL) {
-        Json * json_logout = xtb_api_transaction(&self->api, "{\"command\": \"logout\"}");
-     
-        if(read_status(json_logout) == false)
-            __assert("logout error\n");
+    if(url == NULL) {
+        return 0;
+    }
 
-        json_delete(json_logout);   
+    pthread_mutex_lock(&xtb_tls_session_cache.mutex);
 
-        free(self->stream_session_id);
-        self->stream_session_id = NULL;
+    for(size_t i = 0; i < xtb_tls_session_cache.size; i++) {
+        if(strcmp(xtb_tls_session_cache.entry[i].url, url) == 0) {
+            SSL_SESSION_free(xtb_tls_session_cache.entry[i].session);
+            xtb_tls_session_cache.entry[i].session = session;
+            stored = 1;
+            break;
+        }
     }
-}
 
+    if(stored == 0 && xtb_tls_session_cache.size < XTB_TLS_SESSION_CACHE_SIZE) {
+        char * copy = strdup(url);
 
-static inline Json * xtb_client_send_login(XTB_Client * self, char * id, char * password) {
-    snprintf(
-        self->cmd_buffer
-        , CMD_BUFFER_SIZE
-        , "{\"command\": \"login\", \"arguments\": {\"userId\": \"%s\", \"password\": \"%s\"}}"
-        , id, password);
+        if(copy != NULL) {
+            xtb_tls_session_cache.entry[xtb_tls_session_cache.size++] = (XTB_TlsSession) {
+                .url = copy
+                , .session = session
+            };
 
-    return xtb_api_transaction(&self->api, self->cmd_buffer); 
-}
+            stored = 1;
+        }
+    }
 
+    pthread_mutex_unlock(&xtb_tls_session_cache.mutex);
 
-static bool xtb_client_login(XTB_Client * self, char * id, char * password) {
     /*
-     * attempt to login is done only if the status is not logged
-     * otherwise is only returned true result, because user is already logged
+     * returning 1 takes over the reference to session
      */
-    if(self->stream_session_id == NULL) {
-        Json * result = xtb_client_send_login(self, id, password);
+    return stored;
+}
 
-        if(read_status(result) == false) {
-            json_delete(result);
-            return false;
-        }
 
-        if(json_is_type(json_lookup(result, "streamSessionId"), JsonString) == true) 
-            self->stream_session_id = strdup(json_lookup(result, "streamSessionId")->string);
+static void xtb_tls_resume_session(SSL * ssl, const char * url) {
+    pthread_mutex_lock(&xtb_tls_session_cache.mutex);
 
-        json_delete(result);    
+    for(size_t i = 0; i < xtb_tls_session_cache.size; i++) {
+        if(strcmp(xtb_tls_session_cache.entry[i].url, url) == 0) {
+            if(SSL_SESSION_is_resumable(xtb_tls_session_cache.entry[i].session) == 1) {
+                SSL_set_session(ssl, xtb_tls_session_cache.entry[i].session);
+            }
+
+            break;
+        }
     }
 
-    return true;
+    pthread_mutex_unlock(&xtb_tls_session_cache.mutex);
 }
 
 
-#define XTB_API_SOCKET_PORT_DEMO "5124"
-#define XTB_API_SOCKET_PORT_REAL "5112"
+static void xtb_tls_init(void) {
+    OPENSSL_init_ssl(OPENSSL_INIT_LOAD_SSL_STRINGS | OPENSSL_INIT_LOAD_CRYPTO_STRINGS, NULL);
 
-#define XTB_API_SOCKET_PORT_DEMO_STREAM "5125"
-#define XTB_API_SOCKET_PORT_REAL_STREAM "5113"
+    if((xtb_tls_ctx = SSL_CTX_new(TLS_client_method())) == NULL) {
+        __assert("TLS context create error\n");
+        return;
+    }
 
-#define XTB_API_ADDRESS "xapi.xtb.com"
+    SSL_CTX_set_session_cache_mode(xtb_tls_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(xtb_tls_ctx, xtb_tls_new_session);
+}
 
 
-#define XTB_API_MAIN_URL(mode)                                                          \
-    ((mode) == XTB_AccountMode_Real ? XTB_API_ADDRESS ":" XTB_API_SOCKET_PORT_REAL:     \
-                                    XTB_API_ADDRESS ":" XTB_API_SOCKET_PORT_DEMO)
+typedef struct {
+    SSL     * ssl;
+    BIO     * bio;
+    int       fd;
+    char    * url;
 
+    XTB_Buffer rcv;
 
-#define XTB_API_STREAM_URL(mode)                                                                \
-    ((mode) == XTB_AccountMode_Real ? XTB_API_ADDRESS ":" XTB_API_SOCKET_PORT_REAL_STREAM:      \
-                                    XTB_API_ADDRESS ":" XTB_API_SOCKET_PORT_DEMO_STREAM)
+    XTB_EventLoop * loop;
+}XTB_Api;
 
 
-XTB_Client * xtb_client_new(XTB_AccountMode mode, char * id, char * password) {
-	XTB_Client * self = malloc(sizeof(XTB_Client));
-    const char * url = XTB_API_MAIN_URL(mode);
+static void xtb_event_loop_unregister(XTB_EventLoop * self, XTB_Api * api);
+static void xtb_event_loop_detach(XTB_EventLoop * self, XTB_Api * api);
+static bool xtb_event_loop_attach(XTB_EventLoop * self, XTB_Api * api);
 
-	/*
-	 * initializing of OpenSSL library
-	 */
-    if(xtb_api_connect(&self->api, url) == false) {
-        xtb_client_delete(self);
-        return NULL;
-    }
 
-	if(xtb_client_login(self, id, password) == false) {
-		__assert("Login was not successfull\n");
-	}
+static bool xtb_api_connect(XTB_Api * self, const char * url) {
+    pthread_once(&xtb_tls_once, xtb_tls_init);
 
-    self->mode     = mode;
-    self->id       = strdup(id);
-    self->password = strdup(password);
+    self->rcv  = (XTB_Buffer) {0};
+    self->loop = NULL;
+    self->bio  = NULL;
+    self->url  = NULL;
 
-    return self;
-}
+    /*
+     * session tickets are received after handshake, so the address used as 
+     * key of session cache has to live as long as the connection
+     */
+    if(xtb_tls_ctx == NULL || (self->url = strdup(url)) == NULL) {
+        return false;
+    }
 
+	if((self->bio = BIO_new_ssl_connect(xtb_tls_ctx)) == NULL)  {
+        free(self->url);
+        self->url = NULL;
 
-bool xtb_client_logged(XTB_Client * self) {
-    return self->stream_session_id != NULL; 
-}
+        return false;
+	}
 
+    BIO_set_conn_hostname(self->bio, url);
+	BIO_set_conn_mode(self->bio, BIO_SOCK_NODELAY);
 
-size_t xtb_client_stream_session_size(XTB_Client * self) {
-    XTB_StreamClient * stream_client = self->stream_client;
-    size_t size = 0;
-    
-    while(stream_client != NULL) {
-        stream_client = stream_client->next;
-        size++;
-    }
+	BIO_get_ssl(self->bio, &self->ssl);
+	SSL_set_mode(self->ssl, SSL_MODE_AUTO_RETRY);
+    SSL_set_app_data(self->ssl, self->url);
+    xtb_tls_resume_session(self->ssl, self->url);
 
-    return size;
-}
+	if (BIO_do_connect(self->bio) <= 0) { 
+	    BIO_free_all(self->bio);
+        free(self->url);
 
+        self->bio = NULL;
+        self->url = NULL;
 
-bool xtb_client_ping(XTB_Client * self) {
-    Json * result = xtb_api_transaction(&self->api, "{\"command\": \"ping\"}");
-    
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
         return false;
-    }
+  	}
 
-    json_delete(result);
+    /*
+     * the socket is switched to non-blocking mode after handshake, so the 
+     * connection can be driven by event loop, blocking calls wait by poll
+     */
+    BIO_get_fd(self->bio, &self->fd);
+    fcntl(self->fd, F_SETFL, fcntl(self->fd, F_GETFL) | O_NONBLOCK);
 
     return true;
 }
 
 
-Json * xtb_client_get_all_symbols(XTB_Client * self) {
-    Json * result = xtb_api_transaction(&self->api, "{\"command\": \"getAllSymbols\"}");
-    
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
+static void xtb_api_close(XTB_Api * self) {
+    if(self->loop != NULL) {
+        xtb_event_loop_unregister(self->loop, self);
     }
 
-    return extract_return_data(result);
+    BIO_free_all(self->bio);
+    xtb_buffer_delete(&self->rcv);
+
+    free(self->url);
+    self->url = NULL;
+    self->bio = NULL;
 }
 
 
-Json * xtb_client_get_calendar(XTB_Client * self) {
-    Json * result = xtb_api_transaction(&self->api, "{\"command\": \"getCalendar\"}");
+static bool xtb_api_wait(XTB_Api * self, short events, int timeout) {
+    struct pollfd pfd = {.fd = self->fd, .events = events};
+    int result;
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
-    }
+    while((result = poll(&pfd, 1, timeout)) < 0 && errno == EINTR);
 
-    return extract_return_data(result);
+    return result > 0;
 }
 
 
-static Json * xtb_client_send_get_chart_last_request(
-        XTB_Client * self, char * symbol, XTB_Period period, time_t start) {
-    snprintf(
-        self->cmd_buffer
-        , CMD_BUFFER_SIZE
-        , "{\"command\": \"getChartLastRequest\", \"arguments\":"
-          "{\"info\": {\"period\": %d, \"start\": %ld, \"symbol\": \"%s\"}}}"
-        , period
-        , start
-        , symbol);
-
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
-}
+/*
+ * returns number of received bytes, 0 if there is nothing to read yet
+ * and -1 if the connection failed
+ */
+static int xtb_api_read(XTB_Api * self) {
+    if(xtb_buffer_reserve(&self->rcv, XTB_BUFFER_READ_SIZE) == false) {
+        __assert("receive buffer allocation error\n");
+        return -1;
+    }
 
+    int length = SSL_read(
+                    self->ssl
+                    , self->rcv.data + self->rcv.end
+                    , self->rcv.capacity - self->rcv.end - 1);
 
-Json * xtb_client_get_chart_last_request(XTB_Client * self, char * symbol, XTB_Period period, time_t start) {
-    Json * result = xtb_client_send_get_chart_last_request(self, symbol, period / 60, start * 1000);
+    if(length > 0) {
+        self->rcv.end += length;
+        return length;
+    }
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
+    switch(SSL_get_error(self->ssl, length)) {
+        case SSL_ERROR_WANT_READ:
+        case SSL_ERROR_WANT_WRITE:
+            return 0;
+        default:
+            return -1;
     }
-    
-    return extract_return_data(result);
 }
 
 
-static Json * xtb_client_send_get_chart_range_request(
-        XTB_Client * self, char * symbol, XTB_Period period, time_t start, time_t end, int32_t tick) {
-    snprintf(
-        self->cmd_buffer
-        , CMD_BUFFER_SIZE
-        , "{\"command\": \"getChartRangeRequest\", \"arguments\":"
-          "{\"info\": {\"end\": %ld, \"period\": %d, \"start\": %ld, \"symbol\": \"%s\", \"ticks\": %d}}}"
-        , end, period, start, symbol, tick);
+/*
+ * returned message points into receive buffer of the connection and it is 
+ * valid only until next call of the receive function, NULL is returned also 
+ * when nothing is received within timeout
+ */
+static char * xtb_api_receive(XTB_Api * self, int timeout) {
+    char * frame;
 
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
+    while((frame = xtb_buffer_next_frame(&self->rcv)) == NULL) {
+        int length = xtb_api_read(self);
+
+        if(length < 0 || (length == 0 && xtb_api_wait(self, POLLIN, timeout) == false)) {
+            __assert("receive error\n");
+            return NULL;
+        }
+    }
+
+    return frame;
 }
 
 
-Json * xtb_client_get_chart_range_request(
-        XTB_Client * self, char * symbol, XTB_Period period, time_t start, time_t end, int32_t tick) {
-    Json * json_chart = xtb_client_send_get_chart_range_request(self, symbol, period / 60, start * 1000, end * 1000, tick);
+/*
+ * reads all data available on the connection without blocking and passes every
+ * complete message into the handler, returns false if the connection failed
+ */
+static bool xtb_api_drain(XTB_Api * self, void (*handler)(void *, char *), void * param) {
+    while(true) {
+        char * frame;
 
-    if(read_status(json_chart) == false) {
-        __assert("command failed\n");
-        json_delete(json_chart);
+        while((frame = xtb_buffer_next_frame(&self->rcv)) != NULL) {
+            handler(param, frame);
+        }
+
+        int length = xtb_api_read(self);
+
+        if(length == 0) {
+            return true;
+        } else if(length < 0) {
+            return false;
+        }
+    }
+}
+
+
+static bool xtb_api_send(XTB_Api * self, const char * msg) {
+    int length = strlen(msg);
+
+    while(true) {
+        int result = SSL_write(self->ssl, msg, length);
+
+        if(result > 0) {
+            return true;
+        }
+
+        switch(SSL_get_error(self->ssl, result)) {
+            case SSL_ERROR_WANT_WRITE:
+                if(xtb_api_wait(self, POLLOUT, -1) == true) 
+                    continue;
+                break;
+            case SSL_ERROR_WANT_READ:
+                if(xtb_api_wait(self, POLLIN, -1) == true) 
+                    continue;
+                break;
+            default:
+                break;
+        }
+
+        __assert("write command error\n");
+        return false;
+    }
+}
+
+
+static bool read_status(Json * json) {
+    if(json == NULL) {
+        return false;
+    } else {
+        Json * json_status = json_lookup(json, "status");
+
+        if(json_is_type(json_status, JsonBool) == false || strcmp(json_status->string, "true") != 0) {
+            return false;
+        }
+
+        return true;
+    }
+}
+
+
+static Json * extract_return_data(Json * json) {
+    /*
+     * cut off the returnData 
+     */
+    Json * return_data = json_lookup(json, "returnData");
+
+    json_object_set(json, "returnData", NULL);
+    json_delete(json);
+
+    return return_data;
+}
+
+
+/*
+ * symbols are interned into dense ids, names are never released, so the name of id and the index
+ * are read without lock and only inserting of new symbol is serialized
+ */
+#define XTB_SYMBOL_INDEX_SIZE (XTB_SYMBOL_ID_CAPACITY * 2)
+
+
+static struct {
+    pthread_mutex_t mutex;
+    _Atomic uint32_t size;
+    _Atomic uint32_t index[XTB_SYMBOL_INDEX_SIZE];
+    char name[XTB_SYMBOL_ID_CAPACITY][XTB_SYMBOL_SIZE];
+}xtb_symbols = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+
+
+static uint32_t xtb_symbol_hash(const char * symbol) {
+    uint32_t hash = 2166136261u;
+
+    while(*symbol != '\0') {
+        hash = (hash ^ (uint8_t) *symbol++) * 16777619u;
+    }
+
+    return hash;
+}
+
+
+/*
+ * index keeps id + 1, so zero is empty entry
+ */
+static _Atomic uint32_t * xtb_symbol_entry(const char * symbol, uint32_t * entry) {
+    size_t index = xtb_symbol_hash(symbol) & (XTB_SYMBOL_INDEX_SIZE - 1);
+
+    while((*entry = atomic_load_explicit(&xtb_symbols.index[index], memory_order_acquire)) != 0
+            && strcmp(xtb_symbols.name[*entry - 1], symbol) != 0) {
+        index = (index + 1) & (XTB_SYMBOL_INDEX_SIZE - 1);
+    }
+
+    return &xtb_symbols.index[index];
+}
+
+
+XTB_SymbolId xtb_symbol_find(const char * symbol) {
+    uint32_t entry;
+
+    xtb_symbol_entry(symbol, &entry);
+
+    return entry != 0 ? entry - 1 : XTB_SYMBOL_NONE;
+}
+
+
+XTB_SymbolId xtb_symbol_intern(const char * symbol) {
+    XTB_SymbolId id = xtb_symbol_find(symbol);
+
+    if(id != XTB_SYMBOL_NONE || strlen(symbol) >= XTB_SYMBOL_SIZE) {
+        return id;
+    }
+
+    pthread_mutex_lock(&xtb_symbols.mutex);
+
+    uint32_t entry;
+    _Atomic uint32_t * index = xtb_symbol_entry(symbol, &entry);
+
+    if(entry != 0) {
+        id = entry - 1;
+    } else if((id = atomic_load_explicit(&xtb_symbols.size, memory_order_relaxed)) < XTB_SYMBOL_ID_CAPACITY) {
+        strcpy(xtb_symbols.name[id], symbol);
+
+        atomic_store_explicit(&xtb_symbols.size, id + 1, memory_order_release);
+        atomic_store_explicit(index, id + 1, memory_order_release);
+    } else {
+        __assert("symbol table is full\n");
+        id = XTB_SYMBOL_NONE;
+    }
+
+    pthread_mutex_unlock(&xtb_symbols.mutex);
+
+    return id;
+}
+
+
+const char * xtb_symbol_name(XTB_SymbolId id) {
+    return id < atomic_load_explicit(&xtb_symbols.size, memory_order_acquire) ? xtb_symbols.name[id] : NULL;
+}
+
+
+size_t xtb_symbol_count(void) {
+    return atomic_load_explicit(&xtb_symbols.size, memory_order_acquire);
+}
+
+
+/*
+ * the newest quote of every symbol and level received by stream clients, quotes are
+ * written by stream threads and read from any thread through sequence lock
+ */
+#define XTB_QUOTE_EMPTY 0
+#define XTB_QUOTE_CLAIMED 1
+#define XTB_QUOTE_READY 2
+
+
+typedef struct {
+    _Alignas(64) _Atomic uint32_t seq;
+    _Atomic uint32_t state;
+    XTB_Quote quote;
+}XTB_QuoteSlot;
+
+
+/*
+ * slots of the top level are also indexed by symbol id
+ */
+typedef struct {
+    size_t mask;
+    XTB_QuoteSlot * slot;
+    XTB_QuoteSlot * _Atomic * top;
+}XTB_QuoteTable;
+
+
+static XTB_QuoteTable * xtb_quote_table_new(size_t capacity) {
+    size_t size = 1;
+
+    while(size < capacity) {
+        size <<= 1;
+    }
+
+    XTB_QuoteTable * self      = malloc(sizeof(XTB_QuoteTable));
+    XTB_QuoteSlot * slot       = aligned_alloc(64, sizeof(XTB_QuoteSlot) * size);
+    XTB_QuoteSlot * _Atomic * top = calloc(XTB_SYMBOL_ID_CAPACITY, sizeof(XTB_QuoteSlot *));
+
+    if(self == NULL || slot == NULL || top == NULL) {
+        free(self);
+        free(slot);
+        free(top);
         return NULL;
     }
-    
-    return extract_return_data(json_chart);
+
+    memset(slot, 0, sizeof(XTB_QuoteSlot) * size);
+
+    *self = (XTB_QuoteTable) {
+        .mask = size - 1
+        , .slot = slot
+        , .top = top
+    };
+
+    return self;
 }
 
 
-static Json * build_candle_record(Json * json_record, int digits) {
+static void xtb_quote_table_delete(XTB_QuoteTable * self) {
+    if(self != NULL) {
+        free(self->slot);
+        free(self->top);
+        free(self);
+    }
+}
+
+
+static uint32_t xtb_quote_hash(const char * symbol, int level) {
+    return (xtb_symbol_hash(symbol) ^ (uint32_t) level) * 16777619u;
+}
+
+
+/*
+ * slots are never released, so the symbol of ready slot doesn't change anymore
+ */
+static XTB_QuoteSlot * xtb_quote_table_find(XTB_QuoteTable * self, const char * symbol, int level, bool insert) {
+    uint32_t hash = xtb_quote_hash(symbol, level);
+
+    for(size_t i = 0; i <= self->mask; i++) {
+        XTB_QuoteSlot * slot = &self->slot[(hash + i) & self->mask];
+        uint32_t state       = atomic_load_explicit(&slot->state, memory_order_acquire);
+
+        if(state == XTB_QUOTE_EMPTY) {
+            if(insert == false) {
+                return NULL;
+            }
+
+            if(atomic_compare_exchange_strong(&slot->state, &state, XTB_QUOTE_CLAIMED) == true) {
+                snprintf(slot->quote.symbol, XTB_SYMBOL_SIZE, "%s", symbol);
+                slot->quote.level = level;
+                slot->quote.id    = xtb_symbol_intern(symbol);
+
+                atomic_store_explicit(&slot->state, XTB_QUOTE_READY, memory_order_release);
+
+                return slot;
+            }
+        }
+
+        while(state == XTB_QUOTE_CLAIMED) {
+            state = atomic_load_explicit(&slot->state, memory_order_acquire);
+        }
+
+        if(slot->quote.level == level && strcmp(slot->quote.symbol, symbol) == 0) {
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void xtb_quote_table_update(XTB_QuoteTable * self, const XTB_Tick * tick) {
+    XTB_QuoteSlot * slot = NULL;
+    bool top             = tick->level == 0 && tick->id < XTB_SYMBOL_ID_CAPACITY;
+
+    if(top == true) {
+        slot = atomic_load_explicit(&self->top[tick->id], memory_order_acquire);
+    }
+
+    if(slot == NULL && (slot = xtb_quote_table_find(self, tick->symbol, tick->level, true)) == NULL) {
+        __assert("quote table is full\n");
+        return;
+    }
+
+    if(top == true) {
+        atomic_store_explicit(&self->top[tick->id], slot, memory_order_release);
+    }
+
     /*
-     * getting record data
+     * more stream clients can write the same symbol, the writer owns the slot while
+     * the sequence is odd
      */
-    Json * json_open  = json_lookup(json_record, "open");
-    Json * json_close = json_lookup(json_record, "close");
-    Json * json_high  = json_lookup(json_record, "high");
-    Json * json_low   = json_lookup(json_record, "low");
-    Json * json_ctm   = json_lookup(json_record, "ctm");
-    Json * json_vol   = json_lookup(json_record, "vol");
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+
+    while((seq & 1) != 0 
+            || atomic_compare_exchange_weak_explicit(
+                    &slot->seq, &seq, seq + 1, memory_order_acquire, memory_order_relaxed) == false) {
+        seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    }
+
+    atomic_thread_fence(memory_order_release);
+
+    slot->quote.bid        = tick->bid;
+    slot->quote.ask        = tick->ask;
+    slot->quote.spread     = tick->spread_raw;
+    slot->quote.bid_volume = tick->bid_volume;
+    slot->quote.ask_volume = tick->ask_volume;
+    slot->quote.timestamp  = tick->timestamp;
+
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+}
+
+
+static bool xtb_quote_slot_read(XTB_QuoteSlot * slot, XTB_Quote * quote) {
+    uint32_t seq;
+
+    if(slot == NULL) {
+        return false;
+    }
+
+    do {
+        while(((seq = atomic_load_explicit(&slot->seq, memory_order_acquire)) & 1) != 0);
+
+        *quote = slot->quote;
+        atomic_thread_fence(memory_order_acquire);
+    } while(atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq);
+
+    return quote->timestamp != 0;
+}
+
+
+static bool xtb_quote_table_read(XTB_QuoteTable * self, const char * symbol, int level, XTB_Quote * quote) {
+    return xtb_quote_slot_read(xtb_quote_table_find(self, symbol, level, false), quote);
+}
+
+
+static bool xtb_quote_table_read_id(XTB_QuoteTable * self, XTB_SymbolId id, XTB_Quote * quote) {
+    return id < XTB_SYMBOL_ID_CAPACITY 
+                && xtb_quote_slot_read(atomic_load_explicit(&self->top[id], memory_order_acquire), quote);
+}
+
+
+/*
+ * tracked orders are matched with tradeStatus and trade stream messages by order number or 
+ * by position number once the order is opened, status of order can be received by stream
+ * before the response of tradeTransaction, so the last messages of not yet tracked orders 
+ * are kept and applied when the order is tracked
+ */
+#define XTB_ORDER_BUCKETS 256
+#define XTB_ORDER_UNMATCHED 64
+
+
+static inline int64_t xtb_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+typedef struct XTB_TrackedOrder {
+    uint64_t order;
+    uint64_t position;
+    XTB_OrderState state;
+    int64_t submitted;
+
+    XTB_OrderCallback callback;
+    void * param;
+
+    struct XTB_TrackedOrder * next;
+    struct XTB_TrackedOrder * next_position;
+}XTB_TrackedOrder;
+
+
+/*
+ * trade messages carry more order numbers, the update matches tracked order by any of them
+ */
+typedef struct {
+    uint64_t id[3];
+    uint64_t position;
+    XTB_OrderState state;
+    int64_t timestamp;
+    double price;
+}XTB_OrderUpdate;
+
+
+typedef struct {
+    XTB_OrderEvent event;
+    XTB_OrderCallback callback;
+    void * param;
+}XTB_OrderNotice;
+
+
+typedef struct {
+    pthread_mutex_t mutex;
+    XTB_TrackedOrder * bucket[XTB_ORDER_BUCKETS];
+    XTB_TrackedOrder * position[XTB_ORDER_BUCKETS];
+
+    XTB_OrderUpdate unmatched[XTB_ORDER_UNMATCHED];
+    size_t unmatched_next;
+
+    /*
+     * orders sent by the client are tracked automatically with default callback
+     */
+    XTB_OrderCallback callback;
+    void * param;
+}XTB_OrderTracker;
+
+
+static XTB_OrderTracker * xtb_order_tracker_new(void) {
+    XTB_OrderTracker * self = calloc(1, sizeof(XTB_OrderTracker));
+
+    if(self != NULL) {
+        pthread_mutex_init(&self->mutex, NULL);
+    }
+
+    return self;
+}
+
+
+static void xtb_order_tracker_delete(XTB_OrderTracker * self) {
+    if(self != NULL) {
+        for(size_t i = 0; i < XTB_ORDER_BUCKETS; i++) {
+            while(self->bucket[i] != NULL) {
+                XTB_TrackedOrder * next = self->bucket[i]->next;
+
+                free(self->bucket[i]);
+                self->bucket[i] = next;
+            }
+        }
+
+        pthread_mutex_destroy(&self->mutex);
+        free(self);
+    }
+}
+
+
+static XTB_TrackedOrder ** xtb_order_tracker_find(XTB_OrderTracker * self, uint64_t order) {
+    XTB_TrackedOrder ** it = &self->bucket[order % XTB_ORDER_BUCKETS];
+
+    while(*it != NULL && (*it)->order != order) {
+        it = &(*it)->next;
+    }
+
+    return it;
+}
+
+
+static XTB_TrackedOrder ** xtb_order_tracker_find_position(XTB_OrderTracker * self, uint64_t position) {
+    XTB_TrackedOrder ** it = &self->position[position % XTB_ORDER_BUCKETS];
+
+    while(*it != NULL && (*it)->position != position) {
+        it = &(*it)->next_position;
+    }
+
+    return it;
+}
+
+
+static void xtb_order_tracker_remove(XTB_OrderTracker * self, XTB_TrackedOrder * tracked) {
+    XTB_TrackedOrder ** it = &self->bucket[tracked->order % XTB_ORDER_BUCKETS];
+
+    while(*it != tracked) {
+        it = &(*it)->next;
+    }
+
+    *it = tracked->next;
+
+    if(tracked->position != 0) {
+        it = &self->position[tracked->position % XTB_ORDER_BUCKETS];
+
+        while(*it != tracked) {
+            it = &(*it)->next_position;
+        }
+
+        *it = tracked->next_position;
+    }
+
+    free(tracked);
+}
+
+
+/*
+ * state of order moves only forward, rejected and closed orders are released
+ */
+static inline bool xtb_order_state_final(XTB_OrderState state) {
+    return state == XTB_OrderState_Rejected || state == XTB_OrderState_Closed;
+}
+
+
+static bool xtb_order_tracker_apply(
+        XTB_OrderTracker * self, XTB_TrackedOrder * tracked, const XTB_OrderUpdate * update, XTB_OrderNotice * notice) {
+    if(update->state <= tracked->state) {
+        return false;
+    }
+
+    /*
+     * messages closing the position can carry only the position number
+     */
+    if(update->position != 0 && tracked->position == 0) {
+        XTB_TrackedOrder ** it = &self->position[update->position % XTB_ORDER_BUCKETS];
+
+        tracked->position      = update->position;
+        tracked->next_position = *it;
+        *it                    = tracked;
+    }
+
+    *notice = (XTB_OrderNotice) {
+        .event = {
+            .order = tracked->order
+            , .position = tracked->position
+            , .state = update->state
+            , .previous = tracked->state
+            , .submitted = tracked->submitted
+            , .timestamp = update->timestamp
+            , .price = update->price
+        }
+        , .callback = tracked->callback
+        , .param = tracked->param
+    };
+
+    tracked->state = update->state;
+
+    if(xtb_order_state_final(update->state) == true) {
+        xtb_order_tracker_remove(self, tracked);
+    }
+
+    return true;
+}
+
+
+/*
+ * callbacks are called outside of lock, so they can track new orders
+ */
+static void xtb_order_notice_send(const XTB_OrderNotice * notice) {
+    if(notice->callback != NULL) {
+        notice->callback(notice->param, &notice->event);
+    }
+}
+
+
+/*
+ * closing of position is reported to the order opening it and to the closing order,
+ * so the update is applied to every tracked order it matches
+ */
+static void xtb_order_tracker_update(XTB_OrderTracker * self, const XTB_OrderUpdate * update) {
+    XTB_OrderNotice notice[3];
+    size_t size = 0;
+    bool found  = false;
+
+    pthread_mutex_lock(&self->mutex);
+
+    for(size_t i = 0; i < 3; i++) {
+        XTB_TrackedOrder * tracked;
+
+        if(update->id[i] == 0) {
+            continue;
+        }
+
+        if((tracked = *xtb_order_tracker_find(self, update->id[i])) == NULL) {
+            tracked = *xtb_order_tracker_find_position(self, update->id[i]);
+        }
+
+        if(tracked != NULL) {
+            found = true;
+
+            if(xtb_order_tracker_apply(self, tracked, update, &notice[size]) == true) {
+                size++;
+            }
+        }
+    }
+
+    if(found == false) {
+        self->unmatched[self->unmatched_next++ % XTB_ORDER_UNMATCHED] = *update;
+    }
+
+    pthread_mutex_unlock(&self->mutex);
+
+    for(size_t i = 0; i < size; i++) {
+        xtb_order_notice_send(&notice[i]);
+    }
+}
+
+
+static void xtb_order_tracker_trade_status(XTB_OrderTracker * self, const XTB_TradeStatus * status) {
+    XTB_OrderUpdate update = {.id = {status->order}, .timestamp = xtb_clock_ns(), .price = status->price};
+
+    switch(status->request_status) {
+        case XTB_RequestStatus_ACCEPTED: update.state = XTB_OrderState_Accepted; break;
+        case XTB_RequestStatus_REJECTED: 
+        case XTB_RequestStatus_ERROR: update.state = XTB_OrderState_Rejected; break;
+        default: return;
+    }
+
+    xtb_order_tracker_update(self, &update);
+}
+
+
+static void xtb_order_tracker_trade(XTB_OrderTracker * self, const XTB_TradeRecord * trade) {
+    XTB_OrderUpdate update = {
+        .id = {trade->order2, trade->order, trade->position}
+        , .position = trade->position
+        , .timestamp = xtb_clock_ns()
+        , .price = trade->closed == true ? trade->close_price : trade->open_price
+        , .state = trade->closed == true ? XTB_OrderState_Closed : XTB_OrderState_Opened
+    };
+
+    /*
+     * pending orders aren't opened positions yet
+     */
+    if(trade->closed == false && trade->cmd != XTB_TransMode_BUY && trade->cmd != XTB_TransMode_SELL) {
+        return;
+    }
+
+    xtb_order_tracker_update(self, &update);
+}
+
+
+static bool xtb_order_tracker_match(const XTB_OrderUpdate * update, const XTB_TrackedOrder * tracked) {
+    for(size_t i = 0; i < 3; i++) {
+        if(update->id[i] != 0 && (update->id[i] == tracked->order || update->id[i] == tracked->position)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+static bool xtb_order_tracker_track(
+        XTB_OrderTracker * self, uint64_t order, int64_t submitted, XTB_OrderCallback callback, void * param) {
+    XTB_OrderNotice notice[XTB_ORDER_UNMATCHED];
+    size_t size = 0;
+
+    pthread_mutex_lock(&self->mutex);
+
+    XTB_TrackedOrder ** it = xtb_order_tracker_find(self, order);
+
+    /*
+     * order already tracked automatically gets the callback of the caller
+     */
+    if(*it != NULL) {
+        (*it)->callback = callback;
+        (*it)->param    = param;
+
+        if(submitted != 0) {
+            (*it)->submitted = submitted;
+        }
+
+        pthread_mutex_unlock(&self->mutex);
+        return true;
+    }
+
+    XTB_TrackedOrder * tracked = malloc(sizeof(XTB_TrackedOrder));
+
+    if(tracked == NULL) {
+        pthread_mutex_unlock(&self->mutex);
+        return false;
+    }
+
+    *tracked = (XTB_TrackedOrder) {
+        .order = order
+        , .state = XTB_OrderState_Pending
+        , .submitted = submitted != 0 ? submitted : xtb_clock_ns()
+        , .callback = callback
+        , .param = param
+    };
+
+    *it = tracked;
+
+    /*
+     * messages received before the order was tracked are applied in order of receiving
+     */
+    size_t begin = self->unmatched_next > XTB_ORDER_UNMATCHED ? self->unmatched_next - XTB_ORDER_UNMATCHED : 0;
+
+    for(size_t i = begin; i < self->unmatched_next; i++) {
+        XTB_OrderUpdate * update = &self->unmatched[i % XTB_ORDER_UNMATCHED];
+
+        if(xtb_order_tracker_match(update, tracked) == true 
+                && xtb_order_tracker_apply(self, tracked, update, &notice[size]) == true) {
+            if(xtb_order_state_final(notice[size++].event.state) == true) {
+                break;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&self->mutex);
+
+    for(size_t i = 0; i < size; i++) {
+        xtb_order_notice_send(&notice[i]);
+    }
+
+    return true;
+}
+
+
+/*
+ * open positions indexed by position number and by symbol, the book is changed by threads 
+ * processing stream and read by copying of positions under lock, so readers get consistent 
+ * snapshot and never see half updated position
+ */
+#define XTB_POSITION_BUCKETS 256
+#define XTB_POSITION_SYMBOL_BUCKETS 64
+
+
+typedef struct XTB_PositionEntry {
+    XTB_TradeRecord trade;
+
+    struct XTB_PositionEntry * next;
+    struct XTB_PositionEntry * next_symbol;
+}XTB_PositionEntry;
+
+
+typedef struct {
+    pthread_mutex_t mutex;
+    size_t size;
+
+    XTB_PositionEntry * bucket[XTB_POSITION_BUCKETS];
+    XTB_PositionEntry * symbol[XTB_POSITION_SYMBOL_BUCKETS];
+}XTB_PositionBook;
+
+
+static XTB_PositionBook * xtb_position_book_new(void) {
+    XTB_PositionBook * self = calloc(1, sizeof(XTB_PositionBook));
+
+    if(self != NULL) {
+        pthread_mutex_init(&self->mutex, NULL);
+    }
+
+    return self;
+}
+
+
+static void xtb_position_book_clear(XTB_PositionBook * self) {
+    for(size_t i = 0; i < XTB_POSITION_BUCKETS; i++) {
+        while(self->bucket[i] != NULL) {
+            XTB_PositionEntry * next = self->bucket[i]->next;
+
+            free(self->bucket[i]);
+            self->bucket[i] = next;
+        }
+    }
+
+    memset(self->symbol, 0, sizeof(self->symbol));
+    self->size = 0;
+}
+
+
+static void xtb_position_book_delete(XTB_PositionBook * self) {
+    if(self != NULL) {
+        xtb_position_book_clear(self);
+        pthread_mutex_destroy(&self->mutex);
+        free(self);
+    }
+}
+
+
+static XTB_PositionEntry ** xtb_position_book_find(XTB_PositionBook * self, uint64_t position) {
+    XTB_PositionEntry ** it = &self->bucket[position % XTB_POSITION_BUCKETS];
+
+    while(*it != NULL && (uint64_t) (*it)->trade.position != position) {
+        it = &(*it)->next;
+    }
+
+    return it;
+}
+
+
+static XTB_PositionEntry ** xtb_position_book_symbol(XTB_PositionBook * self, const char * symbol) {
+    return &self->symbol[xtb_quote_hash(symbol, 0) % XTB_POSITION_SYMBOL_BUCKETS];
+}
+
+
+static void xtb_position_book_unlink_symbol(XTB_PositionBook * self, XTB_PositionEntry * entry) {
+    XTB_PositionEntry ** it = xtb_position_book_symbol(self, entry->trade.symbol);
+
+    while(*it != entry) {
+        it = &(*it)->next_symbol;
+    }
+
+    *it = entry->next_symbol;
+}
+
+
+static void xtb_position_book_link_symbol(XTB_PositionBook * self, XTB_PositionEntry * entry) {
+    XTB_PositionEntry ** it = xtb_position_book_symbol(self, entry->trade.symbol);
+
+    entry->next_symbol = *it;
+    *it                = entry;
+}
+
+
+static void xtb_position_book_put(XTB_PositionBook * self, const XTB_TradeRecord * trade) {
+    XTB_PositionEntry ** it = xtb_position_book_find(self, trade->position);
+
+    if(*it == NULL) {
+        if((*it = malloc(sizeof(XTB_PositionEntry))) == NULL) {
+            __assert("out of memory\n");
+            return;
+        }
+
+        **it = (XTB_PositionEntry) {.trade = *trade};
+        xtb_position_book_link_symbol(self, *it);
+        self->size++;
+    } else if(strcmp((*it)->trade.symbol, trade->symbol) != 0) {
+        xtb_position_book_unlink_symbol(self, *it);
+        (*it)->trade = *trade;
+        xtb_position_book_link_symbol(self, *it);
+    } else {
+        (*it)->trade = *trade;
+    }
+}
+
+
+static void xtb_position_book_remove(XTB_PositionBook * self, uint64_t position) {
+    XTB_PositionEntry ** it = xtb_position_book_find(self, position);
+
+    if(*it != NULL) {
+        XTB_PositionEntry * entry = *it;
+
+        xtb_position_book_unlink_symbol(self, entry);
+        *it = entry->next;
+        free(entry);
+        self->size--;
+    }
+}
+
+
+/*
+ * trade message carries the whole record, closed and deleted records leave the book
+ */
+static void xtb_position_book_trade(XTB_PositionBook * self, const XTB_TradeRecord * trade) {
+    pthread_mutex_lock(&self->mutex);
+
+    if(trade->closed == true || strcmp(trade->state, "Deleted") == 0) {
+        xtb_position_book_remove(self, trade->position);
+    } else {
+        xtb_position_book_put(self, trade);
+    }
+
+    pthread_mutex_unlock(&self->mutex);
+}
+
+
+static void xtb_position_book_profit(XTB_PositionBook * self, const XTB_Profit * profit) {
+    pthread_mutex_lock(&self->mutex);
+
+    XTB_PositionEntry * entry = *xtb_position_book_find(self, profit->position);
+
+    if(entry != NULL) {
+        entry->trade.profit = profit->profit;
+    }
+
+    pthread_mutex_unlock(&self->mutex);
+}
+
+
+static void xtb_position_book_reset(XTB_PositionBook * self, const XTB_TradeRecord * trade, size_t size) {
+    pthread_mutex_lock(&self->mutex);
+
+    xtb_position_book_clear(self);
+
+    for(size_t i = 0; i < size; i++) {
+        xtb_position_book_put(self, &trade[i]);
+    }
+
+    pthread_mutex_unlock(&self->mutex);
+}
+
+
+static bool xtb_position_book_get(XTB_PositionBook * self, uint64_t position, XTB_TradeRecord * trade) {
+    pthread_mutex_lock(&self->mutex);
+
+    XTB_PositionEntry * entry = *xtb_position_book_find(self, position);
+
+    if(entry != NULL) {
+        *trade = entry->trade;
+    }
+
+    pthread_mutex_unlock(&self->mutex);
+
+    return entry != NULL;
+}
+
+
+/*
+ * returns number of matching positions, only the first size of them are copied
+ */
+static size_t xtb_position_book_copy(
+        XTB_PositionBook * self, const char * symbol, XTB_TradeRecord * buffer, size_t size) {
+    size_t count = 0;
+
+    pthread_mutex_lock(&self->mutex);
+
+    if(symbol != NULL) {
+        for(XTB_PositionEntry * it = *xtb_position_book_symbol(self, symbol); it != NULL; it = it->next_symbol) {
+            if(strcmp(it->trade.symbol, symbol) == 0 && count++ < size) {
+                buffer[count - 1] = it->trade;
+            }
+        }
+    } else {
+        for(size_t i = 0; i < XTB_POSITION_BUCKETS; i++) {
+            for(XTB_PositionEntry * it = self->bucket[i]; it != NULL; it = it->next) {
+                if(count++ < size) {
+                    buffer[count - 1] = it->trade;
+                }
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&self->mutex);
+
+    return count;
+}
+
+
+/*
+ * trading sessions of symbol sorted by day and from the latest session of day
+ */
+#define XTB_TRADING_SEGMENTS 32
+
+
+typedef struct {
+    int day;
+    int64_t from;
+    int64_t to;
+}XTB_TradingSegment;
+
+
+typedef struct XTB_TradingHours {
+    char symbol[XTB_SYMBOL_SIZE];
+    size_t size;
+    XTB_TradingSegment segment[XTB_TRADING_SEGMENTS];
+
+    struct XTB_TradingHours * next;
+}XTB_TradingHours;
+
+
+/*
+ * specifications of symbols loaded by getSymbol or getAllSymbols, they are used for local 
+ * calculation of profit and margin, table is growing and protected by lock
+ */
+typedef struct XTB_SymbolCache {
+    pthread_mutex_t mutex;
+    size_t mask;
+    size_t size;
+    XTB_SymbolSpec * slot;
+
+    char currency[XTB_CURRENCY_SIZE];
+
+    char * path;
+    pthread_t refresh;
+    bool refreshing;
+
+    struct XTB_TradingHours * hours;
+}XTB_SymbolCache;
+
+
+static XTB_SymbolCache * xtb_symbol_cache_new(size_t capacity) {
+    XTB_SymbolCache * self = malloc(sizeof(XTB_SymbolCache));
+    XTB_SymbolSpec * slot  = calloc(capacity, sizeof(XTB_SymbolSpec));
+
+    if(self == NULL || slot == NULL) {
+        free(self);
+        free(slot);
+        return NULL;
+    }
+
+    *self = (XTB_SymbolCache) {
+        .mask = capacity - 1
+        , .slot = slot
+    };
+
+    pthread_mutex_init(&self->mutex, NULL);
+
+    return self;
+}
+
+
+static void xtb_symbol_cache_delete(XTB_SymbolCache * self) {
+    if(self != NULL) {
+        while(self->hours != NULL) {
+            XTB_TradingHours * next = self->hours->next;
+
+            free(self->hours);
+            self->hours = next;
+        }
+
+        pthread_mutex_destroy(&self->mutex);
+        free(self->slot);
+        free(self->path);
+        free(self);
+    }
+}
+
+
+/*
+ * empty slot has empty symbol, returns matching or empty slot
+ */
+static XTB_SymbolSpec * xtb_symbol_cache_slot(XTB_SymbolCache * self, const char * symbol) {
+    size_t index = xtb_quote_hash(symbol, 0) & self->mask;
+
+    while(self->slot[index].symbol[0] != '\0' && strcmp(self->slot[index].symbol, symbol) != 0) {
+        index = (index + 1) & self->mask;
+    }
+
+    return &self->slot[index];
+}
+
+
+static const XTB_SymbolSpec * xtb_symbol_cache_find(XTB_SymbolCache * self, const char * symbol) {
+    XTB_SymbolSpec * spec = xtb_symbol_cache_slot(self, symbol);
+    return spec->symbol[0] != '\0' ? spec : NULL;
+}
+
+
+static bool xtb_symbol_cache_grow(XTB_SymbolCache * self) {
+    XTB_SymbolSpec * slot = self->slot;
+    size_t size           = self->mask + 1;
+
+    if((self->slot = calloc(size * 2, sizeof(XTB_SymbolSpec))) == NULL) {
+        self->slot = slot;
+        return false;
+    }
+
+    self->mask = size * 2 - 1;
+
+    for(size_t i = 0; i < size; i++) {
+        if(slot[i].symbol[0] != '\0') {
+            *xtb_symbol_cache_slot(self, slot[i].symbol) = slot[i];
+        }
+    }
+
+    free(slot);
+
+    return true;
+}
+
+
+static bool xtb_symbol_cache_put(XTB_SymbolCache * self, const XTB_SymbolSpec * spec) {
+    if(spec->symbol[0] == '\0' || ((self->size + 1) * 2 > self->mask + 1 && xtb_symbol_cache_grow(self) == false)) {
+        return false;
+    }
+
+    XTB_SymbolSpec * slot = xtb_symbol_cache_slot(self, spec->symbol);
+
+    if(slot->symbol[0] == '\0') {
+        self->size++;
+    }
+
+    *slot = *spec;
+
+    return true;
+}
+
+
+/*
+ * symbol catalog file is the header followed by the slots of cache, so it is loaded 
+ * by one copy without parsing and hashing of symbols again
+ */
+#define XTB_CATALOG_MAGIC 0x53425458u
+#define XTB_CATALOG_VERSION 1
+
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t record_size;
+    uint64_t capacity;
+    uint64_t size;
+    int64_t updated;
+    char currency[XTB_CURRENCY_SIZE];
+}XTB_CatalogHeader;
+
+
+/*
+ * catalog is written into temporary file at first and renamed, so readers never see half 
+ * written file, the cache has to be locked
+ */
+static bool xtb_symbol_cache_save(XTB_SymbolCache * self, const char * path, int64_t updated) {
+    char tmp_path[PATH_MAX];
+    size_t capacity = self->mask + 1;
+    size_t length   = sizeof(XTB_CatalogHeader) + capacity * sizeof(XTB_SymbolSpec);
+
+    if(snprintf(tmp_path, PATH_MAX, "%s.tmp", path) >= PATH_MAX) {
+        return false;
+    }
+
+    int fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if(fd < 0) {
+        return false;
+    }
+
+    uint8_t * map = MAP_FAILED;
+
+    if(ftruncate(fd, length) == 0) {
+        map = mmap(NULL, length, PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    if(map == MAP_FAILED) {
+        close(fd);
+        unlink(tmp_path);
+        return false;
+    }
+
+    XTB_CatalogHeader header = {
+        .magic = XTB_CATALOG_MAGIC
+        , .version = XTB_CATALOG_VERSION
+        , .record_size = sizeof(XTB_SymbolSpec)
+        , .capacity = capacity
+        , .size = self->size
+        , .updated = updated
+    };
+
+    memcpy(header.currency, self->currency, XTB_CURRENCY_SIZE);
+    memcpy(map, &header, sizeof(XTB_CatalogHeader));
+    memcpy(map + sizeof(XTB_CatalogHeader), self->slot, capacity * sizeof(XTB_SymbolSpec));
+
+    bool result = msync(map, length, MS_SYNC) == 0;
+
+    munmap(map, length);
+    close(fd);
+
+    if(result == false || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        return false;
+    }
+
+    return true;
+}
+
+
+/*
+ * returns time of the catalog update in unix ms, or -1 if the file is missing or invalid
+ */
+static int64_t xtb_symbol_cache_load(XTB_SymbolCache * self, const char * path) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+
+    if(fd < 0) {
+        return -1;
+    }
+
+    if(fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(XTB_CatalogHeader)) {
+        close(fd);
+        return -1;
+    }
+
+    const uint8_t * map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(map == MAP_FAILED) {
+        return -1;
+    }
+
+    XTB_CatalogHeader header;
+    XTB_SymbolSpec * slot = NULL;
+
+    memcpy(&header, map, sizeof(XTB_CatalogHeader));
+
+    if(header.magic == XTB_CATALOG_MAGIC
+            && header.version == XTB_CATALOG_VERSION
+            && header.record_size == sizeof(XTB_SymbolSpec)
+            && header.capacity > 0 && (header.capacity & (header.capacity - 1)) == 0
+            && header.size < header.capacity
+            && (size_t) st.st_size == sizeof(XTB_CatalogHeader) + header.capacity * sizeof(XTB_SymbolSpec)
+            && (slot = malloc(header.capacity * sizeof(XTB_SymbolSpec))) != NULL) {
+        memcpy(slot, map + sizeof(XTB_CatalogHeader), header.capacity * sizeof(XTB_SymbolSpec));
+
+        for(size_t i = 0; i < header.capacity; i++) {
+            slot[i].symbol[XTB_SYMBOL_SIZE - 1]                = '\0';
+            slot[i].currency[XTB_CURRENCY_SIZE - 1]            = '\0';
+            slot[i].currency_profit[XTB_CURRENCY_SIZE - 1]     = '\0';
+        }
+    }
+
+    munmap((void *) map, st.st_size);
+
+    if(slot == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&self->mutex);
+
+    free(self->slot);
+    self->slot = slot;
+    self->mask = header.capacity - 1;
+    self->size = header.size;
+
+    memcpy(self->currency, header.currency, XTB_CURRENCY_SIZE);
+    self->currency[XTB_CURRENCY_SIZE - 1] = '\0';
+
+    pthread_mutex_unlock(&self->mutex);
+
+    return header.updated;
+}
+
+
+#define CMD_BUFFER_SIZE 1024
+
+
+/*
+ * active subscription of stream client, all of them are sent again after reconnect,
+ * max_level is negative for subscriptions without arrival time and level parameters
+ */
+typedef struct XTB_Subscription {
+    const char * command;
+    char * symbol;
+    time_t min_arrival_time;
+    int max_level;
+
+    struct XTB_Subscription * next;
+}XTB_Subscription;
+
+
+struct XTB_StreamClient {
+    XTB_Api api;
+    XTB_Client * client;
+
+    StreamClientCallback callback;
+    XTB_StreamHandler handler;
+    void * param;
+
+    struct XTB_EventRing * ring;
+    XTB_BarBuilder * bars;
+    XTB_LiveSeries * series;
+    XTB_ArchiveWriter * archive;
+    XTB_StreamRecorder * recorder;
+
+    XTB_Subscription * subscription;
+
+    /*
+     * wall clock time of the last received message is the begin of gap reported after
+     * reconnect, the connection is considered dead when silent longer than stale_timeout
+     */
+    int64_t last_receive;
+    int64_t last_activity;
+    int stale_timeout;
+
+    /*
+     * disconnected client connects again when next_attempt passes, the delay between
+     * attempts grows up to the limit
+     */
+    int64_t next_attempt;
+    int reconnect_delay;
+    unsigned int seed;
+    struct XTB_SessionCheck * session;
+    struct XTB_Connect * connect;
+
+    /*
+     * offline client isn't connected and isn't linked into list of client, it is fed by replayer
+     */
+    bool offline;
+
+    char cmd_buffer[CMD_BUFFER_SIZE];
+
+    XTB_StreamClient * prev;
+    XTB_StreamClient * next;
+};
+
+
+#define XTB_CMD_LOGOUT                 "{\"command\": \"logout\"}"
+#define XTB_CMD_PING                   "{\"command\": \"ping\"}"
+#define XTB_CMD_GET_ALL_SYMBOLS        "{\"command\": \"getAllSymbols\"}"
+#define XTB_CMD_GET_CALENDAR           "{\"command\": \"getCalendar\"}"
+#define XTB_CMD_GET_MARGIN_LEVEL       "{\"command\": \"getMarginLevel\"}"
+#define XTB_CMD_GET_SERVER_TIME        "{\"command\": \"getServerTime\"}"
+#define XTB_CMD_GET_VERSION            "{\"command\": \"getVersion\"}"
+#define XTB_CMD_GET_CURRENT_USER_DATA  "{\"command\": \"getCurrentUserData\"}"
+#define XTB_CMD_GET_STEP_RULES         "{\"command\": \"getStepRules\"}"
+
+
+typedef struct XTB_Request {
+    uint32_t tag;
+
+    void (*complete)(struct XTB_Request *, XTB_Error, Json *);
+    XTB_Callback callback;
+    void * param;
+
+    struct XTB_Request * next;
+}XTB_Request;
+
+
+typedef void (*XTB_Complete)(XTB_Request *, XTB_Error, Json *);
+
+
+/*
+ * request held back until the spacing required by server allows to send it
+ */
+typedef struct XTB_PacedRequest {
+    struct XTB_PacedRequest * next;
+    XTB_Request request;
+    char msg[];
+}XTB_PacedRequest;
+
+
+/*
+ * request submitted from other thread than the I/O thread of client, it is passed 
+ * to the I/O thread through lock-free multi-producer single-consumer queue
+ */
+typedef struct XTB_Submission {
+    _Atomic(struct XTB_Submission *) next;
+
+    XTB_Complete complete;
+    XTB_Callback callback;
+    void * param;
+
+    char * cmd;
+}XTB_Submission;
+
+
+typedef struct {
+    _Alignas(64) _Atomic(XTB_Submission *) head;
+    _Alignas(64) XTB_Submission * tail;
+    XTB_Submission stub;
+}XTB_SubmissionQueue;
+
+
+static void xtb_submission_queue_init(XTB_SubmissionQueue * self) {
+    atomic_init(&self->stub.next, NULL);
+    atomic_init(&self->head, &self->stub);
+    self->tail = &self->stub;
+}
+
+
+static void xtb_submission_queue_push(XTB_SubmissionQueue * self, XTB_Submission * submission) {
+    atomic_store_explicit(&submission->next, NULL, memory_order_relaxed);
+
+    XTB_Submission * prev = atomic_exchange_explicit(&self->head, submission, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, submission, memory_order_release);
+}
+
+
+/*
+ * can be called only from the consumer thread, returns NULL if the queue is empty
+ * or if the producer is just in the middle of push
+ */
+static XTB_Submission * xtb_submission_queue_pop(XTB_SubmissionQueue * self) {
+    XTB_Submission * tail = self->tail;
+    XTB_Submission * next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+    if(tail == &self->stub) {
+        if(next == NULL) {
+            return NULL;
+        }
+
+        self->tail = tail = next;
+        next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    }
+
+    if(next != NULL) {
+        self->tail = next;
+        return tail;
+    }
+
+    if(tail != atomic_load_explicit(&self->head, memory_order_acquire)) {
+        return NULL;
+    }
+
+    xtb_submission_queue_push(self, &self->stub);
+
+    if((next = atomic_load_explicit(&tail->next, memory_order_acquire)) != NULL) {
+        self->tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+
+struct XTB_Client {
+    XTB_Api api;
+    XTB_AccountMode mode;
+
+    char * id;
+    char * password;
+    char * stream_session_id;
+
+    /*
+     * requests sent to server and waiting for response in order of sending
+     * and released requests prepared for reuse
+     */
+    uint32_t tag;
+    XTB_Request * pending;
+    XTB_Request * pending_last;
+    XTB_Request * unused;
+
+    /*
+     * time of the last sent request and number of requests sent in a row
+     * faster than the spacing required by server, requests which would break 
+     * the spacing are held back in order of sending
+     */
+    int64_t last_send;
+    size_t burst;
+    XTB_PacedRequest * paced;
+    XTB_PacedRequest * paced_last;
+
+    /*
+     * in thread-safe mode only the I/O thread works with the connection and the requests
+     */
+    atomic_bool io_running;
+    atomic_bool io_stop;
+    atomic_size_t io_submitting;
+    pthread_t io_thread;
+    int wake_fd;
+    XTB_SubmissionQueue queue;
+
+    /*
+     * new main connection opened and logged in by worker after the session was lost
+     */
+    struct XTB_Connect * relogin;
+
+    XTB_StreamClient * stream_client;
+    XTB_QuoteTable * quotes;
+    XTB_OrderTracker * orders;
+    XTB_PositionBook * positions;
+    XTB_SymbolCache * symbols;
+};
+
+
+/*
+ * commands are formatted into buffer of calling thread, so more threads can 
+ * use the same client at the same time
+ */
+static _Thread_local char xtb_cmd_buffer[CMD_BUFFER_SIZE];
+
+
+#define XTB_TAG_SIZE 32
+
+
+/*
+ * server requires 200 ms between requests on one connection and drops the 
+ * connection when the interval is broken 6 times in a row
+ */
+#define XTB_REQUEST_SPACING 200
+#define XTB_REQUEST_BURST 5
+
+
+/*
+ * milliseconds until the next request can be sent without breaking the spacing
+ */
+static int64_t xtb_client_pace_delay(XTB_Client * self, int64_t now) {
+    if(now - self->last_send >= XTB_REQUEST_SPACING || self->burst < XTB_REQUEST_BURST) {
+        return 0;
+    }
+
+    return XTB_REQUEST_SPACING - (now - self->last_send);
+}
+
+
+static void xtb_client_pace(XTB_Client * self, int64_t now) {
+    self->burst     = now - self->last_send >= XTB_REQUEST_SPACING ? 0 : self->burst + 1;
+    self->last_send = now;
+}
+
+
+/*
+ * sent request waits for response in order of sending
+ */
+static bool xtb_client_transmit(XTB_Client * self, const XTB_Request * sent, const char * msg) {
+    if(self->api.bio == NULL || xtb_api_send(&self->api, msg) == false) {
+        return false;
+    }
+
+    xtb_client_pace(self, xtb_clock_ms());
+
+    XTB_Request * request = self->unused;
+
+    if(request != NULL) {
+        self->unused = request->next;
+    } else {
+        request = malloc(sizeof(XTB_Request));
+    }
+
+    *request      = *sent;
+    request->next = NULL;
+
+    if(self->pending_last != NULL) {
+        self->pending_last->next = request;
+    } else {
+        self->pending = request;
+    }
+
+    self->pending_last = request;
+
+    return true;
+}
+
+
+/*
+ * every command is sent with unique customTag, which the server returns back in 
+ * the response, so more commands can wait for their responses at the same time, 
+ * commands which would break the spacing required by server are held back and 
+ * sent later by xtb_client_release, so sending never blocks
+ */
+static bool xtb_client_send_tagged(
+        XTB_Client * self, uint32_t tag, const char * msg, XTB_Complete complete, XTB_Callback callback, void * param) {
+    XTB_Request request = {
+        .tag = tag
+        , .complete = complete
+        , .callback = callback
+        , .param = param
+    };
+
+    if(self->paced == NULL && xtb_client_pace_delay(self, xtb_clock_ms()) == 0) {
+        return xtb_client_transmit(self, &request, msg);
+    }
+
+    size_t length = strlen(msg) + 1;
+    XTB_PacedRequest * paced;
+
+    if(self->api.bio == NULL || (paced = malloc(sizeof(XTB_PacedRequest) + length)) == NULL) {
+        return false;
+    }
+
+    paced->next    = NULL;
+    paced->request = request;
+    memcpy(paced->msg, msg, length);
+
+    if(self->paced_last != NULL) {
+        self->paced_last->next = paced;
+    } else {
+        self->paced = paced;
+    }
+
+    self->paced_last = paced;
+
+    return true;
+}
+
+
+static XTB_PacedRequest * xtb_client_paced_pop(XTB_Client * self) {
+    XTB_PacedRequest * paced = self->paced;
+
+    if(paced != NULL && (self->paced = paced->next) == NULL) {
+        self->paced_last = NULL;
+    }
+
+    return paced;
+}
+
+
+/*
+ * sends requests held back as far as the spacing allows, request which can't be 
+ * sent is completed as failed
+ */
+static void xtb_client_release(XTB_Client * self) {
+    while(self->paced != NULL && xtb_client_pace_delay(self, xtb_clock_ms()) == 0) {
+        XTB_PacedRequest * paced = xtb_client_paced_pop(self);
+
+        if(xtb_client_transmit(self, &paced->request, paced->msg) == false) {
+            paced->request.complete(&paced->request, XTB_Error_Connection, NULL);
+        }
+
+        free(paced);
+    }
+}
+
+
+int xtb_client_timeout(XTB_Client * self) {
+    return self->paced != NULL ? (int) xtb_client_pace_delay(self, xtb_clock_ms()) : -1;
+}
+
+
+static bool xtb_client_send_request(
+        XTB_Client * self, const char * cmd, XTB_Complete complete, XTB_Callback callback, void * param) {
+    char msg[CMD_BUFFER_SIZE + XTB_TAG_SIZE];
+    uint32_t tag = ++self->tag;
+
+    if(cmd[0] != '{' 
+            || snprintf(msg, sizeof(msg), "{\"customTag\": \"%u\", %s", tag, cmd + 1) >= (int) sizeof(msg)) {
+        __assert("command format error\n");
+        return false;
+    }
+
+    return xtb_client_send_tagged(self, tag, msg, complete, callback, param);
+}
+
+
+static void xtb_client_complete(
+        XTB_Client * self, XTB_Request * prev, XTB_Request * request, XTB_Error error, Json * response) {
+    if(prev != NULL) {
+        prev->next = request->next;
+    } else {
+        self->pending = request->next;
+    }
+
+    if(self->pending_last == request) {
+        self->pending_last = prev;
+    }
+
+    XTB_Request completed = *request;
+
+    request->next = self->unused;
+    self->unused  = request;
+
+    /*
+     * request is released before the completion, so the completion can send 
+     * next commands
+     */
+    completed.complete(&completed, error, response);
+}
+
+
+/*
+ * all waiting requests are completed with error, when the connection failed, 
+ * requests held back are completed after them in order of sending
+ */
+static void xtb_client_cancel(XTB_Client * self) {
+    XTB_PacedRequest * paced;
+
+    while(self->pending != NULL) {
+        xtb_client_complete(self, NULL, self->pending, XTB_Error_Connection, NULL);
+    }
+
+    while((paced = xtb_client_paced_pop(self)) != NULL) {
+        paced->request.complete(&paced->request, XTB_Error_Connection, NULL);
+        free(paced);
+    }
+}
+
+
+static void xtb_client_dispatch(void * param, char * frame) {
+    XTB_Client * self = param;
+    Json * response   = json_parse(frame);
+
+    if(response == NULL) {
+        /*
+         * server responds in order of requests, so the broken response belongs 
+         * to the oldest request
+         */
+        __assert("response format error\n");
+
+        if(self->pending != NULL) {
+            xtb_client_complete(self, NULL, self->pending, XTB_Error_Format, NULL);
+        }
+
+        return;
+    }
+
+    Json * json_tag = json_lookup(response, "customTag");
+
+    if(json_is_type(json_tag, JsonString) == true) {
+        uint32_t tag = strtoul(json_tag->string, NULL, 10);
+
+        for(XTB_Request * it = self->pending, * prev = NULL; it != NULL; prev = it, it = it->next) {
+            if(it->tag == tag) {
+                xtb_client_complete(self, prev, it, XTB_Error_None, response);
+                return;
+            }
+        }
+    }
+
+    __assert("unexpected response: %s\n", frame);
+    json_delete(response);
+}
+
+
+static bool xtb_client_poll(void * param) {
+    XTB_Client * self = param;
+
+    if(xtb_api_drain(&self->api, xtb_client_dispatch, self) == false) {
+        xtb_client_cancel(self);
+        return false;
+    }
+
+    return true;
+}
+
+
+/*
+ * blocks until new data are received and completes all requests with received response, 
+ * blocking commands wait here also for the spacing of requests held back
+ */
+static bool xtb_client_wait(XTB_Client * self) {
+    int timeout = xtb_client_timeout(self);
+
+    if(xtb_buffer_has_frame(&self->api.rcv) == false 
+            && xtb_api_wait(&self->api, POLLIN, timeout) == false && timeout < 0) {
+        xtb_client_cancel(self);
+        return false;
+    }
+
+    xtb_client_release(self);
+
+    return xtb_client_poll(self);
+}
+
+
+static inline bool xtb_client_foreign_thread(XTB_Client * self) {
+    return atomic_load_explicit(&self->io_running, memory_order_acquire) == true 
+            && pthread_equal(pthread_self(), self->io_thread) == 0;
+}
+
+
+/*
+ * requests from other threads are queued for the I/O thread, requests submitted 
+ * from the I/O thread itself (from completion callbacks) are sent directly, 
+ * submission fails when the I/O thread is stopping, the stopping thread waits 
+ * until the submissions in progress are queued, so none of them is lost
+ */
+static bool xtb_client_submit(
+        XTB_Client * self, const char * cmd, XTB_Complete complete, XTB_Callback callback, void * param) {
+    if(xtb_client_foreign_thread(self) == false) {
+        return xtb_client_send_request(self, cmd, complete, callback, param);
+    }
+
+    atomic_fetch_add(&self->io_submitting, 1);
+
+    if(atomic_load(&self->io_stop) == true) {
+        atomic_fetch_sub(&self->io_submitting, 1);
+        return false;
+    }
+
+    size_t length = strlen(cmd) + 1;
+    XTB_Submission * submission = malloc(sizeof(XTB_Submission) + length);
+
+    if(submission == NULL) {
+        atomic_fetch_sub(&self->io_submitting, 1);
+        return false;
+    }
+
+    submission->complete = complete;
+    submission->callback = callback;
+    submission->param    = param;
+    submission->cmd      = memcpy(submission + 1, cmd, length);
+
+    xtb_submission_queue_push(&self->queue, submission);
+
+    uint64_t wake = 1;
+
+    if(write(self->wake_fd, &wake, sizeof(wake)) < 0) {
+        __assert("I/O thread wake up error\n");
+    }
+
+    atomic_fetch_sub(&self->io_submitting, 1);
+
+    return true;
+}
+
+
+/*
+ * counter of requests the caller waits for, requests submitted from other thread 
+ * are completed by the I/O thread, so the caller is woken up by condition
+ */
+typedef struct {
+    XTB_Client * client;
+    size_t waiting;
+
+    bool shared;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+}XTB_Wait;
+
+
+static void xtb_wait_init(XTB_Wait * self, XTB_Client * client) {
+    self->client  = client;
+    self->waiting = 0;
+    self->shared  = xtb_client_foreign_thread(client);
+
+    if(self->shared == true) {
+        pthread_mutex_init(&self->mutex, NULL);
+        pthread_cond_init(&self->cond, NULL);
+    }
+}
+
+
+static void xtb_wait_add(XTB_Wait * self) {
+    if(self->shared == true) {
+        pthread_mutex_lock(&self->mutex);
+        self->waiting++;
+        pthread_mutex_unlock(&self->mutex);
+    } else {
+        self->waiting++;
+    }
+}
+
+
+static void xtb_wait_done(XTB_Wait * self) {
+    if(self->shared == true) {
+        pthread_mutex_lock(&self->mutex);
+
+        if(--self->waiting == 0) {
+            pthread_cond_signal(&self->cond);
+        }
+
+        pthread_mutex_unlock(&self->mutex);
+    } else {
+        self->waiting--;
+    }
+}
+
+
+static void xtb_wait_finish(XTB_Wait * self) {
+    if(self->shared == true) {
+        pthread_mutex_lock(&self->mutex);
+
+        while(self->waiting > 0) {
+            pthread_cond_wait(&self->cond, &self->mutex);
+        }
+
+        pthread_mutex_unlock(&self->mutex);
+
+        pthread_cond_destroy(&self->cond);
+        pthread_mutex_destroy(&self->mutex);
+    } else {
+        while(self->waiting > 0 && xtb_client_wait(self->client) == true);
+    }
+}
+
+
+typedef struct {
+    XTB_Wait wait;
+    Json * response;
+}XTB_Transaction;
+
+
+static void xtb_transaction_complete(XTB_Request * request, XTB_Error error, Json * response) {
+    XTB_Transaction * transaction = request->param;
+
+    (void) error;
+
+    transaction->response = response;
+    xtb_wait_done(&transaction->wait);
+}
+
+
+/*
+ * sends command and waits for its response, responses of other commands received 
+ * in the meantime are dispatched to their requests
+ */
+static Json * xtb_client_transaction(XTB_Client * self, const char * cmd) {
+    XTB_Transaction transaction = {.response = NULL};
+
+    xtb_wait_init(&transaction.wait, self);
+    xtb_wait_add(&transaction.wait);
+
+    if(xtb_client_submit(self, cmd, xtb_transaction_complete, NULL, &transaction) == false) {
+        xtb_wait_done(&transaction.wait);
+    }
+
+    xtb_wait_finish(&transaction.wait);
+
+    return transaction.response;
+}
+
+
+static void xtb_client_logout(XTB_Client * self) {
+    if(self->stream_session_id != NULL) {
+        Json * json_logout = xtb_client_transaction(self, XTB_CMD_LOGOUT);
+     
+        if(read_status(json_logout) == false)
+            __assert("logout error\n");
+
+        json_delete(json_logout);   
+
+        free(self->stream_session_id);
+        self->stream_session_id = NULL;
+    }
+}
+
+
+static const char * xtb_command_login(char * buffer, char * id, char * password) {
+    snprintf(
+        buffer
+        , CMD_BUFFER_SIZE
+        , "{\"command\": \"login\", \"arguments\": {\"userId\": \"%s\", \"password\": \"%s\"}}"
+        , id, password);
+
+    return buffer; 
+}
+
+
+static bool xtb_client_login(XTB_Client * self, char * id, char * password) {
+    /*
+     * attempt to login is done only if the status is not logged
+     * otherwise is only returned true result, because user is already logged
+     */
+    if(self->stream_session_id == NULL) {
+        Json * result = xtb_client_transaction(self, xtb_command_login(xtb_cmd_buffer, id, password));
+
+        if(read_status(result) == false) {
+            json_delete(result);
+            return false;
+        }
+
+        if(json_is_type(json_lookup(result, "streamSessionId"), JsonString) == true) 
+            self->stream_session_id = strdup(json_lookup(result, "streamSessionId")->string);
+
+        json_delete(result);    
+    }
+
+    return true;
+}
+
+
+static bool xtb_event_loop_register(
+        XTB_EventLoop * self, XTB_Api * api, bool (*process)(void *), bool (*check)(void *)
+        , int (*timeout)(void *), void * object);
+
+
+static bool xtb_client_check(void * param);
+static int xtb_client_timer(void * param);
+
+
+#define XTB_API_SOCKET_PORT_DEMO "5124"
+#define XTB_API_SOCKET_PORT_REAL "5112"
+
+#define XTB_API_SOCKET_PORT_DEMO_STREAM "5125"
+#define XTB_API_SOCKET_PORT_REAL_STREAM "5113"
+
+#define XTB_API_ADDRESS "xapi.xtb.com"
+
+
+#define XTB_API_MAIN_URL(mode)                                                          \
+    ((mode) == XTB_AccountMode_Real ? XTB_API_ADDRESS ":" XTB_API_SOCKET_PORT_REAL:     \
+                                    XTB_API_ADDRESS ":" XTB_API_SOCKET_PORT_DEMO)
+
+
+#define XTB_API_STREAM_URL(mode)                                                                \
+    ((mode) == XTB_AccountMode_Real ? XTB_API_ADDRESS ":" XTB_API_SOCKET_PORT_REAL_STREAM:      \
+                                    XTB_API_ADDRESS ":" XTB_API_SOCKET_PORT_DEMO_STREAM)
+
+
+XTB_Client * xtb_client_new(XTB_AccountMode mode, char * id, char * password) {
+	XTB_Client * self = calloc(1, sizeof(XTB_Client));
+    const char * url = XTB_API_MAIN_URL(mode);
+
+    if((self->symbols = xtb_symbol_cache_new(64)) == NULL) {
+        xtb_client_delete(self);
+        return NULL;
+    }
+
+	/*
+	 * initializing of OpenSSL library
+	 */
+    if(xtb_api_connect(&self->api, url) == false) {
+        xtb_client_delete(self);
+        return NULL;
+    }
+
+	if(xtb_client_login(self, id, password) == false) {
+		__assert("Login was not successfull\n");
+	}
+
+    self->mode     = mode;
+    self->id       = strdup(id);
+    self->password = strdup(password);
+
+    return self;
+}
+
+
+/*
+ * state of connection opened by worker and of the main session verified by asynchronous ping
+ */
+typedef enum {
+    XTB_Session_Pending
+    , XTB_Session_Valid
+    , XTB_Session_Lost
+}XTB_Session;
+
+
+/*
+ * DNS lookup, TCP and TLS handshakes and login block, so the connection is opened by 
+ * detached worker thread and handed over to the owner when finished, the state is 
+ * shared by both of them and released by the last one
+ */
+#define XTB_CONNECT_TIMEOUT 10000
+
+
+typedef struct XTB_Connect {
+    atomic_int state;
+    atomic_int refs;
+
+    const char * url;
+    char * id;
+    char * password;
+
+    XTB_Api api;
+    char * stream_session_id;
+}XTB_Connect;
+
+
+static void xtb_connect_release(XTB_Connect * self) {
+    if(self != NULL && atomic_fetch_sub(&self->refs, 1) == 1) {
+        xtb_api_close(&self->api);
+        free(self->stream_session_id);
+        free(self->id);
+        free(self->password);
+        free(self);
+    }
+}
+
+
+static bool xtb_connect_login(XTB_Connect * self) {
+    char cmd[CMD_BUFFER_SIZE];
+    char * frame;
+
+    if(xtb_api_send(&self->api, xtb_command_login(cmd, self->id, self->password)) == false
+            || (frame = xtb_api_receive(&self->api, XTB_CONNECT_TIMEOUT)) == NULL) {
+        return false;
+    }
+
+    Json * result = json_parse(frame);
+    Json * json_session = json_lookup(result, "streamSessionId");
+
+    if(read_status(result) == true && json_is_type(json_session, JsonString) == true) {
+        self->stream_session_id = strdup(json_session->string);
+    }
+
+    json_delete(result);
+
+    return self->stream_session_id != NULL;
+}
+
+
+static void * xtb_connect_thread(void * param) {
+    XTB_Connect * self = param;
+
+    bool connected = xtb_api_connect(&self->api, self->url) == true
+                        && (self->id == NULL || xtb_connect_login(self) == true);
+
+    atomic_store(&self->state, connected == true ? XTB_Session_Valid : XTB_Session_Lost);
+    xtb_connect_release(self);
+
+    return NULL;
+}
+
+
+/*
+ * login is done only if id is given
+ */
+static XTB_Connect * xtb_connect_start(const char * url, const char * id, const char * password) {
+    XTB_Connect * self = calloc(1, sizeof(XTB_Connect));
+    pthread_t thread;
+
+    if(self == NULL) {
+        return NULL;
+    }
+
+    atomic_init(&self->state, XTB_Session_Pending);
+    atomic_init(&self->refs, 2);
+    self->url = url;
+
+    if((id != NULL && ((self->id = strdup(id)) == NULL || (self->password = strdup(password)) == NULL))
+            || pthread_create(&thread, NULL, xtb_connect_thread, self) != 0) {
+        __assert("connect thread create error\n");
+        atomic_store(&self->refs, 1);
+        xtb_connect_release(self);
+        return NULL;
+    }
+
+    pthread_detach(thread);
+
+    return self;
+}
+
+
+/*
+ * finished connection is moved to the owner, it isn't registered in any event loop yet
+ */
+static void xtb_connect_take(XTB_Connect * self, XTB_Api * api) {
+    *api      = self->api;
+    self->api = (XTB_Api) {0};
+}
+
+
+/*
+ * main connection is opened and logged in again by worker, requests waiting for response
+ * on the old connection are completed as failed when the new one is taken over, the client
+ * can't be processed by I/O thread
+ */
+static XTB_Session xtb_client_relogin(XTB_Client * self) {
+    if(self->relogin == NULL 
+            && (self->relogin = xtb_connect_start(XTB_API_MAIN_URL(self->mode), self->id, self->password)) == NULL) {
+        return XTB_Session_Lost;
+    }
+
+    XTB_Session state = atomic_load(&self->relogin->state);
+
+    if(state == XTB_Session_Pending) {
+        return XTB_Session_Pending;
+    }
+
+    if(state == XTB_Session_Valid) {
+        XTB_EventLoop * loop = self->api.loop;
+
+        xtb_api_close(&self->api);
+        xtb_client_cancel(self);
+        xtb_connect_take(self->relogin, &self->api);
+
+        free(self->stream_session_id);
+        self->stream_session_id          = self->relogin->stream_session_id;
+        self->relogin->stream_session_id = NULL;
+
+        if(loop != NULL) {
+            xtb_event_loop_register(
+                loop, &self->api, xtb_client_poll, xtb_client_check, xtb_client_timer, self);
+        }
+    }
+
+    xtb_connect_release(self->relogin);
+    self->relogin = NULL;
+
+    return state;
+}
+
+
+bool xtb_client_logged(XTB_Client * self) {
+    return self->stream_session_id != NULL; 
+}
+
+
+size_t xtb_client_stream_session_size(XTB_Client * self) {
+    XTB_StreamClient * stream_client = self->stream_client;
+    size_t size = 0;
+    
+    while(stream_client != NULL) {
+        stream_client = stream_client->next;
+        size++;
+    }
+
+    return size;
+}
+
+
+bool xtb_client_ping(XTB_Client * self) {
+    Json * result = xtb_client_transaction(self, XTB_CMD_PING);
+    
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return false;
+    }
+
+    json_delete(result);
+
+    return true;
+}
+
+
+bool xtb_client_enable_quotes(XTB_Client * self, size_t capacity) {
+    if(self->quotes != NULL) {
+        return true;
+    }
+
+    return capacity > 0 && (self->quotes = xtb_quote_table_new(capacity)) != NULL;
+}
+
+
+bool xtb_client_get_quote(XTB_Client * self, const char * symbol, int level, XTB_Quote * quote) {
+    return self->quotes != NULL && xtb_quote_table_read(self->quotes, symbol, level, quote);
+}
+
+
+bool xtb_client_get_quote_by_id(XTB_Client * self, XTB_SymbolId id, XTB_Quote * quote) {
+    return self->quotes != NULL && xtb_quote_table_read_id(self->quotes, id, quote);
+}
+
+
+bool xtb_client_enable_order_tracking(XTB_Client * self) {
+    if(self->orders != NULL) {
+        return true;
+    }
+
+    return (self->orders = xtb_order_tracker_new()) != NULL;
+}
+
+
+bool xtb_client_track_order(
+        XTB_Client * self, uint64_t order, int64_t submitted, XTB_OrderCallback callback, void * param) {
+    if(self->orders == NULL) {
+        __assert("order tracking is not enabled\n");
+        return false;
+    }
+
+    return xtb_order_tracker_track(self->orders, order, submitted, callback, param);
+}
+
+
+void xtb_client_set_order_callback(XTB_Client * self, XTB_OrderCallback callback, void * param) {
+    if(self->orders == NULL) {
+        __assert("order tracking is not enabled\n");
+        return;
+    }
+
+    pthread_mutex_lock(&self->orders->mutex);
+    self->orders->callback = callback;
+    self->orders->param    = param;
+    pthread_mutex_unlock(&self->orders->mutex);
+}
+
+
+/*
+ * order number from response of tradeTransaction is tracked with default callback
+ */
+static void xtb_client_track_result(XTB_Client * self, Json * result, int64_t submitted) {
+    XTB_OrderTracker * orders = self->orders;
+    Json * json_order;
+
+    if(orders != NULL && json_is_type((json_order = json_lookup(result, "order")), JsonInteger) == true) {
+        pthread_mutex_lock(&orders->mutex);
+        XTB_OrderCallback callback = orders->callback;
+        void * param               = orders->param;
+        pthread_mutex_unlock(&orders->mutex);
+
+        xtb_order_tracker_track(orders, strtoull(json_order->string, NULL, 10), submitted, callback, param);
+    }
+}
+
+
+int64_t xtb_monotonic_ns(void) {
+    return xtb_clock_ns();
+}
+
+
+static double json_lookup_number(Json * object, const char * key) {
+    Json * value = json_lookup(object, key);
+    return value != NULL && value->string != NULL ? strtod(value->string, NULL) : 0;
+}
+
+
+static int64_t json_lookup_integer(Json * object, const char * key) {
+    Json * value = json_lookup(object, key);
+    return value != NULL && value->string != NULL ? strtoll(value->string, NULL, 10) : 0;
+}
+
+
+static void json_lookup_string(Json * object, const char * key, char * buffer, size_t size) {
+    Json * value = json_lookup(object, key);
+    snprintf(buffer, size, "%s", json_is_type(value, JsonString) == true ? value->string : "");
+}
+
+
+static void xtb_trade_record_from_json(Json * json, XTB_TradeRecord * trade) {
+    Json * closed = json_lookup(json, "closed");
+
+    *trade = (XTB_TradeRecord) {
+        .order = json_lookup_integer(json, "order")
+        , .order2 = json_lookup_integer(json, "order2")
+        , .position = json_lookup_integer(json, "position")
+        , .open_time = json_lookup_integer(json, "open_time")
+        , .close_time = json_lookup_integer(json, "close_time")
+        , .expiration = json_lookup_integer(json, "expiration")
+        , .open_price = json_lookup_number(json, "open_price")
+        , .close_price = json_lookup_number(json, "close_price")
+        , .sl = json_lookup_number(json, "sl")
+        , .tp = json_lookup_number(json, "tp")
+        , .volume = json_lookup_number(json, "volume")
+        , .profit = json_lookup_number(json, "profit")
+        , .commission = json_lookup_number(json, "commission")
+        , .storage = json_lookup_number(json, "storage")
+        , .margin_rate = json_lookup_number(json, "margin_rate")
+        , .cmd = json_lookup_integer(json, "cmd")
+        , .digits = json_lookup_integer(json, "digits")
+        , .offset = json_lookup_integer(json, "offset")
+        , .closed = json_is_type(closed, JsonBool) == true && strcmp(closed->string, "true") == 0
+    };
+
+    json_lookup_string(json, "symbol", trade->symbol, XTB_SYMBOL_SIZE);
+    json_lookup_string(json, "comment", trade->comment, XTB_COMMENT_SIZE);
+    json_lookup_string(json, "customComment", trade->custom_comment, XTB_COMMENT_SIZE);
+
+    trade->id = xtb_symbol_intern(trade->symbol);
+}
+
+
+static bool xtb_client_reset_positions(XTB_Client * self, Json * trades) {
+    if(json_is_type(trades, JsonArray) == false) {
+        return false;
+    }
+
+    XTB_TradeRecord * trade = malloc(sizeof(XTB_TradeRecord) * (trades->array.size + 1));
+
+    if(trade == NULL) {
+        return false;
+    }
+
+    for(size_t i = 0; i < trades->array.size; i++) {
+        xtb_trade_record_from_json(trades->array.value[i], &trade[i]);
+    }
+
+    xtb_position_book_reset(self->positions, trade, trades->array.size);
+
+    free(trade);
+
+    return true;
+}
+
+
+bool xtb_client_sync_positions(XTB_Client * self) {
+    if(self->positions == NULL) {
+        __assert("positions are not enabled\n");
+        return false;
+    }
+
+    Json * trades = xtb_client_get_trades(self, true);
+    bool success  = xtb_client_reset_positions(self, trades);
+
+    json_delete(trades);
+
+    return success;
+}
+
+
+static void xtb_client_sync_positions_complete(void * param, XTB_Error error, Json * trades) {
+    if(error != XTB_Error_None || xtb_client_reset_positions(param, trades) == false) {
+        __assert("positions sync failed\n");
+    }
+
+    json_delete(trades);
+}
+
+
+/*
+ * the book is loaded again in completion called by the thread processing main client
+ */
+static bool xtb_client_async_sync_positions(XTB_Client * self) {
+    return xtb_client_async_get_trades(self, true, xtb_client_sync_positions_complete, self);
+}
+
+
+bool xtb_client_enable_positions(XTB_Client * self) {
+    if(self->positions != NULL) {
+        return true;
+    }
+
+    if((self->positions = xtb_position_book_new()) == NULL) {
+        return false;
+    }
+
+    return xtb_client_sync_positions(self);
+}
+
+
+bool xtb_client_get_position(XTB_Client * self, uint64_t position, XTB_TradeRecord * trade) {
+    return self->positions != NULL && xtb_position_book_get(self->positions, position, trade);
+}
+
+
+size_t xtb_client_get_positions(XTB_Client * self, const char * symbol, XTB_TradeRecord * buffer, size_t size) {
+    return self->positions != NULL ? xtb_position_book_copy(self->positions, symbol, buffer, size) : 0;
+}
+
+
+Json * xtb_client_get_all_symbols(XTB_Client * self) {
+    Json * result = xtb_client_transaction(self, XTB_CMD_GET_ALL_SYMBOLS);
+    
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+
+    return extract_return_data(result);
+}
+
+
+Json * xtb_client_get_calendar(XTB_Client * self) {
+    Json * result = xtb_client_transaction(self, XTB_CMD_GET_CALENDAR);
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+
+    return extract_return_data(result);
+}
+
+
+static const char * xtb_command_get_chart_last_request(
+        char * buffer, char * symbol, XTB_Period period, time_t start) {
+    snprintf(
+        buffer
+        , CMD_BUFFER_SIZE
+        , "{\"command\": \"getChartLastRequest\", \"arguments\":"
+          "{\"info\": {\"period\": %d, \"start\": %ld, \"symbol\": \"%s\"}}}"
+        , period / 60
+        , start * 1000
+        , symbol);
+
+    return buffer;
+}
+
+
+Json * xtb_client_get_chart_last_request(XTB_Client * self, char * symbol, XTB_Period period, time_t start) {
+    Json * result = xtb_client_transaction(
+                        self, xtb_command_get_chart_last_request(xtb_cmd_buffer, symbol, period, start));
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+Json * xtb_client_get_chart_last_request_by_id(XTB_Client * self, XTB_SymbolId id, XTB_Period period, time_t start) {
+    const char * symbol = xtb_symbol_name(id);
+    return symbol != NULL ? xtb_client_get_chart_last_request(self, (char *) symbol, period, start) : NULL;
+}
+
+
+static const char * xtb_command_get_chart_range_request(
+        char * buffer, char * symbol, XTB_Period period, time_t start, time_t end, int32_t tick) {
+    snprintf(
+        buffer
+        , CMD_BUFFER_SIZE
+        , "{\"command\": \"getChartRangeRequest\", \"arguments\":"
+          "{\"info\": {\"end\": %ld, \"period\": %d, \"start\": %ld, \"symbol\": \"%s\", \"ticks\": %d}}}"
+        , end * 1000, period / 60, start * 1000, symbol, tick);
+
+    return buffer;
+}
+
+
+Json * xtb_client_get_chart_range_request(
+        XTB_Client * self, char * symbol, XTB_Period period, time_t start, time_t end, int32_t tick) {
+    Json * json_chart = xtb_client_transaction(
+                            self, xtb_command_get_chart_range_request(xtb_cmd_buffer, symbol, period, start, end, tick));
+
+    if(read_status(json_chart) == false) {
+        __assert("command failed\n");
+        json_delete(json_chart);
+        return NULL;
+    }
+    
+    return extract_return_data(json_chart);
+}
+
+
+Json * xtb_client_get_chart_range_request_by_id(
+        XTB_Client * self, XTB_SymbolId id, XTB_Period period, time_t start, time_t end, int32_t tick) {
+    const char * symbol = xtb_symbol_name(id);
+    return symbol != NULL ? xtb_client_get_chart_range_request(self, (char *) symbol, period, start, end, tick) : NULL;
+}
+
+
+static Json * build_candle_record(Json * json_record, int digits) {
+    /*
+     * getting record data
+     */
+    Json * json_open  = json_lookup(json_record, "open");
+    Json * json_close = json_lookup(json_record, "close");
+    Json * json_high  = json_lookup(json_record, "high");
+    Json * json_low   = json_lookup(json_record, "low");
+    Json * json_ctm   = json_lookup(json_record, "ctm");
+    Json * json_vol   = json_lookup(json_record, "vol");
+
+    /*
+     * check runtime error values
+     */
+    if(json_is_type(json_open, JsonFrac) == false
+            || json_is_type(json_close, JsonFrac) == false
+            || json_is_type(json_high, JsonFrac) == false
+            || json_is_type(json_low, JsonFrac) == false
+            || json_is_type(json_vol, JsonFrac) == false
+            || json_is_type(json_ctm, JsonInteger) == false) {
+        return NULL;
+    }
+
+    /*
+     * assembly the candle data record
+     */
+    float open_val  = atof(json_open->string);
+    float close_val = atof(json_close->string);
+    float high_val  = atof(json_high->string);
+    float low_val   = atof(json_low->string);
+    long timestamp  = strtol(json_ctm->string, NULL, 10);
+    float vol       = atof(json_vol->string);
+
+    Json * candle_record = json_object_new(6);
+
+    json_object_set_record(candle_record, 0, "timestamp", json_integer_new(timestamp));
+    json_object_set_record(candle_record, 1, "open", json_frac_new(open_val / pow(10, digits)));
+    json_object_set_record(candle_record, 2, "close", json_frac_new((open_val + close_val) / pow(10, digits)));
+    json_object_set_record(candle_record, 3, "high", json_frac_new((open_val + high_val) / pow( 10, digits)));
+    json_object_set_record(candle_record, 4, "low", json_frac_new((open_val + low_val) / pow(10, digits)));
+    json_object_set_record(candle_record, 5, "vol", json_frac_new(vol));
+
+    return candle_record;
+}
+
+
+/*
+ * trading hours are given in ms from midnight of CET/CEST time zone for days of week, 
+ * they are cached per symbol for life of the client
+ */
+#define XTB_DAY 86400000
+
+
+static int64_t xtb_last_sunday(int year, int month) {
+    struct tm date = {.tm_year = year - 1900, .tm_mon = month, .tm_mday = 0};
+    time_t time    = timegm(&date);
+
+    gmtime_r(&time, &date);
+
+    return ((int64_t) time - date.tm_wday * 86400) * 1000;
+}
+
+
+/*
+ * summer time starts and ends at 01:00 UTC of the last Sunday of March and October
+ */
+static int64_t xtb_cet_offset(int64_t time) {
+    time_t seconds = time / 1000;
+    struct tm date;
+
+    gmtime_r(&seconds, &date);
+
+    int64_t begin = xtb_last_sunday(date.tm_year + 1900, 3) + 3600000;
+    int64_t end   = xtb_last_sunday(date.tm_year + 1900, 10) + 3600000;
+
+    return time >= begin && time < end ? 7200000 : 3600000;
+}
+
+
+/*
+ * sessions can cross the change of summer time, every boundary is converted by its own offset
+ */
+static inline int64_t xtb_cet_to_utc(int64_t local) {
+    return local - xtb_cet_offset(local - 3600000);
+}
+
+
+static int xtb_trading_segment_compare(const void * a, const void * b) {
+    const XTB_TradingSegment * x = a;
+    const XTB_TradingSegment * y = b;
+
+    if(x->day != y->day) {
+        return x->day - y->day;
+    }
+
+    return x->from < y->from ? 1 : x->from > y->from ? -1 : 0;
+}
+
+
+static bool xtb_client_cached_trading_hours(XTB_Client * self, const char * symbol, XTB_TradingHours * hours) {
+    pthread_mutex_lock(&self->symbols->mutex);
+
+    XTB_TradingHours * it = self->symbols->hours;
+
+    while(it != NULL && strcmp(it->symbol, symbol) != 0) {
+        it = it->next;
+    }
+
+    if(it != NULL) {
+        *hours = *it;
+    }
+
+    pthread_mutex_unlock(&self->symbols->mutex);
+
+    return it != NULL;
+}
+
+
+/*
+ * reads trading hours of symbol from response of getTradingHours and caches them
+ */
+static bool xtb_client_store_trading_hours(XTB_Client * self, const char * symbol, Json * result, XTB_TradingHours * hours) {
+    XTB_TradingHours * it;
+    Json * trading = json_is_type(result, JsonArray) == true && result->array.size > 0 
+                        ? json_lookup(result->array.value[0], "trading") : NULL;
+
+    if(json_is_type(trading, JsonArray) == false) {
+        return false;
+    }
+
+    *hours = (XTB_TradingHours) {0};
+    snprintf(hours->symbol, XTB_SYMBOL_SIZE, "%s", symbol);
+
+    for(size_t i = 0; i < trading->array.size && hours->size < XTB_TRADING_SEGMENTS; i++) {
+        hours->segment[hours->size++] = (XTB_TradingSegment) {
+            .day = json_lookup_integer(trading->array.value[i], "day") % 7
+            , .from = json_lookup_integer(trading->array.value[i], "fromT")
+            , .to = json_lookup_integer(trading->array.value[i], "toT")
+        };
+    }
+
+    qsort(hours->segment, hours->size, sizeof(XTB_TradingSegment), xtb_trading_segment_compare);
+
+    if((it = malloc(sizeof(XTB_TradingHours))) != NULL) {
+        pthread_mutex_lock(&self->symbols->mutex);
+
+        *it                  = *hours;
+        it->next             = self->symbols->hours;
+        self->symbols->hours = it;
+
+        pthread_mutex_unlock(&self->symbols->mutex);
+    }
+
+    return true;
+}
+
+
+static bool xtb_client_trading_hours(XTB_Client * self, char * symbol, XTB_TradingHours * hours) {
+    if(xtb_client_cached_trading_hours(self, symbol, hours) == true) {
+        return true;
+    }
+
+    Json * result = xtb_client_get_trading_hours(self, 1, &symbol);
+    bool success  = xtb_client_store_trading_hours(self, symbol, result, hours);
+
+    json_delete(result);
+
+    return success;
+}
+
+
+/*
+ * walks back from end through trading sessions and returns the time in unix ms 
+ * where the sessions contain duration ms of trading
+ */
+static int64_t xtb_trading_window(const XTB_TradingHours * hours, int64_t end, int64_t duration) {
+    int64_t local = end + xtb_cet_offset(end);
+    int64_t day   = local - local % XTB_DAY;
+
+    if(hours->size == 0) {
+        return end - duration;
+    }
+
+    /*
+     * a week without any session can't be found, the limit only stops walking for symbols 
+     * with broken trading hours
+     */
+    for(int i = 0; i < 3660 && duration > 0; i++, local = day, day -= XTB_DAY) {
+        int weekday = (day / XTB_DAY + 4) % 7;
+
+        for(size_t j = 0; j < hours->size; j++) {
+            const XTB_TradingSegment * segment = &hours->segment[j];
+
+            if(segment->day != weekday) {
+                continue;
+            }
+
+            int64_t from = day + segment->from;
+            int64_t to   = day + segment->to < local ? day + segment->to : local;
+
+            if(to <= from) {
+                continue;
+            }
+
+            if(to - from >= duration) {
+                return xtb_cet_to_utc(to - duration);
+            }
+
+            duration -= to - from;
+        }
+    }
+
+    return xtb_cet_to_utc(day);
+}
+
+
+/*
+ * history is downloaded backwards in chunks which don't overlap, every chunk covers exactly 
+ * the trading time of still missing bars, so every bar is downloaded only once
+ */
+#define XTB_HISTORY_CHUNKS 16
+#define XTB_HISTORY_EMPTY_CHUNKS 2
+
+
+/*
+ * state of download shared by blocking and asynchronous functions, chunks are ordered 
+ * from the newest, size is the number of all received bars
+ */
+typedef struct {
+    XTB_TradingHours hours;
+    XTB_Period period;
+    size_t number;
+
+    Json * chunk[XTB_HISTORY_CHUNKS];
+    size_t chunks;
+    size_t size;
+    int empty;
+
+    int64_t start;
+    int64_t end;
+}XTB_HistoryFetch;
+
+
+static void xtb_history_fetch_init(XTB_HistoryFetch * self, XTB_Period period, size_t number) {
+    *self = (XTB_HistoryFetch) {
+        .period = period
+        , .number = number
+        , .end = xtb_time_ms()
+    };
+}
+
+
+/*
+ * plans window of the next chunk, returns false when no more chunk is needed
+ */
+static bool xtb_history_fetch_next(XTB_HistoryFetch * self) {
+    if(self->size >= self->number || self->chunks >= XTB_HISTORY_CHUNKS || self->empty >= XTB_HISTORY_EMPTY_CHUNKS) {
+        return false;
+    }
+
+    self->start = xtb_trading_window(&self->hours, self->end, (int64_t) (self->number - self->size) * self->period * 1000);
+
+    return true;
+}
+
+
+/*
+ * takes the received chunk, returns false if the response is broken
+ */
+static bool xtb_history_fetch_add(XTB_HistoryFetch * self, Json * chart) {
+    Json * rates = json_lookup(chart, "rateInfos");
+
+    if(json_is_type(chart, JsonObject) == false || json_is_type(rates, JsonArray) == false) {
+        __assert("command failed\n");
+        json_delete(chart);
+        return false;
+    }
+
+    if(rates->array.size == 0) {
+        json_delete(chart);
+        self->empty++;
+        self->end = self->start - 1000;
+        return true;
+    }
+
+    self->empty                 = 0;
+    self->chunk[self->chunks++] = chart;
+    self->size                 += rates->array.size;
+
+    /*
+     * the next chunk ends before the oldest received bar
+     */
+    self->end = json_lookup_integer(rates->array.value[0], "ctm") - 1000;
+
+    return true;
+}
+
+
+static void xtb_history_fetch_release(XTB_HistoryFetch * self) {
+    for(size_t i = 0; i < self->chunks; i++) {
+        json_delete(self->chunk[i]);
+    }
+
+    self->chunks = 0;
+}
+
+
+static void xtb_client_history_download(XTB_Client * self, char * symbol, XTB_HistoryFetch * fetch) {
+    xtb_client_trading_hours(self, symbol, &fetch->hours);
+
+    while(xtb_history_fetch_next(fetch) == true) {
+        Json * chart = xtb_client_get_chart_range_request(
+                            self, symbol, fetch->period, fetch->start / 1000, fetch->end / 1000, 0);
+
+        if(xtb_history_fetch_add(fetch, chart) == false) {
+            break;
+        }
+    }
+}
+
+
+/*
+ * chunks are ordered from the newest, the oldest surplus bars are skipped
+ */
+static Json * xtb_history_fetch_candles(XTB_HistoryFetch * self) {
+    size_t skip    = self->size > self->number ? self->size - self->number : 0;
+    size_t index   = 0;
+    Json * candles = json_array_new(self->size - skip);
+
+    for(size_t i = self->chunks; i > 0; i--) {
+        Json * rates = json_lookup(self->chunk[i - 1], "rateInfos");
+        int digits   = json_lookup_integer(self->chunk[i - 1], "digits");
+
+        for(size_t j = 0; j < rates->array.size; j++) {
+            if(skip > 0) {
+                skip--;
+                continue;
+            }
+
+            Json * candle_record = build_candle_record(rates->array.value[j], digits);
+
+            if(candle_record == NULL) {
+                __assert("error build candle record\n");
+                candle_record = json_object_new(0);
+            }
+
+            candles->array.value[index++] = candle_record;
+        }
+    }
+
+    xtb_history_fetch_release(self);
+
+    if(index == 0) {
+        json_delete(candles);
+        return NULL;
+    }
+
+    return candles;
+}
+
+
+Json * xtb_client_get_lastn_candle_history(XTB_Client * self, char * symbol, XTB_Period period, size_t number) {
+    XTB_HistoryFetch fetch;
+
+    xtb_history_fetch_init(&fetch, period, number);
+    xtb_client_history_download(self, symbol, &fetch);
+
+    return xtb_history_fetch_candles(&fetch);
+}
+
+
+/*
+ * columns are allocated in one block behind the series
+ */
+static XTB_CandleSeries * xtb_candle_series_new(const char * symbol, XTB_Period period, size_t size) {
+    XTB_CandleSeries * self = malloc(sizeof(XTB_CandleSeries) + size * (sizeof(int64_t) + 5 * sizeof(double)));
+
+    if(self == NULL) {
+        __assert("memory allocation error\n");
+        return NULL;
+    }
+
+    double * column = (double *) ((int64_t *) (self + 1) + size);
+
+    *self = (XTB_CandleSeries) {
+        .period = period
+        , .size = size
+        , .timestamp = (int64_t *) (self + 1)
+        , .open = column
+        , .high = column + size
+        , .low = column + 2 * size
+        , .close = column + 3 * size
+        , .vol = column + 4 * size
+    };
+
+    snprintf(self->symbol, XTB_SYMBOL_SIZE, "%s", symbol);
+
+    return self;
+}
+
+
+void xtb_candle_series_delete(XTB_CandleSeries * self) {
+    free(self);
+}
+
+
+/*
+ * server sends open price in points and the other prices relative to open, all of them are 
+ * converted in one pass without branches
+ */
+static void xtb_candle_series_scale(XTB_CandleSeries * self, size_t begin, size_t end, int digits) {
+    double factor           = pow(10, digits);
+    double * restrict open  = self->open;
+    double * restrict high  = self->high;
+    double * restrict low   = self->low;
+    double * restrict close = self->close;
+
+    for(size_t i = begin; i < end; i++) {
+        high[i]  = (open[i] + high[i]) / factor;
+        low[i]   = (open[i] + low[i]) / factor;
+        close[i] = (open[i] + close[i]) / factor;
+        open[i]  = open[i] / factor;
+    }
+}
+
+
+/*
+ * appends bars of chart behind index, skip number of the oldest bars is ignored
+ */
+static size_t xtb_candle_series_read(XTB_CandleSeries * self, size_t index, Json * chart, size_t skip) {
+    Json * rates = json_lookup(chart, "rateInfos");
+    size_t begin = index;
+
+    for(size_t i = skip; i < rates->array.size && index < self->size; i++, index++) {
+        Json * record = rates->array.value[i];
+
+        self->timestamp[index] = json_lookup_integer(record, "ctm");
+        self->open[index]      = json_lookup_number(record, "open");
+        self->high[index]      = json_lookup_number(record, "high");
+        self->low[index]       = json_lookup_number(record, "low");
+        self->close[index]     = json_lookup_number(record, "close");
+        self->vol[index]       = json_lookup_number(record, "vol");
+    }
+
+    xtb_candle_series_scale(self, begin, index, json_lookup_integer(chart, "digits"));
+
+    return index;
+}
+
+
+static XTB_CandleSeries * xtb_candle_series_from_chart(Json * chart, const char * symbol, XTB_Period period) {
+    Json * rates             = json_lookup(chart, "rateInfos");
+    XTB_CandleSeries * series = NULL;
+
+    if(json_is_type(rates, JsonArray) == false) {
+        __assert("response format error\n");
+    } else if((series = xtb_candle_series_new(symbol, period, rates->array.size)) != NULL) {
+        xtb_candle_series_read(series, 0, chart, 0);
+    }
+
+    json_delete(chart);
+
+    return series;
+}
+
+
+XTB_CandleSeries * xtb_client_get_chart_last_series(XTB_Client * self, char * symbol, XTB_Period period, time_t start) {
+    Json * chart = xtb_client_get_chart_last_request(self, symbol, period, start);
+    return chart != NULL ? xtb_candle_series_from_chart(chart, symbol, period) : NULL;
+}
+
+
+XTB_CandleSeries * xtb_client_get_chart_range_series(
+        XTB_Client * self, char * symbol, XTB_Period period, time_t start, time_t end, int32_t tick) {
+    Json * chart = xtb_client_get_chart_range_request(self, symbol, period, start, end, tick);
+    return chart != NULL ? xtb_candle_series_from_chart(chart, symbol, period) : NULL;
+}
+
+
+XTB_CandleSeries * xtb_client_get_lastn_candle_series(XTB_Client * self, char * symbol, XTB_Period period, size_t number) {
+    XTB_HistoryFetch fetch;
+
+    xtb_history_fetch_init(&fetch, period, number);
+    xtb_client_history_download(self, symbol, &fetch);
+
+    size_t skip               = fetch.size > number ? fetch.size - number : 0;
+    size_t index              = 0;
+    XTB_CandleSeries * series = fetch.size > 0 ? xtb_candle_series_new(symbol, period, fetch.size - skip) : NULL;
+
+    for(size_t i = fetch.chunks; i > 0; i--) {
+        Json * rates = json_lookup(fetch.chunk[i - 1], "rateInfos");
+        size_t part  = skip < rates->array.size ? skip : rates->array.size;
+
+        if(series != NULL) {
+            index = xtb_candle_series_read(series, index, fetch.chunk[i - 1], part);
+        }
+
+        skip -= part;
+    }
+
+    xtb_history_fetch_release(&fetch);
+
+    return series;
+}
+
+
+static const char * xtb_command_get_commision(char * buffer, char * symbol, float volume) {
+    snprintf(
+        buffer
+        , CMD_BUFFER_SIZE
+        , "{\"command\": \"getCommissionDef\", \"arguments\": {\"symbol\": \"%s\", \"volume\": %f}}"
+        , symbol
+        , volume);
+    
+    return buffer;
+}
+
+
+Json * xtb_client_get_commision(XTB_Client * self, char * symbol, float volume) {
+    Json * json_commision = xtb_client_transaction(
+                                self, xtb_command_get_commision(xtb_cmd_buffer, symbol, volume));
+
+    if(read_status(json_commision) == false) {
+        __assert("command failed\n");
+        json_delete(json_commision);
+        return NULL;
+    }
+    
+    return extract_return_data(json_commision);
+}
+
+
+static const char * xtb_command_get_commision_def(char * buffer, char * symbol, float volume) {
+    snprintf(
+        buffer
+        , CMD_BUFFER_SIZE
+        , "{\"command\": \"getCommissionDef\", \"arguments\": {\"symbol\": \"%s\", \"volume\": %f}}"
+        , symbol
+        , volume);
+
+    return buffer;
+}
+
+
+Json * xtb_client_get_commision_def(XTB_Client * self, char * symbol, float volume) {
+    Json * json_commision = xtb_client_transaction(
+                                self, xtb_command_get_commision_def(xtb_cmd_buffer, symbol, volume));
+
+    if(read_status(json_commision) == false) {
+        __assert("command failed\n");
+        json_delete(json_commision);
+        return NULL;
+    }
+    
+    return extract_return_data(json_commision);
+}
+
+
+Json * xtb_client_get_margin_level(XTB_Client * self) {
+    Json * json_margin = xtb_client_transaction(self, XTB_CMD_GET_MARGIN_LEVEL);
+
+    if(read_status(json_margin) == false) {
+        __assert("command failed\n");
+        json_delete(json_margin);
+        return NULL;
+    }
+    
+    return extract_return_data(json_margin);
+}
+
+
+static const char * xtb_command_get_margin_trade(char * buffer, char * symbol, float volume) {
+    snprintf(
+        buffer
+        , CMD_BUFFER_SIZE
+        , "{\"command\": \"getMarginTrade\", \"arguments\": {\"symbol\": \"%s\", \"volume\":%f}}"
+        , symbol
+        , volume);
+
+    return buffer;
+}
+
+
+Json * xtb_client_get_margin_trade(XTB_Client * self, char * symbol, float volume) {
+    Json * result = xtb_client_transaction(
+                        self, xtb_command_get_margin_trade(xtb_cmd_buffer, symbol, volume));
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+static const char * xtb_command_get_profit_calculation(
+        char * buffer, char * symbol, XTB_TransMode mode, float open_price, float close_price, float volume) {
+    snprintf(
+        buffer
+        , CMD_BUFFER_SIZE
+        , "{\"command\": \"getProfitCalculation\", \"arguments\": "
+          "{\"closePrice\": %f, \"cmd\": %d, \"openPrice\": %f, \"symbol\": \"%s\", \"volume\": %f}}"
+        , close_price
+        , mode
+        , open_price
+        , symbol
+        , volume);
+
+    return buffer;
+}
+
+
+Json * xtb_client_get_profit_calculation(
+        XTB_Client * self, float close_price, XTB_TransMode mode, float open_price, char * symbol, float volume) {
+    Json * result = xtb_client_transaction(
+                        self
+                        , xtb_command_get_profit_calculation(
+                            xtb_cmd_buffer, symbol, mode, open_price, close_price, volume));
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+Json * xtb_client_get_server_time(XTB_Client * self) {
+    Json * result = xtb_client_transaction(self, XTB_CMD_GET_SERVER_TIME);
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+static const char * xtb_command_get_symbol(char * buffer, char * symbol) {
+    snprintf(buffer, CMD_BUFFER_SIZE
+        , "{\"command\": \"getSymbol\", \"arguments\": {\"symbol\": \"%s\"}}"
+        , symbol);
+
+    return buffer;
+}
+
+
+Json * xtb_client_get_symbol(XTB_Client * self, char * symbol) {
+    Json * result = xtb_client_transaction(self, xtb_command_get_symbol(xtb_cmd_buffer, symbol));
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+static const char * xtb_command_get_tick_prices(
+        char * buffer, size_t size, char ** symbols, int price_level, time_t timestamp) {
+    size_t pos = snprintf(buffer, CMD_BUFFER_SIZE
+                    , "{\"command\": \"getTickPrices\", \"arguments\": "
+                      "{\"level\": %d, \"symbols\": ["
+                    , price_level);
+
+    for(size_t i = 0; i < size; i++) {
+        pos += snprintf(buffer + pos, CMD_BUFFER_SIZE - pos, i == 0 ? "\"%s\"" : ", \"%s\"", symbols[i]);
+    }
+
+    snprintf(buffer + pos, CMD_BUFFER_SIZE - pos, "], \"timestamp\": %ld}}", timestamp * 1000);
+
+    return buffer;
+}
+
+
+Json * xtb_client_get_tick_prices(
+        XTB_Client * self, size_t size, char ** symbols, int price_level, time_t timestamp) {
+    Json * result = xtb_client_transaction(
+                        self, xtb_command_get_tick_prices(xtb_cmd_buffer, size, symbols, price_level, timestamp));
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+static const char * xtb_command_get_news(char * buffer, time_t start, time_t end) {
+    snprintf(buffer, CMD_BUFFER_SIZE
+        , "{\"command\": \"getNews\", \"arguments\": {\"end\": %ld, \"start\": %ld}}"
+        , end, start);
+
+    return buffer;
+}
+
+
+Json * xtb_client_get_news(XTB_Client * self, time_t start, time_t end) {
+    Json * result = xtb_client_transaction(self, xtb_command_get_news(xtb_cmd_buffer, start, end));
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+Json * xtb_client_get_version(XTB_Client * self) {
+    Json * result = xtb_client_transaction(self, XTB_CMD_GET_VERSION);
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+static const char * xtb_command_get_trades(char * buffer, bool opened_only) {
+    snprintf(buffer, CMD_BUFFER_SIZE
+        , "{\"command\": \"getTrades\", \"arguments\": {\"openedOnly\": %s}}"
+        , opened_only ? "true" : "false");
+
+    return buffer;
+}
+
+
+Json * xtb_client_get_trades(XTB_Client * self, bool opened_only) {
+    Json * result = xtb_client_transaction(self, xtb_command_get_trades(xtb_cmd_buffer, opened_only));
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+static const char * xtb_command_get_trade_records(char * buffer, size_t size, char ** orders) {
+    size_t pos = snprintf(buffer, CMD_BUFFER_SIZE
+                    , "{\"command\": \"getTradeRecords\", \"arguments\": {\"orders\": [");
+
+    for(size_t i = 0; i < size; i++) {
+        pos += snprintf(buffer + pos, CMD_BUFFER_SIZE - pos, i == 0 ? "%s" : ", %s", orders[i]);
+    }
+
+    snprintf(buffer + pos, CMD_BUFFER_SIZE - pos, "]}}");
+
+    return buffer;
+}
+
+
+Json * xtb_client_get_trade_records(XTB_Client * self, size_t size, char ** orders) {
+    Json * result = xtb_client_transaction(
+                        self, xtb_command_get_trade_records(xtb_cmd_buffer, size, orders));
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+static const char * xtb_command_get_trade_history(char * buffer, time_t start, time_t end) {
+    snprintf(buffer, CMD_BUFFER_SIZE
+        , "{\"command\": \"getTradesHistory\", \"arguments\": {\"end\": %ld, \"start\": %ld}}"
+        , end * 1000, start * 1000);
+
+    return buffer;
+}
+
+
+Json * xtb_client_get_trade_history(XTB_Client * self, time_t start, time_t end) {
+    Json * result = xtb_client_transaction(self, xtb_command_get_trade_history(xtb_cmd_buffer, start, end));
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+static const char * xtb_command_trade_transaction_status(char * buffer, unsigned long order) {
+    snprintf(buffer, CMD_BUFFER_SIZE
+        , "{\"command\": \"tradeTransactionStatus\", \"arguments\": {\"order\": %ld}}"
+        , order);
+
+    return buffer;
+}
+
+
+Json * xtb_client_trade_transaction_status(XTB_Client * self, unsigned long order) {
+    Json * result = xtb_client_transaction(
+                        self, xtb_command_trade_transaction_status(xtb_cmd_buffer, order));
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+Json * xtb_client_get_user_data(XTB_Client * self) {
+    Json * result = xtb_client_transaction(self, XTB_CMD_GET_CURRENT_USER_DATA);
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+static const char * xtb_command_get_trading_hours(char * buffer, size_t size, char ** symbols) {
+    size_t pos = snprintf(buffer, CMD_BUFFER_SIZE
+                    , "{\"command\": \"getTradingHours\", \"arguments\": {\"symbols\": [");
+
+    for(size_t i = 0; i < size; i ++) {
+        pos += snprintf(buffer + pos, CMD_BUFFER_SIZE - pos, i == 0 ? "\"%s\"" : ", \"%s\"", symbols[i]);
+    }
+
+    snprintf(buffer + pos, CMD_BUFFER_SIZE - pos, "]}}");
+
+    return buffer;
+}
+
+
+Json * xtb_client_get_trading_hours(XTB_Client * self, size_t size, char ** symbols) {
+    Json * result = xtb_client_transaction(
+                        self, xtb_command_get_trading_hours(xtb_cmd_buffer, size, symbols));
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+Json * filter_market_day(Json * trading, uint8_t day) {
+    for(size_t i = 0; i < trading->array.size; i++) {
+        Json * json_day = json_lookup(trading->array.value[i], "day");
+        
+        if(json_is_type(json_day, JsonInteger) == true && (atoi(json_day->string) % 7) == day) {
+            return trading->array.value[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+static Json * check_market_status(Json * market_day, struct tm * current_time) {
+    if(market_day != NULL) {
+        Json * json_fromT = json_lookup(market_day, "fromT");
+        Json * json_toT = json_lookup(market_day, "toT");
+
+        if(json_is_type(json_fromT, JsonInteger) == true 
+                && json_is_type(json_toT, JsonInteger) == true) {
+            long fromT = strtol(json_fromT->string, NULL, 10);
+            long toT   = strtol(json_toT->string, NULL, 10);
+            long today = (current_time->tm_hour * 3600) + (current_time->tm_min * 60) + current_time->tm_sec * 1000;
+
+            if(today >= fromT && today <= toT) {
+                return json_bool_new(true);
+            } else {
+                return json_bool_new(false);
+            }
+        } 
+    }
+
+    return json_bool_new(false);
+}
+
+
+static Json * build_market_status(Json * market_record, struct tm * current_time) {
+    Json * trading = json_lookup(market_record, "trading");
+
+    if(json_is_type(trading, JsonArray) == false) {
+        return NULL;
+    }
+
+    Json * json_symbol = json_lookup(market_record, "symbol");
+
+    if(json_is_type(json_symbol, JsonString) == false) {
+        return NULL;
+    }
+
+    Json * market_day = filter_market_day(trading, current_time->tm_wday);
+    Json * market_status = json_object_new(1);
+    json_object_set_record(market_status, 0, json_symbol->string , check_market_status(market_day, current_time));
+
+    return market_status;
+}
+
+
+static Json * build_trading_status(Json * trading_hours) {
+    time_t now = time(NULL);
+    struct tm * current_time = localtime(&now);
+    Json * trading_status = json_array_new(trading_hours->array.size);
+
+    for(size_t i = 0; i < trading_hours->array.size; i++) {
+        Json * market_status = build_market_status(trading_hours->array.value[i], current_time);
+
+        if(market_status == NULL) {
+            __assert("response format error\n");
+            json_delete(trading_status);
+            return NULL;
+        }
+
+        trading_status->array.value[i] = market_status;
+    }
+
+    return trading_status;
+}
+
+
+Json * xtb_client_check_if_market_open(XTB_Client * self, size_t size, char ** symbols) {
+    Json * result = xtb_client_get_trading_hours(self, size, symbols);
+
+    if(json_is_type(result, JsonArray) == false) {
+        json_delete(result);
+        return NULL;
+    }
+
+    Json * trading_status = build_trading_status(result);
+    
+    json_delete(result);
+    return trading_status;
+}
+
+
+static const char * xtb_command_trade_transaction(
+        char * buffer, char * symbol, XTB_TransType type, XTB_TransMode mode, float price, float volume, int offset
+        , float sl, float tp, time_t expiration, char * order, char * custom_comment) {
+    size_t pos = snprintf(buffer, CMD_BUFFER_SIZE
+                    , "{\"command\": \"tradeTransaction\", \"arguments\": {\"tradeTransInfo\": {\"cmd\": %d", mode);
+
+    if(custom_comment != NULL) {
+        pos += snprintf(buffer + pos, CMD_BUFFER_SIZE - pos, ", \"customComment\": \"%s\"", custom_comment);
+    }
+
+    if(expiration != 0) {
+        pos += snprintf(buffer + pos, CMD_BUFFER_SIZE - pos, ", \"expiration\": %ld", expiration);
+    }
+
+    if(offset != 0) {
+        pos += snprintf(buffer + pos, CMD_BUFFER_SIZE - pos, ", \"offset\": %d", offset);
+    }
+
+    if(order != NULL) {
+        pos += snprintf(buffer + pos, CMD_BUFFER_SIZE - pos, ", \"order\": %s", order);
+    }
+
+    pos += snprintf(buffer + pos, CMD_BUFFER_SIZE - pos, ", \"price\": %f", price);
+
+    snprintf(
+        buffer + pos
+        , CMD_BUFFER_SIZE - pos
+        , ", \"sl\": %f, \"symbol\": \"%s\", \"tp\": %f, \"type\": %d, \"volume\": %f}}}"
+        , sl, symbol, tp, type, volume);
+
+    return buffer;
+}
+
+
+Json * xtb_client_trade_transaction(
+        XTB_Client * self, char * symbol, char * custom_comment, XTB_TransMode mode, time_t expiration, int offset
+        , char * order, float price, float tp, float sl, XTB_TransType type, float volume) {
+    int64_t submitted = xtb_clock_ns();
+    Json * result     = xtb_client_transaction(
+                        self
+                        , xtb_command_trade_transaction(
+                            xtb_cmd_buffer, symbol, type, mode, price, volume, offset, sl, tp, expiration, order, custom_comment));
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+
+    Json * data = extract_return_data(result);
+
+    xtb_client_track_result(self, data, submitted);
+    
+    return data;
+}   
+
+
+/*
+ * quotes older than this are not used for pricing of orders
+ */
+#define XTB_QUOTE_MAX_AGE 60000
+
+
+static bool read_quote_price(XTB_Client * self, const char * symbol, XTB_TransMode mode, float * price) {
+    XTB_Quote quote;
+
+    if(self->quotes == NULL 
+            || xtb_quote_table_read(self->quotes, symbol, 0, &quote) == false
+            || xtb_time_ms() - quote.timestamp > XTB_QUOTE_MAX_AGE) {
+        return false;
+    }
+
+    *price = mode == XTB_TransMode_BUY ? quote.ask : quote.bid;
+
+    return true;
+}
+
+
+/*
+ * reads the price for opening of position in given mode from symbol record
+ */
+static bool read_symbol_price(Json * symbol, XTB_TransMode mode, float * price) {
+    if(symbol == NULL) {
+        return false;
+    }
+
+    Json * json_price = json_lookup(symbol, mode == XTB_TransMode_BUY ? "ask" : "bid");
+
+    if(json_is_type(json_price, JsonFrac) == false) {
+        return false;
+    }
+
+    *price = atof(json_price->string);
+
+    return true;
+}
+
+
+Json * xtb_client_open_trade(XTB_Client * self, char * symbol, XTB_TransMode mode, float volume, float tp, float sl) {
+    if(mode != XTB_TransMode_BUY && mode != XTB_TransMode_SELL) {
+        __assert("mode can be buy or sell\n");
+        return NULL;
+    }
+
+    float price;
+
+    /*
+     * the symbol is loaded from server only if its quote isn't streamed
+     */
+    if(read_quote_price(self, symbol, mode, &price) == false) {
+        Json * candle = xtb_client_get_symbol(self, symbol);
+
+        if(read_symbol_price(candle, mode, &price) == false) {
+            __assert("response format error\n");
+            json_delete(candle);
+            return NULL;
+        }
+
+        json_delete(candle);
+    }
+
+    Json * result = 
+        xtb_client_trade_transaction(
+                self, symbol, NULL, mode, 0, 0, NULL, price, tp, sl, XTB_TransType_OPEN, volume);
+
+    return result;
+}
+
+
+Json * xtb_client_open_trade_by_id(XTB_Client * self, XTB_SymbolId id, XTB_TransMode mode, float volume, float tp, float sl) {
+    const char * symbol = xtb_symbol_name(id);
+    return symbol != NULL ? xtb_client_open_trade(self, (char *) symbol, mode, volume, tp, sl) : NULL;
+}
+
+
+Json * xtb_client_close_trade(
+        XTB_Client * self, char * symbol, char * order, XTB_TransMode mode, float price, float volume) {
+    return xtb_client_trade_transaction(self, symbol, NULL, mode, 0, 0, order, price, 0, 0, XTB_TransType_CLOSE, volume);
+}
+
+
+static void xtb_symbol_spec_from_json(Json * json, XTB_SymbolSpec * spec) {
+    *spec = (XTB_SymbolSpec) {
+        .contract_size = json_lookup_number(json, "contractSize")
+        , .tick_size = json_lookup_number(json, "tickSize")
+        , .tick_value = json_lookup_number(json, "tickValue")
+        , .leverage = json_lookup_number(json, "leverage")
+        , .bid = json_lookup_number(json, "bid")
+        , .ask = json_lookup_number(json, "ask")
+        , .precision = json_lookup_integer(json, "precision")
+        , .margin_mode = json_lookup_integer(json, "marginMode")
+        , .profit_mode = json_lookup_integer(json, "profitMode")
+    };
+
+    json_lookup_string(json, "symbol", spec->symbol, XTB_SYMBOL_SIZE);
+    json_lookup_string(json, "currency", spec->currency, XTB_CURRENCY_SIZE);
+    json_lookup_string(json, "currencyProfit", spec->currency_profit, XTB_CURRENCY_SIZE);
+}
+
+
+static bool xtb_client_load_currency(XTB_Client * self) {
+    Json * user_data = xtb_client_get_user_data(self);
+
+    if(user_data == NULL) {
+        return false;
+    }
+
+    pthread_mutex_lock(&self->symbols->mutex);
+    json_lookup_string(user_data, "currency", self->symbols->currency, XTB_CURRENCY_SIZE);
+    pthread_mutex_unlock(&self->symbols->mutex);
+
+    json_delete(user_data);
+
+    return true;
+}
+
+
+bool xtb_client_load_symbol_specs(XTB_Client * self) {
+    Json * symbols = xtb_client_get_all_symbols(self);
+    XTB_SymbolSpec spec;
+
+    if(json_is_type(symbols, JsonArray) == false) {
+        json_delete(symbols);
+        return false;
+    }
+
+    pthread_mutex_lock(&self->symbols->mutex);
+
+    for(size_t i = 0; i < symbols->array.size; i++) {
+        xtb_symbol_spec_from_json(symbols->array.value[i], &spec);
+        xtb_symbol_cache_put(self->symbols, &spec);
+    }
+
+    pthread_mutex_unlock(&self->symbols->mutex);
+
+    json_delete(symbols);
+
+    return xtb_client_load_currency(self);
+}
+
+
+bool xtb_client_get_symbol_spec(XTB_Client * self, const char * symbol, XTB_SymbolSpec * spec) {
+    pthread_mutex_lock(&self->symbols->mutex);
+
+    const XTB_SymbolSpec * cached = xtb_symbol_cache_find(self->symbols, symbol);
+
+    if(cached != NULL) {
+        *spec = *cached;
+    }
+
+    pthread_mutex_unlock(&self->symbols->mutex);
+
+    if(cached != NULL) {
+        return true;
+    }
+
+    Json * record = xtb_client_get_symbol(self, (char *) symbol);
+
+    if(record == NULL) {
+        return false;
+    }
+
+    xtb_symbol_spec_from_json(record, spec);
+    json_delete(record);
+
+    pthread_mutex_lock(&self->symbols->mutex);
+    xtb_symbol_cache_put(self->symbols, spec);
+    pthread_mutex_unlock(&self->symbols->mutex);
+
+    return true;
+}
+
+
+/*
+ * margin of forex symbols is counted from nominal value in base currency, 
+ * margin of other symbols from the price in profit currency
+ */
+#define XTB_MARGIN_MODE_FOREX 101
+
+
+/*
+ * everything needed for valuation of positions in one symbol in currency of account
+ */
+typedef struct {
+    double bid;
+    double ask;
+    double contract_size;
+    double leverage;
+    double profit_rate;
+    double margin_rate;
+    bool forex;
+}XTB_SymbolFactors;
+
+
+/*
+ * streamed quote is preferred, price from the specification is used otherwise
+ */
+static bool xtb_symbol_price(
+        XTB_Client * self, const XTB_SymbolSpec * spec, const char * symbol, double * bid, double * ask) {
+    XTB_Quote quote;
+
+    if(self->quotes != NULL
+            && xtb_quote_table_read(self->quotes, symbol, 0, &quote) == true
+            && xtb_time_ms() - quote.timestamp <= XTB_QUOTE_MAX_AGE) {
+        *bid = quote.bid;
+        *ask = quote.ask;
+        return true;
+    }
+
+    if(spec == NULL || spec->bid <= 0 || spec->ask <= 0) {
+        return false;
+    }
+
+    *bid = spec->bid;
+    *ask = spec->ask;
+
+    return true;
+}
+
+
+/*
+ * rate from currency into account currency by direct or inverse currency pair, symbols cache has
+ * to be locked, missing rate is returned as false, the library is built with fast math, so NAN 
+ * can't be detected
+ */
+static bool xtb_currency_rate(XTB_Client * self, const char * currency, double * rate) {
+    char symbol[XTB_SYMBOL_SIZE];
+    double bid;
+    double ask;
+
+    if(strcmp(currency, self->symbols->currency) == 0) {
+        *rate = 1;
+        return true;
+    }
+
+    snprintf(symbol, XTB_SYMBOL_SIZE, "%s%s", currency, self->symbols->currency);
+
+    if(xtb_symbol_price(self, xtb_symbol_cache_find(self->symbols, symbol), symbol, &bid, &ask) == true) {
+        *rate = bid;
+        return true;
+    }
+
+    snprintf(symbol, XTB_SYMBOL_SIZE, "%s%s", self->symbols->currency, currency);
+
+    if(xtb_symbol_price(self, xtb_symbol_cache_find(self->symbols, symbol), symbol, &bid, &ask) == true) {
+        *rate = 1 / ask;
+        return true;
+    }
+
+    return false;
+}
+
+
+/*
+ * symbols cache has to be locked
+ */
+static bool xtb_symbol_factors(XTB_Client * self, const char * symbol, XTB_SymbolFactors * factors) {
+    const XTB_SymbolSpec * spec = xtb_symbol_cache_find(self->symbols, symbol);
+
+    if(spec == NULL || self->symbols->currency[0] == '\0') {
+        return false;
+    }
+
+    *factors = (XTB_SymbolFactors) {
+        .contract_size = spec->contract_size
+        , .leverage = spec->leverage / 100
+        , .forex = spec->margin_mode == XTB_MARGIN_MODE_FOREX
+    };
+
+    if(xtb_currency_rate(self, spec->currency_profit, &factors->profit_rate) == false) {
+        return false;
+    }
+
+    if(factors->forex == false) {
+        factors->margin_rate = factors->profit_rate;
+    } else if(xtb_currency_rate(self, spec->currency, &factors->margin_rate) == false) {
+        return false;
+    }
+
+    return xtb_symbol_price(self, spec, symbol, &factors->bid, &factors->ask);
+}
+
+
+static bool xtb_client_symbol_factors(XTB_Client * self, const char * symbol, XTB_SymbolFactors * factors) {
+    XTB_SymbolSpec spec;
+
+    if(xtb_client_get_symbol_spec(self, symbol, &spec) == false
+            || (self->symbols->currency[0] == '\0' && xtb_client_load_currency(self) == false)) {
+        return false;
+    }
+
+    pthread_mutex_lock(&self->symbols->mutex);
+    bool result = xtb_symbol_factors(self, symbol, factors);
+    pthread_mutex_unlock(&self->symbols->mutex);
+
+    return result;
+}
+
+
+bool xtb_client_calculate_profit(
+        XTB_Client * self, const char * symbol, XTB_TransMode mode
+        , double open_price, double close_price, double volume, double * profit) {
+    XTB_SymbolFactors factors;
+
+    if(xtb_client_symbol_factors(self, symbol, &factors) == false) {
+        return false;
+    }
+
+    double sign = mode == XTB_TransMode_BUY ? 1 : -1;
+    *profit     = sign * (close_price - open_price) * volume * factors.contract_size * factors.profit_rate;
+
+    return true;
+}
+
+
+bool xtb_client_calculate_margin(XTB_Client * self, const char * symbol, double volume, double * margin) {
+    XTB_SymbolFactors factors;
+
+    if(xtb_client_symbol_factors(self, symbol, &factors) == false) {
+        return false;
+    }
+
+    double price = factors.forex == true ? 1 : (factors.bid + factors.ask) / 2;
+    *margin      = volume * factors.contract_size * price * factors.leverage * factors.margin_rate;
+
+    return true;
+}
+
+
+#define XTB_VALUE_BATCH 64
+
+
+/*
+ * factors of positions are resolved into columns at first, so the valuation 
+ * itself is a plain loop over arrays which compiler can vectorize
+ */
+size_t xtb_client_value_positions(
+        XTB_Client * self, const XTB_TradeRecord * position, size_t size, XTB_PositionValue * value) {
+    double sign[XTB_VALUE_BATCH];
+    double open[XTB_VALUE_BATCH];
+    double mark[XTB_VALUE_BATCH];
+    double lot[XTB_VALUE_BATCH];
+    double margin_price[XTB_VALUE_BATCH];
+    double margin_factor[XTB_VALUE_BATCH];
+    double profit_rate[XTB_VALUE_BATCH];
+    double profit[XTB_VALUE_BATCH];
+    double margin[XTB_VALUE_BATCH];
+    bool valid[XTB_VALUE_BATCH];
+    XTB_SymbolFactors factors = {0};
+    const char * symbol = NULL;
+    bool resolved       = false;
+    size_t valued       = 0;
+
+    for(size_t begin = 0; begin < size; begin += XTB_VALUE_BATCH) {
+        size_t batch = size - begin < XTB_VALUE_BATCH ? size - begin : XTB_VALUE_BATCH;
+
+        pthread_mutex_lock(&self->symbols->mutex);
+
+        for(size_t i = 0; i < batch; i++) {
+            const XTB_TradeRecord * trade = &position[begin + i];
+
+            /*
+             * positions of the same symbol usually follow each other
+             */
+            if(symbol == NULL || strcmp(symbol, trade->symbol) != 0) {
+                symbol   = trade->symbol;
+                resolved = xtb_symbol_factors(self, symbol, &factors);
+            }
+
+            /*
+             * positions which can't be valued get zero values, so the vectorized loop 
+             * doesn't compute with leftovers of other symbol
+             */
+            bool market = resolved == true 
+                            && (trade->cmd == XTB_TransMode_BUY || trade->cmd == XTB_TransMode_SELL);
+
+            sign[i]          = trade->cmd == XTB_TransMode_BUY ? 1 : -1;
+            open[i]          = resolved == true ? trade->open_price : 0;
+            mark[i]          = resolved == false ? 0 : trade->cmd == XTB_TransMode_BUY ? factors.bid : factors.ask;
+            lot[i]           = market == true ? trade->volume * factors.contract_size : 0;
+            margin_price[i]  = factors.forex == true ? 1 : mark[i];
+            margin_factor[i] = resolved == true ? factors.leverage * factors.margin_rate : 0;
+            profit_rate[i]   = resolved == true ? factors.profit_rate : 0;
+            valid[i]         = resolved;
+
+            valued += resolved == true;
+        }
+
+        pthread_mutex_unlock(&self->symbols->mutex);
+
+        for(size_t i = 0; i < batch; i++) {
+            profit[i] = sign[i] * (mark[i] - open[i]) * lot[i] * profit_rate[i];
+            margin[i] = lot[i] * margin_price[i] * margin_factor[i];
+        }
+
+        for(size_t i = 0; i < batch; i++) {
+            value[begin + i] = (XTB_PositionValue) {
+                .price = mark[i]
+                , .profit = profit[i]
+                , .margin = margin[i]
+                , .valid = valid[i]
+            };
+        }
+
+        symbol = NULL;
+    }
+
+    return valued;
+}
+
+
+/*
+ * catalog is downloaded by separate connection, so the refresh doesn't block 
+ * requests of the client and doesn't need client to be thread safe
+ */
+static void * xtb_symbol_catalog_refresh(void * param) {
+    XTB_Client * self   = param;
+    XTB_Client * client = xtb_client_new(self->mode, self->id, self->password);
+
+    if(client != NULL && xtb_client_logged(client) == true && xtb_client_load_symbol_specs(client) == true) {
+        XTB_SymbolCache * cache = self->symbols;
+        XTB_SymbolCache * fresh = client->symbols;
+
+        if(xtb_symbol_cache_save(fresh, cache->path, xtb_time_ms()) == false) {
+            __assert("symbol catalog can't be saved\n");
+        }
+
+        pthread_mutex_lock(&cache->mutex);
+
+        XTB_SymbolSpec * slot = cache->slot;
+
+        cache->slot = fresh->slot;
+        cache->mask = fresh->mask;
+        cache->size = fresh->size;
+        memcpy(cache->currency, fresh->currency, XTB_CURRENCY_SIZE);
+
+        pthread_mutex_unlock(&cache->mutex);
+
+        fresh->slot = slot;
+    } else {
+        __assert("symbol catalog refresh failed\n");
+    }
+
+    xtb_client_delete(client);
+
+    return NULL;
+}
+
+
+bool xtb_client_open_symbol_catalog(XTB_Client * self, const char * path, int64_t max_age) {
+    XTB_SymbolCache * cache = self->symbols;
+
+    if(cache->refreshing == true) {
+        __assert("symbol catalog is already refreshing\n");
+        return false;
+    }
+
+    free(cache->path);
+
+    if((cache->path = strdup(path)) == NULL) {
+        return false;
+    }
+
+    int64_t updated = xtb_symbol_cache_load(cache, path);
+
+    if(updated >= 0 && xtb_time_ms() - updated < max_age) {
+        return true;
+    }
+
+    cache->refreshing = pthread_create(&cache->refresh, NULL, xtb_symbol_catalog_refresh, self) == 0;
+
+    return updated >= 0 || cache->refreshing == true;
+}
+
+
+void xtb_client_wait_symbol_catalog(XTB_Client * self) {
+    if(self->symbols != NULL && self->symbols->refreshing == true) {
+        pthread_join(self->symbols->refresh, NULL);
+        self->symbols->refreshing = false;
+    }
+}
+
+
+size_t xtb_client_symbol_catalog_size(XTB_Client * self) {
+    pthread_mutex_lock(&self->symbols->mutex);
+    size_t size = self->symbols->size;
+    pthread_mutex_unlock(&self->symbols->mutex);
+
+    return size;
+}
+
+
+Json * xtb_client_get_step_rules(XTB_Client * self) {
+    Json * result = xtb_client_transaction(self, XTB_CMD_GET_STEP_RULES);
+
+    if(read_status(result) == false) {
+        __assert("command failed\n");
+        json_delete(result);
+        return NULL;
+    }
+    
+    return extract_return_data(result);
+}
+
+
+void xtb_client_delete(XTB_Client * self) {
+    if(self != NULL) {
+        xtb_client_stop_io_thread(self);
+        xtb_client_wait_symbol_catalog(self);
+
+        if(self->stream_session_id != NULL)
+            xtb_client_logout(self);
+
+        free(self->stream_session_id);
+
+        if(self->id != NULL)
+            free(self->id);
+
+        if(self->password != NULL)
+            free(self->password);
+
+        /*
+         * close and release stream clients
+         */
+        while(self->stream_client != NULL) {
+            xtb_stream_client_delete(self->stream_client);
+        }
+
+        /*
+         * requests still waiting for response are completed as failed
+         */
+        xtb_client_cancel(self);
+        xtb_connect_release(self->relogin);
+
+        while(self->unused != NULL) {
+            XTB_Request * next = self->unused->next;
+
+            free(self->unused);
+            self->unused = next;
+        }
+
+        xtb_quote_table_delete(self->quotes);
+        xtb_order_tracker_delete(self->orders);
+        xtb_position_book_delete(self->positions);
+        xtb_symbol_cache_delete(self->symbols);
+
+        xtb_api_close(&self->api);
+
+        free(self);
+    }
+}
+
+
+struct XTB_ClientPool {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    size_t size;
+    XTB_Client ** clients;
+
+    /*
+     * idle connections in order of release, so the connection which rests 
+     * the longest time is used first and the request spacing is kept
+     */
+    size_t begin;
+    size_t idle;
+    XTB_Client ** queue;
+};
+
+
+XTB_ClientPool * xtb_client_pool_new(XTB_AccountMode mode, char * id, char * password, size_t size) {
+    if(size == 0) {
+        return NULL;
+    }
+
+    XTB_ClientPool * self = calloc(1, sizeof(XTB_ClientPool) + sizeof(XTB_Client*) * size * 2);
+
+    self->size    = size;
+    self->clients = (XTB_Client**) (self + 1);
+    self->queue   = self->clients + size;
+
+    pthread_mutex_init(&self->mutex, NULL);
+    pthread_cond_init(&self->cond, NULL);
+
+    for(size_t i = 0; i < size; i++) {
+        XTB_Client * client = xtb_client_new(mode, id, password);
+
+        if(client == NULL || xtb_client_logged(client) == false) {
+            xtb_client_delete(client);
+            xtb_client_pool_delete(self);
+            return NULL;
+        }
+
+        self->clients[i] = client;
+        self->queue[self->idle++] = client;
+    }
+
+    return self;
+}
+
+
+size_t xtb_client_pool_size(XTB_ClientPool * self) {
+    return self->size;
+}
+
+
+static XTB_Client * xtb_client_pool_take(XTB_ClientPool * self) {
+    XTB_Client * client = self->queue[self->begin];
+
+    self->begin = (self->begin + 1) % self->size;
+    self->idle--;
+
+    return client;
+}
+
+
+XTB_Client * xtb_client_pool_acquire(XTB_ClientPool * self) {
+    pthread_mutex_lock(&self->mutex);
+
+    while(self->idle == 0) {
+        pthread_cond_wait(&self->cond, &self->mutex);
+    }
+
+    XTB_Client * client = xtb_client_pool_take(self);
+
+    pthread_mutex_unlock(&self->mutex);
+
+    return client;
+}
+
+
+XTB_Client * xtb_client_pool_try_acquire(XTB_ClientPool * self) {
+    XTB_Client * client = NULL;
+
+    pthread_mutex_lock(&self->mutex);
+
+    if(self->idle > 0) {
+        client = xtb_client_pool_take(self);
+    }
+
+    pthread_mutex_unlock(&self->mutex);
+
+    return client;
+}
+
+
+void xtb_client_pool_release(XTB_ClientPool * self, XTB_Client * client) {
+    pthread_mutex_lock(&self->mutex);
+
+    if(self->idle < self->size) {
+        self->queue[(self->begin + self->idle++) % self->size] = client;
+        pthread_cond_signal(&self->cond);
+    } else {
+        __assert("client released more times than acquired\n");
+    }
+
+    pthread_mutex_unlock(&self->mutex);
+}
+
+
+void xtb_client_pool_delete(XTB_ClientPool * self) {
+    if(self != NULL) {
+        for(size_t i = 0; i < self->size; i++) {
+            xtb_client_delete(self->clients[i]);
+        }
+
+        pthread_cond_destroy(&self->cond);
+        pthread_mutex_destroy(&self->mutex);
+
+        free(self);
+    }
+}
+
+
+typedef struct {
+    XTB_Pipeline * pipeline;
+    Json * data;
+}XTB_PipelineResult;
+
+
+struct XTB_Pipeline {
+    XTB_Client * client;
+    XTB_Wait wait;
+
+    /*
+     * commands are stored one behind another separated by '\0'
+     */
+    XTB_Buffer commands;
+    size_t size;
+
+    XTB_PipelineResult * result;
+};
+
+
+XTB_Pipeline * xtb_pipeline_new(XTB_Client * client) {
+    XTB_Pipeline * self = malloc(sizeof(XTB_Pipeline));
+
+    *self = (XTB_Pipeline) {
+        .client = client
+    };
+
+    return self;
+}
+
+
+/*
+ * SIZE_MAX is returned when the command can't be stored, the size of pipeline would be index 
+ * of the next stored command
+ */
+static size_t xtb_pipeline_push(XTB_Pipeline * self, const char * cmd) {
+    size_t length = strlen(cmd) + 1;
+
+    if(xtb_buffer_reserve(&self->commands, length) == false) {
+        __assert("pipeline allocation error\n");
+        return SIZE_MAX;
+    }
+
+    memcpy(self->commands.data + self->commands.end, cmd, length);
+    self->commands.end += length;
+
+    return self->size++;
+}
+
+
+size_t xtb_pipeline_size(XTB_Pipeline * self) {
+    return self->size;
+}
+
+
+size_t xtb_pipeline_get_all_symbols(XTB_Pipeline * self) {
+    return xtb_pipeline_push(self, XTB_CMD_GET_ALL_SYMBOLS);
+}
+
+
+size_t xtb_pipeline_get_calendar(XTB_Pipeline * self) {
+    return xtb_pipeline_push(self, XTB_CMD_GET_CALENDAR);
+}
+
+
+size_t xtb_pipeline_get_chart_last_request(XTB_Pipeline * self, char * symbol, XTB_Period period, time_t start) {
+    return xtb_pipeline_push(self, xtb_command_get_chart_last_request(xtb_cmd_buffer, symbol, period, start));
+}
+
+
+size_t xtb_pipeline_get_chart_range_request(
+        XTB_Pipeline * self, char * symbol, XTB_Period period, time_t start, time_t end, int32_t tick) {
+    return xtb_pipeline_push(
+                self, xtb_command_get_chart_range_request(xtb_cmd_buffer, symbol, period, start, end, tick));
+}
+
+
+size_t xtb_pipeline_get_commision(XTB_Pipeline * self, char * symbol, float volume) {
+    return xtb_pipeline_push(self, xtb_command_get_commision(xtb_cmd_buffer, symbol, volume));
+}
+
+
+size_t xtb_pipeline_get_commision_def(XTB_Pipeline * self, char * symbol, float volume) {
+    return xtb_pipeline_push(self, xtb_command_get_commision_def(xtb_cmd_buffer, symbol, volume));
+}
+
+
+size_t xtb_pipeline_get_margin_level(XTB_Pipeline * self) {
+    return xtb_pipeline_push(self, XTB_CMD_GET_MARGIN_LEVEL);
+}
+
+
+size_t xtb_pipeline_get_margin_trade(XTB_Pipeline * self, char * symbol, float volume) {
+    return xtb_pipeline_push(self, xtb_command_get_margin_trade(xtb_cmd_buffer, symbol, volume));
+}
+
+
+size_t xtb_pipeline_get_profit_calculation(
+        XTB_Pipeline * self, float close_price, XTB_TransMode mode, float open_price, char * symbol, float volume) {
+    return xtb_pipeline_push(
+                self
+                , xtb_command_get_profit_calculation(xtb_cmd_buffer, symbol, mode, open_price, close_price, volume));
+}
+
+
+size_t xtb_pipeline_get_server_time(XTB_Pipeline * self) {
+    return xtb_pipeline_push(self, XTB_CMD_GET_SERVER_TIME);
+}
+
+
+size_t xtb_pipeline_get_symbol(XTB_Pipeline * self, char * symbol) {
+    return xtb_pipeline_push(self, xtb_command_get_symbol(xtb_cmd_buffer, symbol));
+}
+
+
+size_t xtb_pipeline_get_tick_prices(
+        XTB_Pipeline * self, size_t size, char ** symbols, int price_level, time_t timestamp) {
+    return xtb_pipeline_push(
+                self, xtb_command_get_tick_prices(xtb_cmd_buffer, size, symbols, price_level, timestamp));
+}
+
+
+size_t xtb_pipeline_get_news(XTB_Pipeline * self, time_t start, time_t end) {
+    return xtb_pipeline_push(self, xtb_command_get_news(xtb_cmd_buffer, start, end));
+}
+
+
+size_t xtb_pipeline_get_version(XTB_Pipeline * self) {
+    return xtb_pipeline_push(self, XTB_CMD_GET_VERSION);
+}
+
+
+size_t xtb_pipeline_get_trades(XTB_Pipeline * self, bool opened_only) {
+    return xtb_pipeline_push(self, xtb_command_get_trades(xtb_cmd_buffer, opened_only));
+}
+
+
+size_t xtb_pipeline_get_trade_records(XTB_Pipeline * self, size_t size, char ** orders) {
+    return xtb_pipeline_push(self, xtb_command_get_trade_records(xtb_cmd_buffer, size, orders));
+}
+
+
+size_t xtb_pipeline_get_trade_history(XTB_Pipeline * self, time_t start, time_t end) {
+    return xtb_pipeline_push(self, xtb_command_get_trade_history(xtb_cmd_buffer, start, end));
+}
+
+
+size_t xtb_pipeline_trade_transaction_status(XTB_Pipeline * self, unsigned long order) {
+    return xtb_pipeline_push(self, xtb_command_trade_transaction_status(xtb_cmd_buffer, order));
+}
+
+
+size_t xtb_pipeline_get_user_data(XTB_Pipeline * self) {
+    return xtb_pipeline_push(self, XTB_CMD_GET_CURRENT_USER_DATA);
+}
+
+
+size_t xtb_pipeline_get_trading_hours(XTB_Pipeline * self, size_t size, char ** symbols) {
+    return xtb_pipeline_push(self, xtb_command_get_trading_hours(xtb_cmd_buffer, size, symbols));
+}
+
+
+size_t xtb_pipeline_get_step_rules(XTB_Pipeline * self) {
+    return xtb_pipeline_push(self, XTB_CMD_GET_STEP_RULES);
+}
+
+
+static void xtb_pipeline_complete(XTB_Request * request, XTB_Error error, Json * response) {
+    XTB_PipelineResult * result = request->param;
+
+    (void) error;
+
+    if(read_status(response) == true) {
+        result->data = extract_return_data(response);
+    } else {
+        __assert("command failed\n");
+        json_delete(response);
+    }
+
+    xtb_wait_done(&result->pipeline->wait);
+}
+
+
+static void xtb_pipeline_release_result(XTB_Pipeline * self) {
+    if(self->result != NULL) {
+        for(size_t i = 0; i < self->size; i++) {
+            json_delete(self->result[i].data);
+        }
+
+        free(self->result);
+        self->result = NULL;
+    }
+}
+
+
+bool xtb_pipeline_execute(XTB_Pipeline * self) {
+    xtb_pipeline_release_result(self);
+
+    self->result  = malloc(sizeof(XTB_PipelineResult) * (self->size > 0 ? self->size : 1));
+    xtb_wait_init(&self->wait, self->client);
+
+    /*
+     * all commands are sent at once and the responses are matched 
+     * to the commands by customTag
+     */
+    const char * cmd = self->commands.data;
+
+    for(size_t i = 0; i < self->size; i++) {
+        self->result[i] = (XTB_PipelineResult) {
+            .pipeline = self
+        };
+
+        xtb_wait_add(&self->wait);
+
+        if(xtb_client_submit(self->client, cmd, xtb_pipeline_complete, NULL, &self->result[i]) == false) {
+            xtb_wait_done(&self->wait);
+        }
+
+        cmd += strlen(cmd) + 1;
+    }
+
+    xtb_wait_finish(&self->wait);
+
+    for(size_t i = 0; i < self->size; i++) {
+        if(self->result[i].data == NULL) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+Json * xtb_pipeline_result(XTB_Pipeline * self, size_t index) {
+    if(self->result == NULL || index >= self->size) {
+        return NULL;
+    }
+
+    Json * data = self->result[index].data;
+    self->result[index].data = NULL;
+
+    return data;
+}
+
+
+void xtb_pipeline_clear(XTB_Pipeline * self) {
+    xtb_pipeline_release_result(self);
+
+    self->commands.begin = self->commands.end = self->commands.scan = 0;
+    self->size = 0;
+}
+
+
+void xtb_pipeline_delete(XTB_Pipeline * self) {
+    if(self != NULL) {
+        xtb_pipeline_release_result(self);
+        xtb_buffer_delete(&self->commands);
+        free(self);
+    }
+}
+
+
+int xtb_client_fd(XTB_Client * self) {
+    return self->api.fd;
+}
+
+
+bool xtb_client_process(XTB_Client * self) {
+    if(atomic_load(&self->io_running) == true) {
+        __assert("connection is processed by I/O thread\n");
+        return false;
+    }
+
+    xtb_client_release(self);
+
+    return xtb_client_poll(self);
+}
+
+
+/*
+ * event loop sends requests held back when their time comes
+ */
+static bool xtb_client_check(void * param) {
+    xtb_client_release(param);
+    return true;
+}
+
+
+static int xtb_client_timer(void * param) {
+    return xtb_client_timeout(param);
+}
+
+
+static void xtb_submission_fail(XTB_Submission * submission) {
+    XTB_Request request = {
+        .complete = submission->complete
+        , .callback = submission->callback
+        , .param = submission->param
+    };
+
+    request.complete(&request, XTB_Error_Connection, NULL);
+    free(submission);
+}
+
+
+static void * xtb_client_io_thread(void * param) {
+    XTB_Client * self = param;
+    bool connected    = true;
+    uint64_t wake;
+
+    /*
+     * waits until the identifier of thread is published by the creator
+     */
+    while(atomic_load(&self->io_running) == false) {
+        poll(&(struct pollfd) {.fd = self->wake_fd, .events = POLLIN}, 1, -1);
+    }
+
+    while(atomic_load(&self->io_stop) == false) {
+        struct pollfd pfd[2] = {
+            {.fd = self->wake_fd, .events = POLLIN}
+            , {.fd = connected == true ? self->api.fd : -1, .events = POLLIN}
+        };
+
+        /*
+         * the thread wakes up also when the spacing allows to send requests held back
+         */
+        if(xtb_buffer_has_frame(&self->api.rcv) == false && poll(pfd, 2, xtb_client_timeout(self)) < 0) {
+            continue;
+        }
+
+        if((pfd[0].revents & POLLIN) != 0 && read(self->wake_fd, &wake, sizeof(wake)) < 0) {
+            __assert("I/O thread wake up error\n");
+        }
+
+        xtb_client_release(self);
+
+        /*
+         * commands submitted from other threads are sent in order of submission
+         */
+        XTB_Submission * submission;
+
+        while((submission = xtb_submission_queue_pop(&self->queue)) != NULL) {
+            if(xtb_client_send_request(
+                    self, submission->cmd, submission->complete, submission->callback, submission->param) == false) {
+                xtb_submission_fail(submission);
+            } else {
+                free(submission);
+            }
+        }
+
+        if(connected == true && (pfd[1].revents != 0 || xtb_buffer_has_frame(&self->api.rcv) == true)) {
+            if((connected = xtb_client_poll(self)) == false) {
+                __assert("connection failed\n");
+            }
+        }
+    }
+
+    return NULL;
+}
+
+
+bool xtb_client_start_io_thread(XTB_Client * self) {
+    if(atomic_load(&self->io_running) == true) {
+        return true;
+    }
+
+    if(self->api.loop != NULL) {
+        __assert("client is driven by event loop\n");
+        return false;
+    }
+
+    if((self->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0) {
+        __assert("eventfd create error\n");
+        return false;
+    }
+
+    xtb_submission_queue_init(&self->queue);
+    atomic_store(&self->io_stop, false);
+
+    if(pthread_create(&self->io_thread, NULL, xtb_client_io_thread, self) != 0) {
+        __assert("I/O thread create error\n");
+        close(self->wake_fd);
+        return false;
+    }
+
+    uint64_t wake = 1;
+
+    atomic_store(&self->io_running, true);
+
+    if(write(self->wake_fd, &wake, sizeof(wake)) < 0) {
+        __assert("I/O thread wake up error\n");
+    }
+
+    return true;
+}
+
+
+void xtb_client_stop_io_thread(XTB_Client * self) {
+    if(atomic_load(&self->io_running) == false || pthread_equal(pthread_self(), self->io_thread) != 0) {
+        return;
+    }
+
+    uint64_t wake = 1;
+
+    atomic_store(&self->io_stop, true);
+
+    if(write(self->wake_fd, &wake, sizeof(wake)) < 0) {
+        __assert("I/O thread wake up error\n");
+    }
+
+    pthread_join(self->io_thread, NULL);
+
+    while(atomic_load(&self->io_submitting) > 0) {
+        sched_yield();
+    }
+
+    /*
+     * requests sent without response and commands which were not sent by I/O thread 
+     * are completed as failed, so the threads waiting for them are woken up, commands 
+     * submitted by the completions fail, because the I/O thread is stopping
+     */
+    XTB_Submission * submission;
+
+    xtb_client_cancel(self);
+
+    while((submission = xtb_submission_queue_pop(&self->queue)) != NULL) {
+        xtb_submission_fail(submission);
+    }
+
+    atomic_store(&self->io_running, false);
+
+    while((submission = xtb_submission_queue_pop(&self->queue)) != NULL) {
+        xtb_submission_fail(submission);
+    }
+
+    close(self->wake_fd);
+}
+
+
+/*
+ * checks the response of command and moves its returnData into result,
+ * response of failed command is passed as result, because it contains 
+ * error code and description
+ */
+static XTB_Error read_result(XTB_Error error, Json * response, Json ** result) {
+    *result = NULL;
+
+    if(error != XTB_Error_None) {
+        json_delete(response);
+        return error;
+    } else if(read_status(response) == false) {
+        __assert("command failed\n");
+        *result = response;
+        return XTB_Error_Command;
+    } else {
+        *result = extract_return_data(response);
+        return XTB_Error_None;
+    }
+}
+
+
+static void xtb_async_complete(XTB_Request * request, XTB_Error error, Json * response) {
+    Json * result;
+
+    error = read_result(error, response, &result);
+
+    if(request->callback != NULL) {
+        request->callback(request->param, error, result);
+    } else {
+        json_delete(result);
+    }
+}
+
+
+static inline bool xtb_client_async(XTB_Client * self, const char * cmd, XTB_Callback callback, void * param) {
+    return xtb_client_submit(self, cmd, xtb_async_complete, callback, param);
+}
+
+
+/*
+ * order sent asynchronously is tracked in completion before the callback of caller
+ */
+typedef struct {
+    XTB_Client * client;
+    int64_t submitted;
+
+    XTB_Callback callback;
+    void * param;
+}XTB_TrackedTransaction;
+
+
+static XTB_TrackedTransaction * xtb_tracked_transaction_new(XTB_Client * client, XTB_Callback callback, void * param) {
+    XTB_TrackedTransaction * self = malloc(sizeof(XTB_TrackedTransaction));
+
+    if(self != NULL) {
+        *self = (XTB_TrackedTransaction) {
+            .client = client
+            , .submitted = xtb_clock_ns()
+            , .callback = callback
+            , .param = param
+        };
+    }
+
+    return self;
+}
+
+
+static void xtb_tracked_transaction_complete(XTB_Request * request, XTB_Error error, Json * response) {
+    XTB_TrackedTransaction * self = request->param;
+    Json * result;
+
+    if((error = read_result(error, response, &result)) == XTB_Error_None) {
+        xtb_client_track_result(self->client, result, self->submitted);
+    }
+
+    if(self->callback != NULL) {
+        self->callback(self->param, error, result);
+    } else {
+        json_delete(result);
+    }
+
+    free(self);
+}
+
+
+bool xtb_client_async_ping(XTB_Client * self, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, XTB_CMD_PING, callback, param);
+}
+
+
+bool xtb_client_async_get_all_symbols(XTB_Client * self, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, XTB_CMD_GET_ALL_SYMBOLS, callback, param);
+}
+
+
+bool xtb_client_async_get_calendar(XTB_Client * self, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, XTB_CMD_GET_CALENDAR, callback, param);
+}
+
+
+bool xtb_client_async_get_chart_last_request(
+        XTB_Client * self, char * symbol, XTB_Period period, time_t start, XTB_Callback callback, void * param) {
+    return xtb_client_async(
+                self, xtb_command_get_chart_last_request(xtb_cmd_buffer, symbol, period, start), callback, param);
+}
+
+
+bool xtb_client_async_get_chart_range_request(
+        XTB_Client * self, char * symbol, XTB_Period period, time_t start, time_t end, int32_t tick
+        , XTB_Callback callback, void * param) {
+    return xtb_client_async(
+                self
+                , xtb_command_get_chart_range_request(xtb_cmd_buffer, symbol, period, start, end, tick)
+                , callback
+                , param);
+}
+
+
+/*
+ * history is downloaded by the same chunks as by blocking function, every chunk is requested 
+ * from completion of the previous one
+ */
+typedef struct {
+    XTB_Client * client;
+    char * symbol;
+    XTB_HistoryFetch fetch;
+
+    XTB_Callback callback;
+    void * param;
+}XTB_CandleHistoryRequest;
+
+
+static void xtb_candle_history_request_finish(XTB_CandleHistoryRequest * self, XTB_Error error, Json * result) {
+    if(self->callback != NULL) {
+        self->callback(self->param, error, result);
+    } else {
+        json_delete(result);
+    }
+
+    xtb_history_fetch_release(&self->fetch);
+    free(self->symbol);
+    free(self);
+}
+
+
+static void xtb_candle_history_request_complete(XTB_Request * request, XTB_Error error, Json * response);
+
+
+static bool xtb_candle_history_request_send(XTB_CandleHistoryRequest * self) {
+    return xtb_client_submit(
+                self->client
+                , xtb_command_get_chart_range_request(
+                    xtb_cmd_buffer, self->symbol, self->fetch.period
+                    , self->fetch.start / 1000, self->fetch.end / 1000, 0)
+                , xtb_candle_history_request_complete
+                , NULL
+                , self);
+}
+
+
+static void xtb_candle_history_request_continue(XTB_CandleHistoryRequest * self) {
+    if(xtb_history_fetch_next(&self->fetch) == true) {
+        if(xtb_candle_history_request_send(self) == false) {
+            xtb_candle_history_request_finish(self, XTB_Error_Connection, NULL);
+        }
+
+        return;
+    }
+
+    Json * candles = xtb_history_fetch_candles(&self->fetch);
+
+    xtb_candle_history_request_finish(self, candles != NULL ? XTB_Error_None : XTB_Error_Format, candles);
+}
+
+
+static void xtb_candle_history_request_complete(XTB_Request * request, XTB_Error error, Json * response) {
+    XTB_CandleHistoryRequest * self = request->param;
+    Json * chart;
+
+    if((error = read_result(error, response, &chart)) != XTB_Error_None) {
+        xtb_candle_history_request_finish(self, error, chart);
+        return;
+    }
+
+    /*
+     * broken chunk stops downloading, bars already received are returned
+     */
+    if(xtb_history_fetch_add(&self->fetch, chart) == false) {
+        self->fetch.number = self->fetch.size;
+    }
+
+    xtb_candle_history_request_continue(self);
+}
+
+
+/*
+ * trading hours not cached yet are requested before the first chunk, without them the chunks 
+ * cover continuous time
+ */
+static void xtb_candle_history_request_hours(XTB_Request * request, XTB_Error error, Json * response) {
+    XTB_CandleHistoryRequest * self = request->param;
+    Json * result;
+
+    if(read_result(error, response, &result) == XTB_Error_None) {
+        xtb_client_store_trading_hours(self->client, self->symbol, result, &self->fetch.hours);
+    }
+
+    json_delete(result);
+    xtb_candle_history_request_continue(self);
+}
+
+
+bool xtb_client_async_get_lastn_candle_history(
+        XTB_Client * self, char * symbol, XTB_Period period, size_t number, XTB_Callback callback, void * param) {
+    XTB_CandleHistoryRequest * request = malloc(sizeof(XTB_CandleHistoryRequest));
+    bool sent;
+
+    if(request == NULL) {
+        return false;
+    }
+
+    *request = (XTB_CandleHistoryRequest) {
+        .client = self
+        , .symbol = strdup(symbol)
+        , .callback = callback
+        , .param = param
+    };
+
+    xtb_history_fetch_init(&request->fetch, period, number);
+
+    if(xtb_client_cached_trading_hours(self, symbol, &request->fetch.hours) == true) {
+        sent = xtb_history_fetch_next(&request->fetch) == true && xtb_candle_history_request_send(request) == true;
+    } else {
+        sent = xtb_client_submit(
+                    self
+                    , xtb_command_get_trading_hours(xtb_cmd_buffer, 1, &symbol)
+                    , xtb_candle_history_request_hours
+                    , NULL
+                    , request);
+    }
+
+    if(sent == false) {
+        free(request->symbol);
+        free(request);
+        return false;
+    }
+
+    return true;
+}
+
+
+bool xtb_client_async_get_commision(
+        XTB_Client * self, char * symbol, float volume, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, xtb_command_get_commision(xtb_cmd_buffer, symbol, volume), callback, param);
+}
+
+
+bool xtb_client_async_get_commision_def(
+        XTB_Client * self, char * symbol, float volume, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, xtb_command_get_commision_def(xtb_cmd_buffer, symbol, volume), callback, param);
+}
+
+
+bool xtb_client_async_get_margin_level(XTB_Client * self, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, XTB_CMD_GET_MARGIN_LEVEL, callback, param);
+}
+
+
+bool xtb_client_async_get_margin_trade(
+        XTB_Client * self, char * symbol, float volume, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, xtb_command_get_margin_trade(xtb_cmd_buffer, symbol, volume), callback, param);
+}
+
+
+bool xtb_client_async_get_profit_calculation(
+        XTB_Client * self, float close_price, XTB_TransMode mode, float open_price, char * symbol, float volume
+        , XTB_Callback callback, void * param) {
+    return xtb_client_async(
+                self
+                , xtb_command_get_profit_calculation(xtb_cmd_buffer, symbol, mode, open_price, close_price, volume)
+                , callback
+                , param);
+}
+
+
+bool xtb_client_async_get_server_time(XTB_Client * self, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, XTB_CMD_GET_SERVER_TIME, callback, param);
+}
+
+
+bool xtb_client_async_get_symbol(XTB_Client * self, char * symbol, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, xtb_command_get_symbol(xtb_cmd_buffer, symbol), callback, param);
+}
+
+
+bool xtb_client_async_get_tick_prices(
+        XTB_Client * self, size_t size, char ** symbols, int price_level, time_t timestamp
+        , XTB_Callback callback, void * param) {
+    return xtb_client_async(
+                self
+                , xtb_command_get_tick_prices(xtb_cmd_buffer, size, symbols, price_level, timestamp)
+                , callback
+                , param);
+}
+
+
+bool xtb_client_async_get_news(XTB_Client * self, time_t start, time_t end, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, xtb_command_get_news(xtb_cmd_buffer, start, end), callback, param);
+}
+
+
+bool xtb_client_async_get_version(XTB_Client * self, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, XTB_CMD_GET_VERSION, callback, param);
+}
+
+
+bool xtb_client_async_get_trades(XTB_Client * self, bool opened_only, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, xtb_command_get_trades(xtb_cmd_buffer, opened_only), callback, param);
+}
+
+
+bool xtb_client_async_get_trade_records(
+        XTB_Client * self, size_t size, char ** orders, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, xtb_command_get_trade_records(xtb_cmd_buffer, size, orders), callback, param);
+}
+
+
+bool xtb_client_async_get_trade_history(
+        XTB_Client * self, time_t start, time_t end, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, xtb_command_get_trade_history(xtb_cmd_buffer, start, end), callback, param);
+}
+
+
+bool xtb_client_async_trade_transaction_status(
+        XTB_Client * self, unsigned long order, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, xtb_command_trade_transaction_status(xtb_cmd_buffer, order), callback, param);
+}
+
+
+bool xtb_client_async_get_user_data(XTB_Client * self, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, XTB_CMD_GET_CURRENT_USER_DATA, callback, param);
+}
+
+
+bool xtb_client_async_get_trading_hours(
+        XTB_Client * self, size_t size, char ** symbols, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, xtb_command_get_trading_hours(xtb_cmd_buffer, size, symbols), callback, param);
+}
+
+
+static void xtb_market_status_complete(XTB_Request * request, XTB_Error error, Json * response) {
+    Json * result;
+
+    if((error = read_result(error, response, &result)) == XTB_Error_None) {
+        Json * trading_hours = result;
+
+        result = json_is_type(trading_hours, JsonArray) == true ? build_trading_status(trading_hours) : NULL;
+        error  = result != NULL ? XTB_Error_None : XTB_Error_Format;
+
+        json_delete(trading_hours);
+    }
+
+    if(request->callback != NULL) {
+        request->callback(request->param, error, result);
+    } else {
+        json_delete(result);
+    }
+}
+
+
+bool xtb_client_async_check_if_market_open(
+        XTB_Client * self, size_t size, char ** symbols, XTB_Callback callback, void * param) {
+    return xtb_client_submit(
+                self
+                , xtb_command_get_trading_hours(xtb_cmd_buffer, size, symbols)
+                , xtb_market_status_complete
+                , callback
+                , param);
+}
+
+
+bool xtb_client_async_get_step_rules(XTB_Client * self, XTB_Callback callback, void * param) {
+    return xtb_client_async(self, XTB_CMD_GET_STEP_RULES, callback, param);
+}
+
+
+bool xtb_client_async_trade_transaction(
+        XTB_Client * self
+        , char * symbol
+        , char * custom_comment
+        , XTB_TransMode mode
+        , time_t expiration
+        , int offset
+        , char * order
+        , float price
+        , float tp
+        , float sl
+        , XTB_TransType type
+        , float volume
+        , XTB_Callback callback
+        , void * param) {
+    const char * cmd = xtb_command_trade_transaction(
+                            xtb_cmd_buffer, symbol, type, mode, price, volume, offset, sl, tp, expiration, order, custom_comment);
+
+    if(self->orders == NULL) {
+        return xtb_client_async(self, cmd, callback, param);
+    }
+
+    XTB_TrackedTransaction * transaction = xtb_tracked_transaction_new(self, callback, param);
+
+    if(transaction == NULL || xtb_client_submit(self, cmd, xtb_tracked_transaction_complete, NULL, transaction) == false) {
+        free(transaction);
+        return false;
+    }
+
+    return true;
+}
+
+
+typedef struct {
+    XTB_Client * client;
+    char * symbol;
+    XTB_TransMode mode;
+    float volume;
+    float tp;
+    float sl;
+
+    XTB_Callback callback;
+    void * param;
+}XTB_OpenTradeRequest;
+
+
+static void xtb_open_trade_request_complete(XTB_Request * request, XTB_Error error, Json * response) {
+    XTB_OpenTradeRequest * self = request->param;
+    Json * candle;
+    float price;
+
+    /*
+     * the price of symbol is received, so the transaction can be sent
+     */
+    if((error = read_result(error, response, &candle)) == XTB_Error_None) {
+        if(read_symbol_price(candle, self->mode, &price) == true) {
+            if(xtb_client_async_trade_transaction(
+                    self->client, self->symbol, NULL, self->mode, 0, 0, NULL, price, self->tp, self->sl
+                    , XTB_TransType_OPEN, self->volume, self->callback, self->param) == false) {
+                error = XTB_Error_Connection;
+            }
+        } else {
+            __assert("response format error\n");
+            error = XTB_Error_Format;
+        }
+
+        json_delete(candle);
+        candle = NULL;
+    }
+
+    if(error != XTB_Error_None) {
+        if(self->callback != NULL) {
+            self->callback(self->param, error, candle);
+        } else {
+            json_delete(candle);
+        }
+    }
+
+    free(self->symbol);
+    free(self);
+}
+
+
+bool xtb_client_async_open_trade(
+        XTB_Client * self, char * symbol, XTB_TransMode mode, float volume, float tp, float sl
+        , XTB_Callback callback, void * param) {
+    if(mode != XTB_TransMode_BUY && mode != XTB_TransMode_SELL) {
+        __assert("mode can be buy or sell\n");
+        return false;
+    }
+
+    float price;
+
+    if(read_quote_price(self, symbol, mode, &price) == true) {
+        return xtb_client_async_trade_transaction(
+                self, symbol, NULL, mode, 0, 0, NULL, price, tp, sl, XTB_TransType_OPEN, volume, callback, param);
+    }
+
+    XTB_OpenTradeRequest * request = malloc(sizeof(XTB_OpenTradeRequest));
+
+    *request = (XTB_OpenTradeRequest) {
+        .client = self
+        , .symbol = strdup(symbol)
+        , .mode = mode
+        , .volume = volume
+        , .tp = tp
+        , .sl = sl
+        , .callback = callback
+        , .param = param
+    };
+
+    if(xtb_client_submit(
+            self, xtb_command_get_symbol(xtb_cmd_buffer, symbol), xtb_open_trade_request_complete, NULL, request) == false) {
+        free(request->symbol);
+        free(request);
+        return false;
+    }
+
+    return true;
+}
+
+
+bool xtb_client_async_close_trade(
+        XTB_Client * self, char * symbol, char * order, XTB_TransMode mode, float price, float volume
+        , XTB_Callback callback, void * param) {
+    return xtb_client_async_trade_transaction(
+                self, symbol, NULL, mode, 0, 0, order, price, 0, 0, XTB_TransType_CLOSE, volume, callback, param);
+}
+
+
+/*
+ * order template is tradeTransaction message serialized once per symbol and mode, 
+ * only the tag, price, sl, tp and volume are written into fields of fixed width, 
+ * which are padded by spaces, so the order is sent without formatting of message
+ */
+#define XTB_ORDER_TAG_WIDTH 10
+#define XTB_ORDER_NUMBER_WIDTH 20
+#define XTB_ORDER_VOLUME_DIGITS 2
+
+
+struct XTB_OrderTemplate {
+    XTB_Client * client;
+    XTB_TransMode mode;
+    int digits;
+    char symbol[XTB_SYMBOL_SIZE];
+
+    /*
+     * positions of fields in message
+     */
+    size_t tag;
+    size_t body;
+    size_t price;
+    size_t sl;
+    size_t tp;
+    size_t volume;
+
+    char message[CMD_BUFFER_SIZE];
+};
+
+
+static size_t xtb_order_template_field(XTB_OrderTemplate * self, size_t pos, size_t width) {
+    memset(self->message + pos, ' ', width);
+    return pos + width;
+}
+
+
+/*
+ * writes decimal number with given number of digits and fills the rest of field by spaces
+ */
+static bool xtb_order_template_number(char * field, size_t width, double value, int digits) {
+    static const uint64_t scale[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+    char integer[24];
+    size_t size = 0;
+    char * it   = field;
+
+    if(value < 0) {
+        *it++ = '-';
+        value = -value;
+    }
+
+    if(isfinite(value) == false || value * scale[digits] >= 1e18) {
+        return false;
+    }
+
+    uint64_t fixed    = (uint64_t) llround(value * scale[digits]);
+    uint64_t whole    = fixed / scale[digits];
+    uint64_t fraction = fixed % scale[digits];
+
+    do {
+        integer[size++] = '0' + whole % 10;
+        whole /= 10;
+    } while(whole > 0);
+
+    if((size_t) (it - field) + size + (digits > 0 ? digits + 1 : 0) > width) {
+        return false;
+    }
+
+    while(size > 0) {
+        *it++ = integer[--size];
+    }
+
+    if(digits > 0) {
+        *it++ = '.';
+
+        for(int i = digits - 1; i >= 0; i--) {
+            it[i]     = '0' + fraction % 10;
+            fraction /= 10;
+        }
+
+        it += digits;
+    }
+
+    memset(it, ' ', field + width - it);
+
+    return true;
+}
+
+
+XTB_OrderTemplate * xtb_order_template_new(XTB_Client * client, const char * symbol, XTB_TransMode mode) {
+    if(mode != XTB_TransMode_BUY && mode != XTB_TransMode_SELL) {
+        __assert("mode can be buy or sell\n");
+        return NULL;
+    }
+
+    /*
+     * number of decimal places of price is given by precision of symbol
+     */
+    Json * record = xtb_client_get_symbol(client, (char *) symbol);
+    Json * precision = json_lookup(record, "precision");
+
+    if(json_is_type(precision, JsonInteger) == false) {
+        __assert("response format error\n");
+        json_delete(record);
+        return NULL;
+    }
+
+    XTB_OrderTemplate * self = malloc(sizeof(XTB_OrderTemplate));
+
+    self->client = client;
+    self->mode   = mode;
+    self->digits = atoi(precision->string);
+
+    json_delete(record);
+
+    if(self->digits < 0 || self->digits > 8 || strlen(symbol) >= XTB_SYMBOL_SIZE) {
+        __assert("symbol format error\n");
+        free(self);
+        return NULL;
+    }
+
+    strcpy(self->symbol, symbol);
+
+    size_t pos = sprintf(self->message, "{\"customTag\": \"");
+
+    self->tag = pos;
+    pos       = xtb_order_template_field(self, pos, XTB_ORDER_TAG_WIDTH);
+    pos      += sprintf(self->message + pos, "\", ");
+    self->body = pos;
+    pos      += sprintf(self->message + pos
+                    , "\"command\": \"tradeTransaction\", \"arguments\": {\"tradeTransInfo\": {\"cmd\": %d, \"price\": "
+                    , mode);
+    self->price = pos;
+    pos         = xtb_order_template_field(self, pos, XTB_ORDER_NUMBER_WIDTH);
+    pos        += sprintf(self->message + pos, ", \"sl\": ");
+    self->sl    = pos;
+    pos         = xtb_order_template_field(self, pos, XTB_ORDER_NUMBER_WIDTH);
+    pos        += sprintf(self->message + pos, ", \"symbol\": \"%s\", \"tp\": ", symbol);
+    self->tp    = pos;
+    pos         = xtb_order_template_field(self, pos, XTB_ORDER_NUMBER_WIDTH);
+    pos        += sprintf(self->message + pos, ", \"type\": %d, \"volume\": ", XTB_TransType_OPEN);
+    self->volume = pos;
+    pos          = xtb_order_template_field(self, pos, XTB_ORDER_NUMBER_WIDTH);
+
+    sprintf(self->message + pos, "}}}");
+
+    return self;
+}
+
+
+XTB_OrderTemplate * xtb_order_template_new_by_id(XTB_Client * client, XTB_SymbolId id, XTB_TransMode mode) {
+    const char * symbol = xtb_symbol_name(id);
+    return symbol != NULL ? xtb_order_template_new(client, symbol, mode) : NULL;
+}
+
+
+static bool xtb_order_template_fill(XTB_OrderTemplate * self, float price, float volume, float sl, float tp) {
+    return xtb_order_template_number(self->message + self->price, XTB_ORDER_NUMBER_WIDTH, price, self->digits)
+            && xtb_order_template_number(self->message + self->sl, XTB_ORDER_NUMBER_WIDTH, sl, self->digits)
+            && xtb_order_template_number(self->message + self->tp, XTB_ORDER_NUMBER_WIDTH, tp, self->digits)
+            && xtb_order_template_number(
+                    self->message + self->volume, XTB_ORDER_NUMBER_WIDTH, volume, XTB_ORDER_VOLUME_DIGITS);
+}
+
+
+/*
+ * the order is sent directly by the owner of connection, from other threads it is
+ * passed through submission queue as regular command
+ */
+static bool xtb_order_template_submit(
+        XTB_OrderTemplate * self, float price, float volume, float sl, float tp
+        , XTB_Complete complete, XTB_Callback callback, void * param) {
+    XTB_Client * client = self->client;
+
+    if(xtb_order_template_fill(self, price, volume, sl, tp) == false) {
+        __assert("order value out of range\n");
+        return false;
+    }
+
+    if(xtb_client_foreign_thread(client) == true) {
+        snprintf(xtb_cmd_buffer, CMD_BUFFER_SIZE, "{%s", self->message + self->body);
+        return xtb_client_submit(client, xtb_cmd_buffer, complete, callback, param);
+    }
+
+    uint32_t tag = ++client->tag;
+    char * field = self->message + self->tag;
+
+    for(int i = XTB_ORDER_TAG_WIDTH - 1; i >= 0; i--, tag /= 10) {
+        field[i] = '0' + tag % 10;
+    }
+
+    return xtb_client_send_tagged(client, client->tag, self->message, complete, callback, param);
+}
+
+
+static bool xtb_order_template_market_price(XTB_OrderTemplate * self, float * price) {
+    if(read_quote_price(self->client, self->symbol, self->mode, price) == false) {
+        __assert("quote of symbol is not available\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool xtb_order_template_send(
+        XTB_OrderTemplate * self, float price, float volume, float sl, float tp, uint64_t * order) {
+    XTB_Transaction transaction = {.response = NULL};
+    int64_t submitted           = xtb_clock_ns();
+    Json * result;
+
+    xtb_wait_init(&transaction.wait, self->client);
+    xtb_wait_add(&transaction.wait);
+
+    if(xtb_order_template_submit(self, price, volume, sl, tp, xtb_transaction_complete, NULL, &transaction) == false) {
+        xtb_wait_done(&transaction.wait);
+    }
+
+    xtb_wait_finish(&transaction.wait);
+
+    if(read_result(transaction.response == NULL ? XTB_Error_Connection : XTB_Error_None, transaction.response, &result) 
+            != XTB_Error_None) {
+        json_delete(result);
+        return false;
+    }
+
+    Json * json_order = json_lookup(result, "order");
+    bool success      = json_is_type(json_order, JsonInteger);
+
+    if(success == true && order != NULL) {
+        *order = strtoull(json_order->string, NULL, 10);
+    }
+
+    xtb_client_track_result(self->client, result, submitted);
+    json_delete(result);
+
+    return success;
+}
+
+
+bool xtb_order_template_open(XTB_OrderTemplate * self, float volume, float sl, float tp, uint64_t * order) {
+    float price;
+
+    return xtb_order_template_market_price(self, &price) == true
+            && xtb_order_template_send(self, price, volume, sl, tp, order) == true;
+}
+
+
+bool xtb_order_template_send_async(
+        XTB_OrderTemplate * self, float price, float volume, float sl, float tp, XTB_Callback callback, void * param) {
+    if(self->client->orders == NULL) {
+        return xtb_order_template_submit(self, price, volume, sl, tp, xtb_async_complete, callback, param);
+    }
+
+    XTB_TrackedTransaction * transaction = xtb_tracked_transaction_new(self->client, callback, param);
+
+    if(transaction == NULL 
+            || xtb_order_template_submit(
+                self, price, volume, sl, tp, xtb_tracked_transaction_complete, NULL, transaction) == false) {
+        free(transaction);
+        return false;
+    }
+
+    return true;
+}
+
+
+bool xtb_order_template_open_async(
+        XTB_OrderTemplate * self, float volume, float sl, float tp, XTB_Callback callback, void * param) {
+    float price;
+
+    return xtb_order_template_market_price(self, &price) == true
+            && xtb_order_template_send_async(self, price, volume, sl, tp, callback, param) == true;
+}
+
+
+void xtb_order_template_delete(XTB_OrderTemplate * self) {
+    free(self);
+}
+
+
+/*
+ * bar is closed by the first tick of its symbol after the end of its period, bars of quiet
+ * symbols are closed by flush when the end of period is older than lateness, ticks of closed 
+ * period received later are ignored
+ */
+#define XTB_BAR_NONE -1
+#define XTB_BAR_LATENESS 2000
+
+
+typedef struct {
+    XTB_Bar bar;
+    int64_t last;
+    int64_t closed;
+    bool open;
+    int32_t next;
+}XTB_BarSeries;
+
+
+struct XTB_BarBuilder {
+    XTB_BarCallback callback;
+    void * param;
+
+    XTB_BarSeries * series;
+    size_t size;
+    size_t capacity;
+
+    int32_t * first;
+
+    int64_t lateness;
+    int64_t next_close;
+};
+
+
+XTB_BarBuilder * xtb_bar_builder_new(XTB_BarCallback callback, void * param) {
+    XTB_BarBuilder * self = malloc(sizeof(XTB_BarBuilder));
+    int32_t * first       = malloc(sizeof(int32_t) * XTB_SYMBOL_ID_CAPACITY);
+
+    if(self == NULL || first == NULL) {
+        free(self);
+        free(first);
+        return NULL;
+    }
+
+    for(size_t i = 0; i < XTB_SYMBOL_ID_CAPACITY; i++) {
+        first[i] = XTB_BAR_NONE;
+    }
+
+    *self = (XTB_BarBuilder) {
+        .callback = callback
+        , .param = param
+        , .first = first
+        , .lateness = XTB_BAR_LATENESS
+        , .next_close = INT64_MAX
+    };
+
+    return self;
+}
+
+
+bool xtb_bar_builder_add(XTB_BarBuilder * self, const char * symbol, int64_t period) {
+    XTB_SymbolId id = xtb_symbol_intern(symbol);
+
+    if(period <= 0 || id == XTB_SYMBOL_NONE) {
+        __assert("invalid bar series\n");
+        return false;
+    }
+
+    for(int32_t i = self->first[id]; i != XTB_BAR_NONE; i = self->series[i].next) {
+        if(self->series[i].bar.period == period) {
+            return true;
+        }
+    }
+
+    if(self->size == self->capacity) {
+        size_t capacity        = self->capacity > 0 ? self->capacity * 2 : 16;
+        XTB_BarSeries * series = realloc(self->series, sizeof(XTB_BarSeries) * capacity);
+
+        if(series == NULL) {
+            return false;
+        }
+
+        self->series   = series;
+        self->capacity = capacity;
+    }
+
+    self->series[self->size] = (XTB_BarSeries) {
+        .bar = {.id = id, .symbol = xtb_symbol_name(id), .period = period}
+        , .next = self->first[id]
+    };
+
+    self->first[id] = self->size++;
+
+    return true;
+}
+
+
+void xtb_bar_builder_set_lateness(XTB_BarBuilder * self, int64_t lateness) {
+    self->lateness = lateness;
+}
+
+
+static void xtb_bar_series_close(XTB_BarBuilder * self, XTB_BarSeries * series) {
+    series->open   = false;
+    series->closed = series->bar.start + series->bar.period;
+
+    if(self->callback != NULL) {
+        self->callback(self->param, &series->bar);
+    }
+}
+
+
+void xtb_bar_builder_flush(XTB_BarBuilder * self, int64_t now) {
+    int64_t limit = now - self->lateness;
+
+    if(limit < self->next_close) {
+        return;
+    }
+
+    self->next_close = INT64_MAX;
+
+    for(size_t i = 0; i < self->size; i++) {
+        XTB_BarSeries * series = &self->series[i];
+
+        if(series->open == false) {
+            continue;
+        }
+
+        int64_t end = series->bar.start + series->bar.period;
+
+        if(end <= limit) {
+            xtb_bar_series_close(self, series);
+        } else if(end < self->next_close) {
+            self->next_close = end;
+        }
+    }
+}
+
+
+/*
+ * bars are built from bid prices of the top level, volume of bar is the number of ticks, 
+ * ticks older than the last tick of series are ignored
+ */
+void xtb_bar_builder_tick(XTB_BarBuilder * self, const XTB_Tick * tick) {
+    if(tick->level != 0 || tick->id >= XTB_SYMBOL_ID_CAPACITY || self->first[tick->id] == XTB_BAR_NONE) {
+        return;
+    }
+
+    for(int32_t i = self->first[tick->id]; i != XTB_BAR_NONE; i = self->series[i].next) {
+        XTB_BarSeries * series = &self->series[i];
+        XTB_Bar * bar          = &series->bar;
+        int64_t start          = tick->timestamp - tick->timestamp % bar->period;
+
+        if(tick->timestamp < series->last || tick->timestamp < series->closed) {
+            continue;
+        }
+
+        series->last = tick->timestamp;
+
+        if(series->open == true && start != bar->start) {
+            xtb_bar_series_close(self, series);
+        }
+
+        if(series->open == true) {
+            bar->high  = tick->bid > bar->high ? tick->bid : bar->high;
+            bar->low   = tick->bid < bar->low ? tick->bid : bar->low;
+            bar->close = tick->bid;
+            bar->ticks++;
+        } else {
+            bar->start = start;
+            bar->open  = bar->high = bar->low = bar->close = tick->bid;
+            bar->ticks = 1;
+
+            series->open = true;
+
+            if(start + bar->period < self->next_close) {
+                self->next_close = start + bar->period;
+            }
+        }
+    }
+}
+
+
+void xtb_bar_builder_delete(XTB_BarBuilder * self) {
+    if(self != NULL) {
+        free(self->series);
+        free(self->first);
+        free(self);
+    }
+}
+
+
+/*
+ * bars are kept in columns written twice, at index and index + capacity, so the last size bars
+ * always form one contiguous array starting at begin
+ */
+struct XTB_LiveSeries {
+    char symbol[XTB_SYMBOL_SIZE];
+    XTB_SymbolId id;
+    XTB_Period period;
+
+    size_t capacity;
+    size_t count;
+    size_t size;
+
+    int64_t * time;
+    double * open;
+    double * high;
+    double * low;
+    double * close;
+    double * vol;
+
+    /*
+     * the newest minute already contained in bars, older minutes are duplicates
+     */
+    int64_t last_minute;
+
+    /*
+     * candles received while history is loaded asynchronously are merged after it, 
+     * refill requests loading of missed minutes once the pending history is merged
+     */
+    struct XTB_SeriesFill * fill;
+    bool refill;
+
+    XTB_Candle * pending;
+    size_t pending_size;
+    size_t pending_capacity;
+
+    XTB_SeriesCallback callback;
+    void * param;
+
+    struct XTB_LiveSeries * next;
+};
+
+
+#define XTB_MINUTE 60000
+
+
+/*
+ * history loaded asynchronously is passed to the thread processing the stream, the request 
+ * is shared with the completion, which can be called after the series was deleted
+ */
+typedef enum {
+    XTB_SeriesFill_Pending
+    , XTB_SeriesFill_Done
+    , XTB_SeriesFill_Failed
+}XTB_SeriesFillState;
+
+
+struct XTB_SeriesFill {
+    atomic_int state;
+    atomic_int refs;
+
+    XTB_Period period;
+    int64_t requested;
+    Json * chart;
+};
+
+
+static void xtb_series_fill_release(struct XTB_SeriesFill * self) {
+    if(self != NULL && atomic_fetch_sub(&self->refs, 1) == 1) {
+        json_delete(self->chart);
+        free(self);
+    }
+}
+
+
+static void xtb_series_fill_complete(void * param, XTB_Error error, Json * chart) {
+    struct XTB_SeriesFill * self = param;
+
+    self->chart = chart;
+    atomic_store(&self->state, error == XTB_Error_None ? XTB_SeriesFill_Done : XTB_SeriesFill_Failed);
+    xtb_series_fill_release(self);
+}
+
+
+static void xtb_live_series_delete(XTB_LiveSeries * self) {
+    if(self != NULL) {
+        xtb_series_fill_release(self->fill);
+        free(self->pending);
+        free(self->time);
+        free(self->open);
+        free(self->high);
+        free(self->low);
+        free(self->close);
+        free(self->vol);
+        free(self);
+    }
+}
+
+
+static XTB_LiveSeries * xtb_live_series_new(const char * symbol, XTB_Period period, size_t capacity) {
+    XTB_LiveSeries * self = calloc(1, sizeof(XTB_LiveSeries));
+
+    if(self == NULL) {
+        return NULL;
+    }
+
+    snprintf(self->symbol, XTB_SYMBOL_SIZE, "%s", symbol);
+
+    self->id       = xtb_symbol_intern(symbol);
+    self->period   = period;
+    self->capacity = capacity;
+    self->time     = malloc(sizeof(int64_t) * capacity * 2);
+    self->open     = malloc(sizeof(double) * capacity * 2);
+    self->high     = malloc(sizeof(double) * capacity * 2);
+    self->low      = malloc(sizeof(double) * capacity * 2);
+    self->close    = malloc(sizeof(double) * capacity * 2);
+    self->vol      = malloc(sizeof(double) * capacity * 2);
+
+    if(self->time == NULL || self->open == NULL || self->high == NULL 
+            || self->low == NULL || self->close == NULL || self->vol == NULL) {
+        xtb_live_series_delete(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+
+static void xtb_live_series_write(XTB_LiveSeries * self, size_t index) {
+    size_t mirror = index < self->capacity ? index + self->capacity : index - self->capacity;
+
+    self->time[mirror]  = self->time[index];
+    self->open[mirror]  = self->open[index];
+    self->high[mirror]  = self->high[index];
+    self->low[mirror]   = self->low[index];
+    self->close[mirror] = self->close[index];
+    self->vol[mirror]   = self->vol[index];
+}
+
+
+/*
+ * merges bar of length ms starting at ctm into the series, bars of the series keep alignment 
+ * of the bars received from server
+ */
+static bool xtb_live_series_put(
+        XTB_LiveSeries * self, int64_t ctm, int64_t length
+        , double open, double high, double low, double close, double vol) {
+    int64_t period = (int64_t) self->period * 1000;
+
+    if(ctm + length - XTB_MINUTE <= self->last_minute) {
+        return false;
+    }
+
+    self->last_minute = ctm + length - XTB_MINUTE;
+
+    size_t newest = (self->count + self->capacity - 1) % self->capacity;
+
+    if(self->count > 0 && ctm < self->time[newest] + period) {
+        if(ctm < self->time[newest]) {
+            return false;
+        }
+
+        self->high[newest]  = high > self->high[newest] ? high : self->high[newest];
+        self->low[newest]   = low < self->low[newest] ? low : self->low[newest];
+        self->close[newest] = close;
+        self->vol[newest]  += vol;
+    } else {
+        int64_t start = self->count > 0 
+                            ? ctm - (ctm - self->time[newest]) % period
+                            : ctm - ctm % period;
+
+        newest = self->count++ % self->capacity;
+
+        self->time[newest]  = start;
+        self->open[newest]  = open;
+        self->high[newest]  = high;
+        self->low[newest]   = low;
+        self->close[newest] = close;
+        self->vol[newest]   = vol;
+
+        self->size = self->size < self->capacity ? self->size + 1 : self->capacity;
+    }
+
+    xtb_live_series_write(self, newest);
+
+    return true;
+}
+
+
+/*
+ * merges bars of given period requested at now, bars which weren't closed yet are skipped, 
+ * they are received by stream
+ */
+static bool xtb_live_series_merge(XTB_LiveSeries * self, Json * chart, XTB_Period period, int64_t now) {
+    Json * rates = json_lookup(chart, "rateInfos");
+
+    if(json_is_type(chart, JsonObject) == false || json_is_type(rates, JsonArray) == false) {
+        __assert("response format error\n");
+        return false;
+    }
+
+    double scale = pow(10, json_lookup_integer(chart, "digits"));
+
+    for(size_t i = 0; i < rates->array.size; i++) {
+        Json * rate  = rates->array.value[i];
+        int64_t ctm  = json_lookup_integer(rate, "ctm");
+        double open  = json_lookup_number(rate, "open");
+
+        if(ctm + (int64_t) period * 1000 > now) {
+            break;
+        }
+
+        xtb_live_series_put(
+            self, ctm, (int64_t) period * 1000
+            , open / scale
+            , (open + json_lookup_number(rate, "high")) / scale
+            , (open + json_lookup_number(rate, "low")) / scale
+            , (open + json_lookup_number(rate, "close")) / scale
+            , json_lookup_number(rate, "vol"));
+    }
+
+    return true;
+}
+
+
+/*
+ * loads bars of given period from time in unix ms
+ */
+static bool xtb_live_series_load(XTB_LiveSeries * self, XTB_Client * client, XTB_Period period, int64_t from) {
+    int64_t now  = xtb_time_ms();
+    Json * chart = xtb_client_get_chart_range_request(client, self->symbol, period, from / 1000, now / 1000, 0);
+    bool result  = xtb_live_series_merge(self, chart, period, now);
+
+    json_delete(chart);
+
+    return result;
+}
+
+
+static inline int64_t xtb_live_series_gap(XTB_LiveSeries * self) {
+    return self->last_minute > 0 ? self->last_minute + XTB_MINUTE : xtb_time_ms();
+}
+
+
+/*
+ * minutes since the last contained minute fill the gap till the first candle received by stream
+ */
+static bool xtb_live_series_fill(XTB_LiveSeries * self, XTB_Client * client) {
+    bool result = xtb_live_series_load(self, client, XTB_PERIOD_M1, xtb_live_series_gap(self));
+
+    if(result == true && self->callback != NULL && self->size > 0) {
+        self->callback(self->param, self);
+    }
+
+    return result;
+}
+
+
+static bool xtb_live_series_request(XTB_LiveSeries * self, XTB_Client * client, XTB_Period period, int64_t from) {
+    struct XTB_SeriesFill * fill = malloc(sizeof(struct XTB_SeriesFill));
+
+    if(fill == NULL) {
+        return false;
+    }
+
+    *fill = (struct XTB_SeriesFill) {
+        .state = XTB_SeriesFill_Pending
+        , .refs = 2
+        , .period = period
+        , .requested = xtb_time_ms()
+    };
+
+    if(xtb_client_async_get_chart_range_request(
+            client, self->symbol, period, from / 1000, fill->requested / 1000, 0, xtb_series_fill_complete, fill) == false) {
+        free(fill);
+        return false;
+    }
+
+    self->fill = fill;
+
+    return true;
+}
+
+
+/*
+ * missed minutes are requested asynchronously, or after the history being loaded is merged
+ */
+static bool xtb_live_series_refill(XTB_LiveSeries * self, XTB_Client * client) {
+    if(self->fill != NULL) {
+        self->refill = true;
+        return true;
+    }
+
+    return xtb_live_series_request(self, client, XTB_PERIOD_M1, xtb_live_series_gap(self));
+}
+
+
+static void xtb_live_series_apply(XTB_LiveSeries * self, const XTB_Candle * candle) {
+    bool updated = xtb_live_series_put(
+                        self, candle->ctm, XTB_MINUTE, candle->open, candle->high, candle->low, candle->close, candle->vol);
+
+    if(updated == true && self->callback != NULL) {
+        self->callback(self->param, self);
+    }
+}
+
+
+/*
+ * history loaded asynchronously is merged before candles received meanwhile, bars loaded 
+ * in period of series are followed by minutes closed till now
+ */
+static void xtb_live_series_poll(XTB_LiveSeries * self, XTB_Client * client) {
+    struct XTB_SeriesFill * fill = self->fill;
+
+    if(fill == NULL || atomic_load(&fill->state) == XTB_SeriesFill_Pending) {
+        return;
+    }
+
+    self->fill = NULL;
+
+    if(atomic_load(&fill->state) == XTB_SeriesFill_Failed 
+            || xtb_live_series_merge(self, fill->chart, fill->period, fill->requested) == false) {
+        __assert("series history load failed\n");
+    } else if(fill->period != XTB_PERIOD_M1 || self->refill == true) {
+        self->refill = false;
+
+        if(xtb_live_series_request(self, client, XTB_PERIOD_M1, xtb_live_series_gap(self)) == true) {
+            xtb_series_fill_release(fill);
+            return;
+        }
+    }
+
+    xtb_series_fill_release(fill);
+
+    for(size_t i = 0; i < self->pending_size; i++) {
+        xtb_live_series_put(
+            self, self->pending[i].ctm, XTB_MINUTE, self->pending[i].open, self->pending[i].high
+            , self->pending[i].low, self->pending[i].close, self->pending[i].vol);
+    }
+
+    self->pending_size = 0;
+
+    if(self->callback != NULL && self->size > 0) {
+        self->callback(self->param, self);
+    }
+}
+
+
+static void xtb_live_series_candle(XTB_LiveSeries * self, XTB_Client * client, const XTB_Candle * candle) {
+    xtb_live_series_poll(self, client);
+
+    if(self->fill == NULL) {
+        xtb_live_series_apply(self, candle);
+        return;
+    }
+
+    if(self->pending_size == self->pending_capacity) {
+        size_t capacity    = self->pending_capacity > 0 ? self->pending_capacity * 2 : 16;
+        XTB_Candle * array = realloc(self->pending, sizeof(XTB_Candle) * capacity);
+
+        if(array == NULL) {
+            __assert("series candle lost\n");
+            return;
+        }
+
+        self->pending          = array;
+        self->pending_capacity = capacity;
+    }
+
+    self->pending[self->pending_size++] = *candle;
+}
+
+
+XTB_SeriesView xtb_live_series_view(const XTB_LiveSeries * self) {
+    size_t begin = (self->count - self->size) % self->capacity;
+    size_t last  = begin + self->size - 1;
+
+    return (XTB_SeriesView) {
+        .symbol = self->symbol
+        , .period = self->period
+        , .size = self->size
+        , .time = self->time + begin
+        , .open = self->open + begin
+        , .high = self->high + begin
+        , .low = self->low + begin
+        , .close = self->close + begin
+        , .vol = self->vol + begin
+        , .forming = self->size > 0 
+                        && self->time[last] + (int64_t) self->period * 1000 > self->last_minute + XTB_MINUTE
+    };
+}
+
+
+/*
+ * history store is one file per symbol and period, header is followed by columns of bars, 
+ * every column has capacity items, so the file is replaced by bigger one when it is full
+ */
+#define XTB_HISTORY_MAGIC 0x48425458u
+#define XTB_HISTORY_VERSION 1
+#define XTB_HISTORY_CAPACITY 4096
+#define XTB_HISTORY_COLUMNS 6
+
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    uint64_t size;
+    int64_t period;
+    char symbol[XTB_SYMBOL_SIZE];
+}XTB_HistoryHeader;
+
+
+struct XTB_HistoryStore {
+    char * path;
+    char symbol[XTB_SYMBOL_SIZE];
+    XTB_Period period;
+
+    uint8_t * map;
+    size_t length;
+
+    XTB_HistoryHeader * header;
+    int64_t * time;
+    double * open;
+    double * high;
+    double * low;
+    double * close;
+    double * vol;
+};
+
+
+static inline size_t xtb_history_length(size_t capacity) {
+    return sizeof(XTB_HistoryHeader) + capacity * XTB_HISTORY_COLUMNS * sizeof(double);
+}
+
+
+static void xtb_history_store_unmap(XTB_HistoryStore * self) {
+    if(self->map != NULL) {
+        munmap(self->map, self->length);
+        self->map = NULL;
+    }
+}
+
+
+static bool xtb_history_store_map(XTB_HistoryStore * self) {
+    int fd = open(self->path, O_RDWR);
+    struct stat st;
+
+    if(fd < 0) {
+        return false;
+    }
+
+    if(fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(XTB_HistoryHeader)) {
+        close(fd);
+        return false;
+    }
+
+    uint8_t * map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(map == MAP_FAILED) {
+        return false;
+    }
+
+    XTB_HistoryHeader * header = (XTB_HistoryHeader *) map;
+
+    if(header->magic != XTB_HISTORY_MAGIC
+            || header->version != XTB_HISTORY_VERSION
+            || header->period != self->period
+            || strncmp(header->symbol, self->symbol, XTB_SYMBOL_SIZE) != 0
+            || header->size > header->capacity
+            || (size_t) st.st_size != xtb_history_length(header->capacity)) {
+        munmap(map, st.st_size);
+        return false;
+    }
+
+    double * column = (double *) (map + sizeof(XTB_HistoryHeader));
+    size_t capacity = header->capacity;
+
+    xtb_history_store_unmap(self);
+
+    self->map    = map;
+    self->length = st.st_size;
+    self->header = header;
+    self->time   = (int64_t *) column;
+    self->open   = column + capacity;
+    self->high   = column + 2 * capacity;
+    self->low    = column + 3 * capacity;
+    self->close  = column + 4 * capacity;
+    self->vol    = column + 5 * capacity;
+
+    return true;
+}
+
+
+/*
+ * writes store with new capacity into temporary file and renames it, bars of the current
+ * mapping are copied when it exists
+ */
+static bool xtb_history_store_resize(XTB_HistoryStore * self, size_t capacity) {
+    char tmp_path[PATH_MAX];
+    size_t length = xtb_history_length(capacity);
+    size_t size   = self->map != NULL ? self->header->size : 0;
+
+    if(snprintf(tmp_path, PATH_MAX, "%s.tmp", self->path) >= PATH_MAX) {
+        return false;
+    }
+
+    int fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if(fd < 0) {
+        return false;
+    }
+
+    uint8_t * map = MAP_FAILED;
+
+    if(ftruncate(fd, length) == 0) {
+        map = mmap(NULL, length, PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    close(fd);
+
+    if(map == MAP_FAILED) {
+        unlink(tmp_path);
+        return false;
+    }
+
+    XTB_HistoryHeader header = {
+        .magic = XTB_HISTORY_MAGIC
+        , .version = XTB_HISTORY_VERSION
+        , .capacity = capacity
+        , .size = size
+        , .period = self->period
+    };
+
+    memcpy(header.symbol, self->symbol, XTB_SYMBOL_SIZE);
+    memcpy(map, &header, sizeof(XTB_HistoryHeader));
+
+    double * column = (double *) (map + sizeof(XTB_HistoryHeader));
+
+    if(size > 0) {
+        memcpy(column, self->time, size * sizeof(int64_t));
+        memcpy(column + capacity, self->open, size * sizeof(double));
+        memcpy(column + 2 * capacity, self->high, size * sizeof(double));
+        memcpy(column + 3 * capacity, self->low, size * sizeof(double));
+        memcpy(column + 4 * capacity, self->close, size * sizeof(double));
+        memcpy(column + 5 * capacity, self->vol, size * sizeof(double));
+    }
+
+    bool result = msync(map, length, MS_SYNC) == 0;
+
+    munmap(map, length);
+
+    if(result == false || rename(tmp_path, self->path) != 0) {
+        unlink(tmp_path);
+        return false;
+    }
+
+    return xtb_history_store_map(self);
+}
+
+
+XTB_HistoryStore * xtb_history_store_open(const char * directory, const char * symbol, XTB_Period period) {
+    XTB_HistoryStore * self = calloc(1, sizeof(XTB_HistoryStore));
+    char path[PATH_MAX];
+
+    if(self == NULL || snprintf(path, PATH_MAX, "%s/%s_%d.xtbh", directory, symbol, period / 60) >= PATH_MAX) {
+        free(self);
+        return NULL;
+    }
+
+    snprintf(self->symbol, XTB_SYMBOL_SIZE, "%s", symbol);
+    self->period = period;
+    self->path   = strdup(path);
+
+    /*
+     * missing or invalid file is created again empty
+     */
+    if(self->path == NULL
+            || (xtb_history_store_map(self) == false 
+                && xtb_history_store_resize(self, XTB_HISTORY_CAPACITY) == false)) {
+        __assert("can't open history store\n");
+        xtb_history_store_close(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+
+/*
+ * bars are written before the size is increased, so a crash never exposes not written bars
+ */
+static bool xtb_history_store_put(XTB_HistoryStore * self, const XTB_CandleSeries * series, size_t index) {
+    size_t size = self->header->size;
+
+    if(size > 0 && series->timestamp[index] < self->time[size - 1]) {
+        return true;
+    }
+
+    /*
+     * the last bar could still be forming when it was stored, so it is overwritten
+     */
+    if(size > 0 && series->timestamp[index] == self->time[size - 1]) {
+        size--;
+    } else if(size == self->header->capacity && xtb_history_store_resize(self, 2 * size) == false) {
+        return false;
+    }
+
+    self->time[size]  = series->timestamp[index];
+    self->open[size]  = series->open[index];
+    self->high[size]  = series->high[index];
+    self->low[size]   = series->low[index];
+    self->close[size] = series->close[index];
+    self->vol[size]   = series->vol[index];
+
+    self->header->size = size + 1;
+
+    return true;
+}
+
+
+bool xtb_history_store_append(XTB_HistoryStore * self, const XTB_CandleSeries * series) {
+    for(size_t i = 0; i < series->size; i++) {
+        if(xtb_history_store_put(self, series, i) == false) {
+            __assert("can't write history store\n");
+            return false;
+        }
+    }
+
+    return msync(self->map, self->length, MS_ASYNC) == 0;
+}
+
+
+bool xtb_history_store_sync(XTB_HistoryStore * self, XTB_Client * client, size_t depth) {
+    XTB_CandleSeries * series;
+
+    if(self->header->size == 0) {
+        series = xtb_client_get_lastn_candle_series(client, self->symbol, self->period, depth);
+    } else {
+        series = xtb_client_get_chart_range_series(
+                    client, self->symbol, self->period, self->time[self->header->size - 1] / 1000, time(NULL), 0);
+    }
+
+    if(series == NULL) {
+        return false;
+    }
+
+    bool result = xtb_history_store_append(self, series);
+
+    xtb_candle_series_delete(series);
+
+    return result;
+}
+
+
+size_t xtb_history_store_size(const XTB_HistoryStore * self) {
+    return self->header->size;
+}
+
+
+/*
+ * index of the first bar not older than time, or newer than time if after is true
+ */
+static size_t xtb_history_store_search(const XTB_HistoryStore * self, int64_t time, bool after) {
+    size_t low  = 0;
+    size_t high = self->header->size;
+
+    while(low < high) {
+        size_t middle = low + (high - low) / 2;
+
+        if(self->time[middle] < time || (after == true && self->time[middle] == time)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+
+/*
+ * from and to are unix ms, both are inclusive
+ */
+XTB_SeriesView xtb_history_store_range(const XTB_HistoryStore * self, int64_t from, int64_t to) {
+    size_t size  = self->header->size;
+    size_t begin = xtb_history_store_search(self, from, false);
+    size_t end   = xtb_history_store_search(self, to, true);
+
+    if(end < begin) {
+        end = begin;
+    }
+
+    return (XTB_SeriesView) {
+        .symbol = self->symbol
+        , .period = self->period
+        , .size = end - begin
+        , .time = self->time + begin
+        , .open = self->open + begin
+        , .high = self->high + begin
+        , .low = self->low + begin
+        , .close = self->close + begin
+        , .vol = self->vol + begin
+        , .forming = end == size && end > begin 
+                        && self->time[end - 1] + (int64_t) self->period * 1000 > xtb_time_ms()
+    };
+}
+
+
+void xtb_history_store_close(XTB_HistoryStore * self) {
+    if(self != NULL) {
+        if(self->map != NULL) {
+            msync(self->map, self->length, MS_SYNC);
+        }
+
+        xtb_history_store_unmap(self);
+        free(self->path);
+        free(self);
+    }
+}
+
+
+/*
+ * archive of tick and candle events is a sequence of independently decodable blocks, every 
+ * block starts with header containing time range of its events, so the reader builds index 
+ * of blocks from headers only and decodes just the blocks overlapping the requested time
+ *
+ * events are encoded into bit stream, state is kept for every symbol and type of event:
+ *   - timestamps as delta of delta
+ *   - prices as delta of points, or as xor with the previous value if they aren't decimal
+ *   - integers as zigzag encoded delta
+ */
+#define XTB_ARCHIVE_MAGIC 0x41425458u
+#define XTB_ARCHIVE_BLOCK 65536
+#define XTB_ARCHIVE_EVENT 512
+#define XTB_ARCHIVE_SYMBOLS 256
+#define XTB_ARCHIVE_VALUES 6
+#define XTB_ARCHIVE_INTEGERS 4
+#define XTB_ARCHIVE_DIGITS 8
+
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t count;
+    uint32_t reserved;
+    int64_t first;
+    int64_t last;
+}XTB_ArchiveBlock;
+
+
+typedef struct {
+    uint64_t bits;
+    int leading;
+    int length;
+
+    int64_t points;
+    int digits;
+}XTB_ArchiveValue;
+
+
+typedef struct {
+    int64_t time;
+    int64_t delta;
+    XTB_ArchiveValue value[XTB_ARCHIVE_VALUES];
+    int64_t integer[XTB_ARCHIVE_INTEGERS];
+}XTB_ArchiveStream;
+
+
+typedef struct {
+    size_t symbols;
+    char symbol[XTB_ARCHIVE_SYMBOLS][XTB_SYMBOL_SIZE];
+    XTB_SymbolId id[XTB_ARCHIVE_SYMBOLS];
+    XTB_ArchiveStream stream[XTB_ARCHIVE_SYMBOLS][2];
+}XTB_ArchiveState;
+
+
+typedef struct {
+    uint8_t * data;
+    size_t size;
+    size_t position;
+    bool error;
+}XTB_BitStream;
+
+
+/*
+ * bits are written from the most significant one, data has to be zeroed
+ */
+static void xtb_bits_write(XTB_BitStream * self, uint64_t value, int bits) {
+    while(bits > 0) {
+        int space = 8 - (self->position & 7);
+        int n     = bits < space ? bits : space;
+
+        self->data[self->position >> 3] |= ((value >> (bits - n)) & ((1u << n) - 1)) << (space - n);
+        self->position += n;
+        bits           -= n;
+    }
+}
+
+
+static uint64_t xtb_bits_read(XTB_BitStream * self, int bits) {
+    uint64_t value = 0;
+
+    if(self->position + bits > self->size * 8) {
+        self->error = true;
+        return 0;
+    }
+
+    while(bits > 0) {
+        int space = 8 - (self->position & 7);
+        int n     = bits < space ? bits : space;
+
+        value = (value << n) | ((self->data[self->position >> 3] >> (space - n)) & ((1u << n) - 1));
+        self->position += n;
+        bits           -= n;
+    }
+
+    return value;
+}
+
+
+static inline int xtb_bits_width(size_t size) {
+    return size > 1 ? 64 - __builtin_clzll(size - 1) : 0;
+}
+
+
+static void xtb_archive_write_time(XTB_BitStream * bits, XTB_ArchiveStream * stream, int64_t time) {
+    int64_t delta = (int64_t) ((uint64_t) time - (uint64_t) stream->time);
+    int64_t dod   = (int64_t) ((uint64_t) delta - (uint64_t) stream->delta);
+
+    if(dod == 0) {
+        xtb_bits_write(bits, 0, 1);
+    } else if(dod >= -63 && dod <= 64) {
+        xtb_bits_write(bits, 2, 2);
+        xtb_bits_write(bits, dod + 63, 7);
+    } else if(dod >= -255 && dod <= 256) {
+        xtb_bits_write(bits, 6, 3);
+        xtb_bits_write(bits, dod + 255, 9);
+    } else if(dod >= -2047 && dod <= 2048) {
+        xtb_bits_write(bits, 14, 4);
+        xtb_bits_write(bits, dod + 2047, 12);
+    } else {
+        xtb_bits_write(bits, 15, 4);
+        xtb_bits_write(bits, (uint64_t) dod, 64);
+    }
+
+    stream->time  = time;
+    stream->delta = delta;
+}
+
+
+static int64_t xtb_archive_read_time(XTB_BitStream * bits, XTB_ArchiveStream * stream) {
+    int64_t dod;
+
+    if(xtb_bits_read(bits, 1) == 0) {
+        dod = 0;
+    } else if(xtb_bits_read(bits, 1) == 0) {
+        dod = (int64_t) xtb_bits_read(bits, 7) - 63;
+    } else if(xtb_bits_read(bits, 1) == 0) {
+        dod = (int64_t) xtb_bits_read(bits, 9) - 255;
+    } else if(xtb_bits_read(bits, 1) == 0) {
+        dod = (int64_t) xtb_bits_read(bits, 12) - 2047;
+    } else {
+        dod = (int64_t) xtb_bits_read(bits, 64);
+    }
+
+    stream->delta = (int64_t) ((uint64_t) stream->delta + (uint64_t) dod);
+    stream->time  = (int64_t) ((uint64_t) stream->time + (uint64_t) stream->delta);
+
+    return stream->time;
+}
+
+
+/*
+ * meaningful bits of xor fitting into the window of the previous value are written without
+ * the window, otherwise the new window is written with them
+ */
+static void xtb_archive_write_xor(XTB_BitStream * bits, XTB_ArchiveValue * previous, uint64_t current) {
+    uint64_t xor = current ^ previous->bits;
+
+    previous->bits = current;
+
+    if(xor == 0) {
+        xtb_bits_write(bits, 0, 1);
+        return;
+    }
+
+    int leading  = __builtin_clzll(xor) < 31 ? __builtin_clzll(xor) : 31;
+    int trailing = __builtin_ctzll(xor);
+
+    if(previous->length > 0 && leading >= previous->leading && trailing >= 64 - previous->leading - previous->length) {
+        xtb_bits_write(bits, 2, 2);
+        xtb_bits_write(bits, xor >> (64 - previous->leading - previous->length), previous->length);
+    } else {
+        previous->leading = leading;
+        previous->length  = 64 - leading - trailing;
+
+        xtb_bits_write(bits, 3, 2);
+        xtb_bits_write(bits, leading, 5);
+        xtb_bits_write(bits, previous->length - 1, 6);
+        xtb_bits_write(bits, xor >> trailing, previous->length);
+    }
+}
+
+
+static uint64_t xtb_archive_read_xor(XTB_BitStream * bits, XTB_ArchiveValue * previous) {
+    if(xtb_bits_read(bits, 1) == 1) {
+        if(xtb_bits_read(bits, 1) == 1) {
+            previous->leading = xtb_bits_read(bits, 5);
+            previous->length  = xtb_bits_read(bits, 6) + 1;
+        }
+
+        if(previous->leading + previous->length > 64) {
+            bits->error = true;
+            return 0;
+        }
+
+        previous->bits ^= xtb_bits_read(bits, previous->length) << (64 - previous->leading - previous->length);
+    }
+
+    return previous->bits;
+}
+
+
+static void xtb_archive_write_integer(XTB_BitStream * bits, int64_t * previous, int64_t value) {
+    uint64_t delta  = (uint64_t) value - (uint64_t) *previous;
+    uint64_t zigzag = (delta << 1) ^ (uint64_t) ((int64_t) delta >> 63);
+
+    *previous = value;
+
+    if(zigzag == 0) {
+        xtb_bits_write(bits, 0, 1);
+    } else {
+        int length = 64 - __builtin_clzll(zigzag);
+
+        xtb_bits_write(bits, 1, 1);
+        xtb_bits_write(bits, length - 1, 6);
+        xtb_bits_write(bits, zigzag, length);
+    }
+}
+
+
+static int64_t xtb_archive_read_integer(XTB_BitStream * bits, int64_t * previous) {
+    if(xtb_bits_read(bits, 1) == 1) {
+        uint64_t zigzag = xtb_bits_read(bits, xtb_bits_read(bits, 6) + 1);
+        uint64_t delta  = (zigzag >> 1) ^ (0 - (zigzag & 1));
+
+        *previous = (int64_t) ((uint64_t) *previous + delta);
+    }
+
+    return *previous;
+}
+
+
+static const double xtb_archive_scale[XTB_ARCHIVE_DIGITS + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8
+};
+
+
+/*
+ * writer and reader have to restore the same bits, fast math would turn the division to 
+ * multiplication by reciprocal, which is not exact for decimal prices
+ */
+__attribute__((noinline, optimize("no-fast-math")))
+static double xtb_archive_restore(int64_t points, int digits) {
+    return (double) points / xtb_archive_scale[digits];
+}
+
+
+/*
+ * price with given number of decimal digits restored exactly from integer of points
+ */
+static inline bool xtb_archive_points(double value, int digits, int64_t * points) {
+    double scaled = value * xtb_archive_scale[digits];
+    double restored;
+
+    if(!(fabs(scaled) < 9007199254740992.0)) {
+        return false;
+    }
+
+    *points  = llround(scaled);
+    restored = xtb_archive_restore(*points, digits);
+
+    return memcmp(&restored, &value, sizeof(double)) == 0;
+}
+
+
+/*
+ * prices are mostly decimal numbers with fixed digits, so they are written as delta of points,
+ * digits are written again when they change and the other values fall back to xor
+ */
+static void xtb_archive_write_value(XTB_BitStream * bits, XTB_ArchiveValue * previous, double value) {
+    int64_t points;
+
+    if(xtb_archive_points(value, previous->digits, &points) == true) {
+        xtb_bits_write(bits, 0, 1);
+    } else {
+        int digits = 0;
+
+        while(digits <= XTB_ARCHIVE_DIGITS && xtb_archive_points(value, digits, &points) == false) {
+            digits++;
+        }
+
+        if(digits > XTB_ARCHIVE_DIGITS) {
+            uint64_t current;
+
+            memcpy(&current, &value, sizeof(uint64_t));
+            xtb_bits_write(bits, 3, 2);
+            xtb_archive_write_xor(bits, previous, current);
+            return;
+        }
+
+        xtb_bits_write(bits, 2, 2);
+        xtb_bits_write(bits, digits, 4);
+        previous->digits = digits;
+    }
+
+    xtb_archive_write_integer(bits, &previous->points, points);
+    memcpy(&previous->bits, &value, sizeof(uint64_t));
+}
+
+
+static double xtb_archive_read_value(XTB_BitStream * bits, XTB_ArchiveValue * previous) {
+    double value;
+
+    if(xtb_bits_read(bits, 1) == 1) {
+        if(xtb_bits_read(bits, 1) == 1) {
+            uint64_t current = xtb_archive_read_xor(bits, previous);
+            memcpy(&value, &current, sizeof(double));
+            return value;
+        }
+
+        if((previous->digits = xtb_bits_read(bits, 4)) > XTB_ARCHIVE_DIGITS) {
+            bits->error = true;
+            return 0;
+        }
+    }
+
+    value = xtb_archive_restore(xtb_archive_read_integer(bits, &previous->points), previous->digits);
+    memcpy(&previous->bits, &value, sizeof(uint64_t));
+
+    return value;
+}
+
+
+struct XTB_ArchiveWriter {
+    int fd;
+    XTB_ArchiveBlock block;
+    XTB_BitStream bits;
+    XTB_ArchiveState state;
+
+    /*
+     * index of symbol in the current block increased by one, zero for symbols not yet used
+     */
+    uint16_t index[XTB_SYMBOL_ID_CAPACITY];
+};
+
+
+/*
+ * returns length of the valid part of archive, index of blocks is built if it isn't NULL
+ */
+static off_t xtb_archive_scan(int fd, XTB_ArchiveIndex ** index, size_t * size) {
+    struct stat st;
+    XTB_ArchiveBlock block;
+    off_t offset    = 0;
+    size_t capacity = 0;
+
+    if(fstat(fd, &st) != 0) {
+        return -1;
+    }
+
+    while(offset + (off_t) sizeof(XTB_ArchiveBlock) <= st.st_size
+            && pread(fd, &block, sizeof(XTB_ArchiveBlock), offset) == sizeof(XTB_ArchiveBlock)
+            && block.magic == XTB_ARCHIVE_MAGIC
+            && block.size <= XTB_ARCHIVE_BLOCK
+            && offset + (off_t) (sizeof(XTB_ArchiveBlock) + block.size) <= st.st_size) {
+        if(index != NULL) {
+            if(*size == capacity) {
+                capacity = capacity > 0 ? capacity * 2 : 64;
+                XTB_ArchiveIndex * resized = realloc(*index, sizeof(XTB_ArchiveIndex) * capacity);
+
+                if(resized == NULL) {
+                    return -1;
+                }
+
+                *index = resized;
+            }
+
+            (*index)[(*size)++] = (XTB_ArchiveIndex) {
+                .offset = offset
+                , .first = block.first
+                , .last = block.last
+                , .count = block.count
+            };
+        }
+
+        offset += sizeof(XTB_ArchiveBlock) + block.size;
+    }
+
+    return offset;
+}
+
+
+static void xtb_archive_writer_reset(XTB_ArchiveWriter * self) {
+    for(size_t i = 0; i < self->state.symbols; i++) {
+        self->index[self->state.id[i]] = 0;
+    }
+
+    memset(&self->state, 0, sizeof(XTB_ArchiveState));
+    memset(self->bits.data, 0, XTB_ARCHIVE_BLOCK);
+
+    self->bits.position = 0;
+    self->block         = (XTB_ArchiveBlock) {.magic = XTB_ARCHIVE_MAGIC};
+}
+
+
+XTB_ArchiveWriter * xtb_archive_writer_open(const char * path) {
+    XTB_ArchiveWriter * self = calloc(1, sizeof(XTB_ArchiveWriter));
+    uint8_t * data           = malloc(XTB_ARCHIVE_BLOCK);
+
+    if(self == NULL || data == NULL || (self->fd = open(path, O_RDWR | O_CREAT, 0644)) < 0) {
+        __assert("can't open archive\n");
+        free(self);
+        free(data);
+        return NULL;
+    }
+
+    /*
+     * block broken by crash of previous writer is cut off, so new blocks are reachable
+     */
+    off_t length = xtb_archive_scan(self->fd, NULL, NULL);
+
+    if(length < 0 || ftruncate(self->fd, length) != 0 || lseek(self->fd, length, SEEK_SET) != length) {
+        __assert("can't open archive\n");
+        close(self->fd);
+        free(self);
+        free(data);
+        return NULL;
+    }
+
+    self->bits = (XTB_BitStream) {.data = data, .size = XTB_ARCHIVE_BLOCK};
+    xtb_archive_writer_reset(self);
+
+    return self;
+}
+
+
+static bool xtb_file_write(int fd, const void * data, size_t size) {
+    while(size > 0) {
+        ssize_t written = write(fd, data, size);
+
+        if(written < 0 && errno == EINTR) {
+            continue;
+        } else if(written <= 0) {
+            return false;
+        }
+
+        data  = (const uint8_t *) data + written;
+        size -= written;
+    }
+
+    return true;
+}
+
+
+bool xtb_archive_writer_flush(XTB_ArchiveWriter * self) {
+    if(self->block.count == 0) {
+        return true;
+    }
+
+    self->block.size = (self->bits.position + 7) / 8;
+
+    bool result = xtb_file_write(self->fd, &self->block, sizeof(XTB_ArchiveBlock))
+                    && xtb_file_write(self->fd, self->bits.data, self->block.size);
+
+    xtb_archive_writer_reset(self);
+
+    if(result == false) {
+        __assert("can't write archive\n");
+    }
+
+    return result;
+}
+
+
+/*
+ * returns state of symbol in the current block, new symbol is written with its name
+ */
+static XTB_ArchiveStream * xtb_archive_writer_begin(
+        XTB_ArchiveWriter * self, int type, const char * symbol, XTB_SymbolId id, int64_t time) {
+    if(id >= XTB_SYMBOL_ID_CAPACITY && (id = xtb_symbol_intern(symbol)) == XTB_SYMBOL_NONE) {
+        return NULL;
+    }
+
+    if((self->bits.position + 7) / 8 + XTB_ARCHIVE_EVENT > XTB_ARCHIVE_BLOCK
+            || (self->index[id] == 0 && self->state.symbols == XTB_ARCHIVE_SYMBOLS)) {
+        if(xtb_archive_writer_flush(self) == false) {
+            return NULL;
+        }
+    }
+
+    XTB_ArchiveState * state = &self->state;
+
+    xtb_bits_write(&self->bits, type, 1);
+
+    if(self->index[id] == 0) {
+        size_t length = strnlen(symbol, XTB_SYMBOL_SIZE - 1);
+
+        xtb_bits_write(&self->bits, 1, 1);
+        xtb_bits_write(&self->bits, length, 5);
+
+        for(size_t i = 0; i < length; i++) {
+            xtb_bits_write(&self->bits, (uint8_t) symbol[i], 8);
+        }
+
+        memcpy(state->symbol[state->symbols], symbol, length);
+        state->id[state->symbols] = id;
+        self->index[id]           = ++state->symbols;
+    } else {
+        xtb_bits_write(&self->bits, 0, 1);
+        xtb_bits_write(&self->bits, self->index[id] - 1, xtb_bits_width(state->symbols));
+    }
+
+    if(self->block.count == 0 || time < self->block.first) {
+        self->block.first = time;
+    }
+
+    if(self->block.count == 0 || time > self->block.last) {
+        self->block.last = time;
+    }
+
+    self->block.count++;
+
+    return &state->stream[self->index[id] - 1][type];
+}
+
+
+bool xtb_archive_write_tick(XTB_ArchiveWriter * self, const XTB_Tick * tick) {
+    XTB_ArchiveStream * stream = xtb_archive_writer_begin(self, 0, tick->symbol, tick->id, tick->timestamp);
+
+    if(stream == NULL) {
+        return false;
+    }
+
+    xtb_archive_write_time(&self->bits, stream, tick->timestamp);
+    xtb_archive_write_value(&self->bits, &stream->value[0], tick->ask);
+    xtb_archive_write_value(&self->bits, &stream->value[1], tick->bid);
+    xtb_archive_write_value(&self->bits, &stream->value[2], tick->high);
+    xtb_archive_write_value(&self->bits, &stream->value[3], tick->low);
+    xtb_archive_write_value(&self->bits, &stream->value[4], tick->spread_raw);
+    xtb_archive_write_value(&self->bits, &stream->value[5], tick->spread_table);
+    xtb_archive_write_integer(&self->bits, &stream->integer[0], tick->ask_volume);
+    xtb_archive_write_integer(&self->bits, &stream->integer[1], tick->bid_volume);
+    xtb_archive_write_integer(&self->bits, &stream->integer[2], tick->level);
+    xtb_archive_write_integer(&self->bits, &stream->integer[3], tick->quote_id);
+
+    return true;
+}
+
+
+bool xtb_archive_write_candle(XTB_ArchiveWriter * self, const XTB_Candle * candle) {
+    XTB_ArchiveStream * stream = xtb_archive_writer_begin(self, 1, candle->symbol, candle->id, candle->ctm);
+
+    if(stream == NULL) {
+        return false;
+    }
+
+    xtb_archive_write_time(&self->bits, stream, candle->ctm);
+    xtb_archive_write_value(&self->bits, &stream->value[0], candle->open);
+    xtb_archive_write_value(&self->bits, &stream->value[1], candle->close);
+    xtb_archive_write_value(&self->bits, &stream->value[2], candle->high);
+    xtb_archive_write_value(&self->bits, &stream->value[3], candle->low);
+    xtb_archive_write_value(&self->bits, &stream->value[4], candle->vol);
+    xtb_archive_write_integer(&self->bits, &stream->integer[0], candle->quote_id);
+
+    return true;
+}
+
+
+void xtb_archive_writer_close(XTB_ArchiveWriter * self) {
+    if(self != NULL) {
+        xtb_archive_writer_flush(self);
+        fsync(self->fd);
+        close(self->fd);
+        free(self->bits.data);
+        free(self);
+    }
+}
+
+
+struct XTB_ArchiveReader {
+    int fd;
+    XTB_ArchiveIndex * index;
+    size_t size;
+
+    uint8_t * data;
+    XTB_ArchiveState state;
+};
+
+
+XTB_ArchiveReader * xtb_archive_reader_open(const char * path) {
+    XTB_ArchiveReader * self = calloc(1, sizeof(XTB_ArchiveReader));
+
+    if(self == NULL || (self->data = malloc(XTB_ARCHIVE_BLOCK)) == NULL) {
+        free(self);
+        return NULL;
+    }
+
+    if((self->fd = open(path, O_RDONLY)) < 0 || xtb_archive_scan(self->fd, &self->index, &self->size) < 0) {
+        __assert("can't open archive\n");
+        xtb_archive_reader_close(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+
+const XTB_ArchiveIndex * xtb_archive_reader_index(const XTB_ArchiveReader * self, size_t * size) {
+    *size = self->size;
+    return self->index;
+}
+
+
+/*
+ * decodes block and delivers events from from to to, returns number of delivered events or
+ * -1 if the block is broken
+ */
+static int64_t xtb_archive_reader_block(
+        XTB_ArchiveReader * self, const XTB_ArchiveIndex * index, int64_t from, int64_t to, 
+        const XTB_StreamHandler * handler, void * param) {
+    XTB_ArchiveBlock block;
+    XTB_ArchiveState * state = &self->state;
+
+    if(pread(self->fd, &block, sizeof(XTB_ArchiveBlock), index->offset) != sizeof(XTB_ArchiveBlock)
+            || block.size > XTB_ARCHIVE_BLOCK
+            || pread(self->fd, self->data, block.size, index->offset + sizeof(XTB_ArchiveBlock)) != (ssize_t) block.size) {
+        return -1;
+    }
+
+    XTB_BitStream bits = {.data = self->data, .size = block.size};
+    int64_t delivered  = 0;
+
+    memset(state, 0, sizeof(XTB_ArchiveState));
+
+    for(uint32_t i = 0; i < block.count && bits.error == false; i++) {
+        int type = xtb_bits_read(&bits, 1);
+        size_t symbol;
+
+        if(xtb_bits_read(&bits, 1) == 1) {
+            size_t length = xtb_bits_read(&bits, 5);
+
+            if((symbol = state->symbols++) == XTB_ARCHIVE_SYMBOLS) {
+                return -1;
+            }
+
+            for(size_t j = 0; j < length; j++) {
+                state->symbol[symbol][j] = xtb_bits_read(&bits, 8);
+            }
+
+            state->id[symbol] = xtb_symbol_intern(state->symbol[symbol]);
+        } else if((symbol = xtb_bits_read(&bits, xtb_bits_width(state->symbols))) >= state->symbols) {
+            return -1;
+        }
+
+        XTB_ArchiveStream * stream = &state->stream[symbol][type];
+        int64_t time               = xtb_archive_read_time(&bits, stream);
+        bool deliver               = time >= from && time <= to;
+
+        if(type == 0) {
+            XTB_Tick tick = {
+                .timestamp = time
+                , .ask = xtb_archive_read_value(&bits, &stream->value[0])
+                , .bid = xtb_archive_read_value(&bits, &stream->value[1])
+                , .high = xtb_archive_read_value(&bits, &stream->value[2])
+                , .low = xtb_archive_read_value(&bits, &stream->value[3])
+                , .spread_raw = xtb_archive_read_value(&bits, &stream->value[4])
+                , .spread_table = xtb_archive_read_value(&bits, &stream->value[5])
+                , .ask_volume = xtb_archive_read_integer(&bits, &stream->integer[0])
+                , .bid_volume = xtb_archive_read_integer(&bits, &stream->integer[1])
+                , .level = xtb_archive_read_integer(&bits, &stream->integer[2])
+                , .quote_id = xtb_archive_read_integer(&bits, &stream->integer[3])
+                , .id = state->id[symbol]
+            };
+
+            if(deliver == true && bits.error == false && handler->tick_prices != NULL) {
+                memcpy(tick.symbol, state->symbol[symbol], XTB_SYMBOL_SIZE);
+                handler->tick_prices(param, &tick);
+                delivered++;
+            }
+        } else {
+            XTB_Candle candle = {
+                .ctm = time
+                , .open = xtb_archive_read_value(&bits, &stream->value[0])
+                , .close = xtb_archive_read_value(&bits, &stream->value[1])
+                , .high = xtb_archive_read_value(&bits, &stream->value[2])
+                , .low = xtb_archive_read_value(&bits, &stream->value[3])
+                , .vol = xtb_archive_read_value(&bits, &stream->value[4])
+                , .quote_id = xtb_archive_read_integer(&bits, &stream->integer[0])
+                , .id = state->id[symbol]
+            };
+
+            if(deliver == true && bits.error == false && handler->candle != NULL) {
+                memcpy(candle.symbol, state->symbol[symbol], XTB_SYMBOL_SIZE);
+                handler->candle(param, &candle);
+                delivered++;
+            }
+        }
+    }
+
+    return bits.error == false ? delivered : -1;
+}
+
+
+int64_t xtb_archive_reader_replay(
+        XTB_ArchiveReader * self, int64_t from, int64_t to, const XTB_StreamHandler * handler, void * param) {
+    int64_t delivered = 0;
+
+    for(size_t i = 0; i < self->size; i++) {
+        if(self->index[i].last < from || self->index[i].first > to) {
+            continue;
+        }
+
+        int64_t result = xtb_archive_reader_block(self, &self->index[i], from, to, handler, param);
+
+        if(result < 0) {
+            __assert("archive block is broken\n");
+            return -1;
+        }
+
+        delivered += result;
+    }
+
+    return delivered;
+}
+
+
+void xtb_archive_reader_close(XTB_ArchiveReader * self) {
+    if(self != NULL) {
+        if(self->fd >= 0) {
+            close(self->fd);
+        }
+
+        free(self->index);
+        free(self->data);
+        free(self);
+    }
+}
+
+
+static XTB_StreamClient * xtb_stream_client_last(XTB_StreamClient * self) {
+    if(self != NULL) {
+        while(self->next != NULL) {
+            self = self->next;
+        }
+    }
+
+    return self;  
+}
+
+
+#define XTB_STREAM_STALE_TIMEOUT 15000
+#define XTB_STREAM_RECONNECT_DELAY 250
+#define XTB_STREAM_RECONNECT_MAX_DELAY 30000
+#define XTB_STREAM_SESSION_TIMEOUT 10000
+#define XTB_STREAM_SESSION_POLL 50
+
+
+static bool xtb_stream_client_subscribe_command(XTB_StreamClient * self, char * command) {
+    snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
+            , "{\"command\": \"%s\", \"streamSessionId\": \"%s\"}", command, self->client->stream_session_id);
+    return xtb_api_send(&self->api, self->cmd_buffer);
+}
+
+
+static bool xtb_stream_client_send_subscription(XTB_StreamClient * self, XTB_Subscription * subscription) {
+    if(subscription->symbol == NULL) {
+        return xtb_stream_client_subscribe_command(self, (char *) subscription->command);
+    } else if(subscription->max_level < 0) {
+        snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
+                , "{\"command\": \"%s\", \"streamSessionId\": \"%s\", \"symbol\": \"%s\"}"
+                , subscription->command, self->client->stream_session_id, subscription->symbol);
+    } else {
+        snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
+                , "{\"command\": \"%s\", \"streamSessionId\": \"%s\", \"symbol\": \"%s\", \"minArrivalTime\": %ld, \"maxLevel\": %d}"
+                , subscription->command, self->client->stream_session_id, subscription->symbol
+                , subscription->min_arrival_time, subscription->max_level);
+    }
+
+    return xtb_api_send(&self->api, self->cmd_buffer);
+}
+
+
+static XTB_Subscription ** xtb_stream_client_find_subscription(
+        XTB_StreamClient * self, const char * command, const char * symbol) {
+    XTB_Subscription ** it = &self->subscription;
+
+    while(*it != NULL 
+            && (strcmp((*it)->command, command) != 0 
+                || (symbol != NULL && strcmp((*it)->symbol, symbol) != 0))) {
+        it = &(*it)->next;
+    }
+
+    return it;
+}
+
+
+/*
+ * subscription is recorded even if it can't be sent now, so it is restored after reconnect
+ */
+static bool xtb_stream_client_subscribe(
+        XTB_StreamClient * self, const char * command, char * symbol, time_t min_arrival_time, int max_level) {
+    XTB_Subscription ** it = xtb_stream_client_find_subscription(self, command, symbol);
+
+    if(*it == NULL) {
+        if((*it = malloc(sizeof(XTB_Subscription))) == NULL) {
+            return false;
+        }
+
+        **it = (XTB_Subscription) {
+            .command = command
+            , .symbol = symbol != NULL ? strdup(symbol) : NULL
+        };
+    }
+
+    (*it)->min_arrival_time = min_arrival_time;
+    (*it)->max_level        = max_level;
+
+    return self->api.bio != NULL && xtb_stream_client_send_subscription(self, *it);
+}
+
+
+static void xtb_stream_client_forget(XTB_StreamClient * self, const char * command, char * symbol) {
+    XTB_Subscription ** it = xtb_stream_client_find_subscription(self, command, symbol);
+
+    if(*it != NULL) {
+        XTB_Subscription * subscription = *it;
+
+        *it = subscription->next;
+
+        free(subscription->symbol);
+        free(subscription);
+    }
+}
+
+
+/*
+ * keep alive messages are requested always, so silent connection can be recognized
+ */
+static bool xtb_stream_client_replay(XTB_StreamClient * self) {
+    if(xtb_stream_client_subscribe_command(self, "getKeepAlive") == false) {
+        return false;
+    }
+
+    for(XTB_Subscription * it = self->subscription; it != NULL; it = it->next) {
+        if(xtb_stream_client_send_subscription(self, it) == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+XTB_StreamClient * xtb_stream_client_new(XTB_Client * self, StreamClientCallback *callback, void * param) {
+    XTB_Api api = {0};
+
+    const char * url = XTB_API_STREAM_URL(self->mode);
+
+    if(xtb_api_connect(&api, url) == true) {
+        XTB_StreamClient * stream_client = malloc(sizeof(XTB_StreamClient));
+
+        /*
+         * get last stream client from linked list
+         */
+        XTB_StreamClient * last = xtb_stream_client_last(self->stream_client);
+        
+        *stream_client = (XTB_StreamClient) {
+            .api = api
+            , .client = self
+            , .callback = *callback
+            , .param = param
+            , .last_receive = xtb_time_ms()
+            , .last_activity = xtb_clock_ms()
+            , .stale_timeout = XTB_STREAM_STALE_TIMEOUT
+            , .reconnect_delay = XTB_STREAM_RECONNECT_DELAY
+            , .seed = (unsigned int) xtb_clock_ms()
+            , .prev = last
+            , .next = NULL
+        };
+
+        if(last != NULL) {
+            last->next = stream_client;
+        } else {
+            self->stream_client = stream_client;
+        }
+
+        if(xtb_stream_client_replay(stream_client) == false) {
+            __assert("keep alive subscription error\n");
+        }
+
+        return stream_client;
+    } else {
+        return NULL;
+    }
+}
+
+
+/*
+ * typed features of client are used during replay if the client is given, otherwise
+ * the stream client refers to empty client
+ */
+static XTB_Client xtb_offline_client;
+
+
+XTB_StreamClient * xtb_stream_client_new_offline(XTB_Client * self, StreamClientCallback * callback, void * param) {
+    XTB_StreamClient * stream_client = malloc(sizeof(XTB_StreamClient));
+
+    if(stream_client == NULL) {
+        return NULL;
+    }
+
+    *stream_client = (XTB_StreamClient) {
+        .client = self != NULL ? self : &xtb_offline_client
+        , .callback = *callback
+        , .param = param
+        , .last_receive = xtb_time_ms()
+        , .last_activity = xtb_clock_ms()
+        , .stale_timeout = -1
+        , .offline = true
+    };
+
+    return stream_client;
+}
+
+
+void xtb_stream_client_set_handler(XTB_StreamClient * self, const XTB_StreamHandler * handler) {
+    self->handler = handler != NULL ? *handler : (XTB_StreamHandler) {0};
+}
+
+
+static struct XTB_EventRing * xtb_event_ring_new(size_t capacity, XTB_RingPolicy policy);
+static void xtb_event_ring_delete(struct XTB_EventRing * self);
+
+
+bool xtb_stream_client_enable_ring(XTB_StreamClient * self, size_t capacity, XTB_RingPolicy policy) {
+    if(self->ring != NULL) {
+        __assert("ring is already enabled\n");
+        return false;
+    }
+
+    return capacity > 0 && (self->ring = xtb_event_ring_new(capacity, policy)) != NULL;
+}
+
+
+void xtb_stream_client_set_stale_timeout(XTB_StreamClient * self, int timeout) {
+    self->stale_timeout = timeout;
+}
+
+
+void xtb_stream_client_set_bar_builder(XTB_StreamClient * self, XTB_BarBuilder * bars) {
+    self->bars = bars;
+}
+
+
+void xtb_stream_client_set_archive(XTB_StreamClient * self, XTB_ArchiveWriter * archive) {
+    self->archive = archive;
+}
+
+
+void xtb_stream_client_set_recorder(XTB_StreamClient * self, XTB_StreamRecorder * recorder) {
+    self->recorder = recorder;
+}
+
+
+/*
+ * main client processed neither by I/O thread nor by event loop is owned by the thread
+ * processing the stream client, so it can be used synchronously
+ */
+static inline bool xtb_stream_client_owns_client(XTB_StreamClient * self) {
+    return atomic_load(&self->client->io_running) == false && self->client->api.loop == NULL;
+}
+
+
+/*
+ * candles are subscribed before the history is loaded, so minutes closed during loading 
+ * are received by stream and the overlap is removed by time of the last contained minute,
+ * history is loaded asynchronously unless the main client is owned by the stream thread
+ */
+XTB_LiveSeries * xtb_stream_client_add_series(
+        XTB_StreamClient * self, const char * symbol, XTB_Period period, size_t capacity
+        , XTB_SeriesCallback callback, void * param) {
+    if(period > XTB_PERIOD_W1 || capacity == 0) {
+        __assert("unsupported series\n");
+        return NULL;
+    }
+
+    XTB_LiveSeries * series = xtb_live_series_new(symbol, period, capacity);
+
+    if(series == NULL) {
+        return NULL;
+    }
+
+    series->next = self->series;
+    self->series = series;
+
+    int64_t from = xtb_time_ms() - (int64_t) period * 1000 * capacity;
+    bool loaded  = xtb_stream_client_subscribe_candles(self, series->symbol) == true;
+
+    if(loaded == true && xtb_stream_client_owns_client(self) == true) {
+        loaded = xtb_live_series_load(series, self->client, period, from) == true
+                    && xtb_live_series_fill(series, self->client) == true;
+    } else if(loaded == true) {
+        loaded = xtb_live_series_request(series, self->client, period, from);
+    }
+
+    if(loaded == false) {
+        self->series = series->next;
+        xtb_live_series_delete(series);
+        return NULL;
+    }
+
+    series->callback = callback;
+    series->param    = param;
+
+    return series;
+}
+
+
+/*
+ * state of the main session is verified by asynchronous ping, the check is shared with 
+ * the completion, which can be called by I/O thread after the stream client was deleted
+ */
+struct XTB_SessionCheck {
+    atomic_int state;
+    atomic_int refs;
+    int64_t deadline;
+};
+
+
+static void xtb_session_check_release(struct XTB_SessionCheck * self) {
+    if(self != NULL && atomic_fetch_sub(&self->refs, 1) == 1) {
+        free(self);
+    }
+}
+
+
+static void xtb_session_check_complete(void * param, XTB_Error error, Json * result) {
+    struct XTB_SessionCheck * self = param;
+
+    atomic_store(&self->state, error == XTB_Error_None ? XTB_Session_Valid : XTB_Session_Lost);
+    json_delete(result);
+    xtb_session_check_release(self);
+}
+
+
+/*
+ * the session is verified by asynchronous ping, main client which isn't processed by anybody 
+ * else is processed meanwhile by the stream client, the main client can log in again only if 
+ * it isn't processed by I/O thread or other event loop
+ */
+static XTB_Session xtb_stream_client_session(XTB_StreamClient * self) {
+    XTB_Client * client = self->client;
+    bool owner          = xtb_stream_client_owns_client(self);
+
+    if(client->relogin != NULL) {
+        return xtb_client_relogin(client);
+    }
+
+    if(self->session == NULL) {
+        struct XTB_SessionCheck * check = malloc(sizeof(struct XTB_SessionCheck));
+
+        if(check == NULL) {
+            return XTB_Session_Lost;
+        }
+
+        *check = (struct XTB_SessionCheck) {
+            .state = XTB_Session_Pending
+            , .refs = 2
+            , .deadline = xtb_clock_ms() + XTB_STREAM_SESSION_TIMEOUT
+        };
+
+        if(client->stream_session_id == NULL 
+                || xtb_client_async_ping(client, xtb_session_check_complete, check) == false) {
+            atomic_store(&check->state, XTB_Session_Lost);
+            atomic_fetch_sub(&check->refs, 1);
+        }
+
+        self->session = check;
+    }
+
+    if(owner == true) {
+        xtb_client_process(client);
+    }
+
+    XTB_Session state = atomic_load(&self->session->state);
+
+    if(state == XTB_Session_Pending && xtb_clock_ms() < self->session->deadline) {
+        return XTB_Session_Pending;
+    }
+
+    xtb_session_check_release(self->session);
+    self->session = NULL;
+
+    if(state == XTB_Session_Valid) {
+        return XTB_Session_Valid;
+    }
+
+    if(owner == true || (atomic_load(&client->io_running) == false && client->api.loop == self->api.loop)) {
+        return xtb_client_relogin(client);
+    }
+
+    __assert("main session is lost, client has to log in again by its owner\n");
+
+    return XTB_Session_Lost;
+}
+
+
+/*
+ * closed connection stays in event loop without socket, so the check of the loop can 
+ * connect again
+ */
+static void xtb_stream_client_disconnect(XTB_StreamClient * self) {
+    XTB_EventLoop * loop = self->api.loop;
+
+    if(loop != NULL) {
+        xtb_event_loop_detach(loop, &self->api);
+        self->api.loop = NULL;
+    }
+
+    xtb_api_close(&self->api);
+
+    self->api.loop        = loop;
+    self->next_attempt    = xtb_clock_ms();
+    self->reconnect_delay = XTB_STREAM_RECONNECT_DELAY;
+}
+
+
+/*
+ * the connection is opened by worker after the main session was verified, the finished 
+ * connection is taken over and it isn't registered in event loop yet
+ */
+static XTB_Session xtb_stream_client_open(XTB_StreamClient * self) {
+    if(self->connect == NULL) {
+        XTB_Session session = xtb_stream_client_session(self);
+
+        if(session != XTB_Session_Valid) {
+            return session;
+        }
+
+        if((self->connect = xtb_connect_start(XTB_API_STREAM_URL(self->client->mode), NULL, NULL)) == NULL) {
+            return XTB_Session_Lost;
+        }
+    }
+
+    XTB_Session state = atomic_load(&self->connect->state);
+
+    if(state == XTB_Session_Pending) {
+        return XTB_Session_Pending;
+    }
+
+    if(state == XTB_Session_Valid) {
+        xtb_connect_take(self->connect, &self->api);
+    }
+
+    xtb_connect_release(self->connect);
+    self->connect = NULL;
+
+    return state;
+}
+
+
+/*
+ * one step of connecting, which never blocks, unfinished attempt is checked again after 
+ * short poll interval, failed attempt plans the next one after growing delay, random 
+ * part of delay spreads reconnects of more clients in time
+ */
+static bool xtb_stream_client_connect(XTB_StreamClient * self) {
+    XTB_EventLoop * loop = self->api.loop;
+    int64_t now          = xtb_clock_ms();
+
+    if(self->offline == true || self->api.bio != NULL || now < self->next_attempt) {
+        return self->api.bio != NULL;
+    }
+
+    XTB_Session session = xtb_stream_client_open(self);
+
+    if(session == XTB_Session_Pending) {
+        self->next_attempt = now + XTB_STREAM_SESSION_POLL;
+        return false;
+    }
+
+    if(session == XTB_Session_Valid) {
+        if(xtb_stream_client_replay(self) == true && (loop == NULL || xtb_event_loop_attach(loop, &self->api) == true)) {
+            self->next_attempt  = 0;
+            self->last_activity = xtb_clock_ms();
+
+            /*
+             * trades closed and minutes missed during the gap are loaded again, asynchronously
+             * if the main client is processed by other thread or event loop
+             */
+            bool owner = xtb_stream_client_owns_client(self);
+
+            if(self->client->positions != NULL) {
+                if(owner == true) {
+                    xtb_client_sync_positions(self->client);
+                } else {
+                    xtb_client_async_sync_positions(self->client);
+                }
+            }
+
+            for(XTB_LiveSeries * series = self->series; series != NULL; series = series->next) {
+                if(owner == true) {
+                    xtb_live_series_fill(series, self->client);
+                } else {
+                    xtb_live_series_refill(series, self->client);
+                }
+            }
+
+            if(self->callback.gap != NULL) {
+                self->callback.gap(self->param, self->last_receive, xtb_time_ms());
+            }
+
+            return true;
+        }
+
+        xtb_api_close(&self->api);
+    }
+
+    int delay = self->reconnect_delay;
+
+    self->api.loop        = loop;
+    self->next_attempt    = xtb_clock_ms() + delay / 2 + rand_r(&self->seed) % (delay / 2 + 1);
+    self->reconnect_delay = delay * 2 < XTB_STREAM_RECONNECT_MAX_DELAY ? delay * 2 : XTB_STREAM_RECONNECT_MAX_DELAY;
+
+    return false;
+}
+
+
+/*
+ * stream messages are flat objects of numbers and strings with one nested data 
+ * object, so they are decoded by simple scanner without building of Json tree
+ */
+typedef struct {
+    const char * key;
+    size_t key_size;
+    const char * value;
+    size_t value_size;
+}XTB_Field;
+
+
+static const char * xtb_scan_skip(const char * it) {
+    while(*it == ' ' || *it == '\t' || *it == '\r' || *it == '\n') {
+        it++;
+    }
+
+    return it;
+}
+
+
+static const char * xtb_scan_string(const char * it) {
+    while(*it != '"' && *it != '\0') {
+        if(*it == '\\' && it[1] != '\0') {
+            it++;
+        }
+
+        it++;
+    }
+
+    return it;
+}
+
+
+/*
+ * skips nested object or array including strings containing brackets
+ */
+static const char * xtb_scan_nested(const char * it) {
+    size_t depth = 0;
+
+    do {
+        if(*it == '{' || *it == '[') {
+            depth++;
+        } else if(*it == '}' || *it == ']') {
+            depth--;
+        } else if(*it == '"') {
+            it = xtb_scan_string(it + 1);
+
+            if(*it == '\0') {
+                return it;
+            }
+        }
+
+        it++;
+    } while(depth > 0 && *it != '\0');
+
+    return it;
+}
+
 
-    /*
-     * check runtime error values
-     */
-    if(json_is_type(json_open, JsonFrac) == false
-            || json_is_type(json_close, JsonFrac) == false
-            || json_is_type(json_high, JsonFrac) == false
-            || json_is_type(json_low, JsonFrac) == false
-            || json_is_type(json_vol, JsonFrac) == false
-            || json_is_type(json_ctm, JsonInteger) == false) {
+/*
+ * reads next key and value of object, it points behind the opening bracket at the 
+ * beginning, returns NULL at the end of object, string values are without quotes
+ */
+static const char * xtb_scan_field(const char * it, XTB_Field * field) {
+    it = xtb_scan_skip(it);
+
+    if(*it == ',') {
+        it = xtb_scan_skip(it + 1);
+    }
+
+    if(*it != '"') {
         return NULL;
     }
 
-    /*
-     * assembly the candle data record
-     */
-    float open_val  = atof(json_open->string);
-    float close_val = atof(json_close->string);
-    float high_val  = atof(json_high->string);
-    float low_val   = atof(json_low->string);
-    long timestamp  = strtol(json_ctm->string, NULL, 10);
-    float vol       = atof(json_vol->string);
+    field->key      = it + 1;
+    it              = xtb_scan_string(field->key);
+    field->key_size = it - field->key;
 
-    Json * candle_record = json_object_new(6);
+    if(*it == '\0' || *(it = xtb_scan_skip(it + 1)) != ':') {
+        return NULL;
+    }
 
-    json_object_set_record(candle_record, 0, "timestamp", json_integer_new(timestamp));
-    json_object_set_record(candle_record, 1, "open", json_frac_new(open_val / pow(10, digits)));
-    json_object_set_record(candle_record, 2, "close", json_frac_new((open_val + close_val) / pow(10, digits)));
-    json_object_set_record(candle_record, 3, "high", json_frac_new((open_val + high_val) / pow( 10, digits)));
-    json_object_set_record(candle_record, 4, "low", json_frac_new((open_val + low_val) / pow(10, digits)));
-    json_object_set_record(candle_record, 5, "vol", json_frac_new(vol));
+    it = xtb_scan_skip(it + 1);
 
-    return candle_record;
+    if(*it == '"') {
+        field->value      = it + 1;
+        it                = xtb_scan_string(field->value);
+        field->value_size = it - field->value;
+
+        return *it == '"' ? it + 1 : NULL;
+    } else if(*it == '{' || *it == '[') {
+        field->value      = it;
+        it                = xtb_scan_nested(it);
+        field->value_size = it - field->value;
+    } else {
+        field->value = it;
+
+        while(*it != ',' && *it != '}' && *it != ']' && *it != '\0' && *it != ' ') {
+            it++;
+        }
+
+        field->value_size = it - field->value;
+    }
+
+    return field->value_size > 0 ? it : NULL;
 }
 
 
-Json * xtb_client_get_lastn_candle_history(XTB_Client * self, char * symbol, XTB_Period period, size_t number) {
-    Json * chart        = NULL;
-    Json * chart_record = NULL;
-    size_t size         = 0;
-    size_t sec_prior    = period * number;
+#define XTB_FIELD_IS(field, name) \
+    ((field)->key_size == sizeof(name) - 1 && memcmp((field)->key, name, sizeof(name) - 1) == 0)
 
-    /*
-     * reading chart history, the history size is rounded by time period, so it is 
-     * sometimes nececary to load a litle bit more and then just process the
-     * required number of records
-     */
-    while(size < number) {
-        json_delete(chart);
-        chart = xtb_client_get_chart_last_request(self, symbol, period, time(NULL) - sec_prior);
 
-        if(json_is_type(chart, JsonObject) == false) {
-            __assert("command failed\n");
-            json_delete(chart);
-            return NULL;
-        }
+static inline double xtb_field_double(const XTB_Field * field) {
+    return strtod(field->value, NULL);
+}
 
-        chart_record = json_lookup(chart, "rateInfos");
 
-        /*
-         * getting array of candles 
-         */
-        if(json_is_type(chart_record, JsonArray) == false) {
-            __assert("response format error\n");
-            json_delete(chart);
-            return NULL;
-        }
+static inline int64_t xtb_field_integer(const XTB_Field * field) {
+    return strtoll(field->value, NULL, 10);
+}
 
-        size       = chart_record->array.size;
-        sec_prior *= 2;
-    } 
 
-    int digits     = atoi(json_lookup(chart, "digits")->string);
-    Json * candles = json_array_new(number);
+static void xtb_field_string(const XTB_Field * field, char * buffer, size_t size) {
+    size_t length = field->value_size < size - 1 ? field->value_size : size - 1;
 
-    /*
-     * processing output values
-     */
-    for(size_t i = 0; i < number; i++) {
-        Json * candle_record = build_candle_record(chart_record->array.value[i], digits);
+    memcpy(buffer, field->value, length);
+    buffer[length] = '\0';
+}
 
-        if(candle_record == NULL) {
-            __assert("error build candle record\n");
-            json_delete(candles);
-            json_delete(chart);
-            return NULL;
+
+static void xtb_decode_tick(const char * it, XTB_Tick * tick) {
+    XTB_Field field;
+
+    while((it = xtb_scan_field(it, &field)) != NULL) {
+        if(XTB_FIELD_IS(&field, "ask")) {
+            tick->ask = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "bid")) {
+            tick->bid = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "symbol")) {
+            xtb_field_string(&field, tick->symbol, XTB_SYMBOL_SIZE);
+        } else if(XTB_FIELD_IS(&field, "askVolume")) {
+            tick->ask_volume = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "bidVolume")) {
+            tick->bid_volume = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "timestamp")) {
+            tick->timestamp = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "high")) {
+            tick->high = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "low")) {
+            tick->low = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "spreadRaw")) {
+            tick->spread_raw = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "spreadTable")) {
+            tick->spread_table = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "level")) {
+            tick->level = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "quoteId")) {
+            tick->quote_id = xtb_field_integer(&field);
         }
+    }
+
+    tick->id = xtb_symbol_intern(tick->symbol);
+}
 
-        candles->array.value[i] = candle_record;
+
+static void xtb_decode_candle(const char * it, XTB_Candle * candle) {
+    XTB_Field field;
+
+    while((it = xtb_scan_field(it, &field)) != NULL) {
+        if(XTB_FIELD_IS(&field, "symbol")) {
+            xtb_field_string(&field, candle->symbol, XTB_SYMBOL_SIZE);
+        } else if(XTB_FIELD_IS(&field, "ctm")) {
+            candle->ctm = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "open")) {
+            candle->open = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "close")) {
+            candle->close = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "high")) {
+            candle->high = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "low")) {
+            candle->low = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "vol")) {
+            candle->vol = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "quoteId")) {
+            candle->quote_id = xtb_field_integer(&field);
+        }
     }
 
-    json_delete(chart);
-    
-    return candles;
+    candle->id = xtb_symbol_intern(candle->symbol);
 }
 
 
-static Json * xtb_client_send_get_commision(XTB_Client * self, char * symbol, float volume) {
-    snprintf(
-        self->cmd_buffer
-        , CMD_BUFFER_SIZE
-        , "{\"command\": \"getCommissionDef\", \"arguments\": {\"symbol\": \"%s\", \"volume\": %f}}"
-        , symbol
-        , volume);
-    
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
+static void xtb_decode_balance(const char * it, XTB_Balance * balance) {
+    XTB_Field field;
+
+    while((it = xtb_scan_field(it, &field)) != NULL) {
+        if(XTB_FIELD_IS(&field, "balance")) {
+            balance->balance = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "credit")) {
+            balance->credit = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "equity")) {
+            balance->equity = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "margin")) {
+            balance->margin = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "marginFree")) {
+            balance->margin_free = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "marginLevel")) {
+            balance->margin_level = xtb_field_double(&field);
+        }
+    }
 }
 
 
-Json * xtb_client_get_commision(XTB_Client * self, char * symbol, float volume) {
-    Json * json_commision = xtb_client_send_get_commision(self, symbol, volume);
+static void xtb_decode_profit(const char * it, XTB_Profit * profit) {
+    XTB_Field field;
 
-    if(read_status(json_commision) == false) {
-        __assert("command failed\n");
-        json_delete(json_commision);
-        return NULL;
+    while((it = xtb_scan_field(it, &field)) != NULL) {
+        if(XTB_FIELD_IS(&field, "order")) {
+            profit->order = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "order2")) {
+            profit->order2 = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "position")) {
+            profit->position = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "profit")) {
+            profit->profit = xtb_field_double(&field);
+        }
     }
-    
-    return extract_return_data(json_commision);
 }
 
 
-static Json * xtb_client_send_get_commision_def(XTB_Client * self, char * symbol, float volume) {
-    snprintf(
-        self->cmd_buffer
-        , CMD_BUFFER_SIZE
-        , "{\"command\": \"getCommissionDef\", \"arguments\": {\"symbol\": \"%s\", \"volume\": %f}}"
-        , symbol
-        , volume);
+static void xtb_decode_trade_record(const char * it, XTB_TradeRecord * trade) {
+    XTB_Field field;
+
+    while((it = xtb_scan_field(it, &field)) != NULL) {
+        if(XTB_FIELD_IS(&field, "symbol")) {
+            xtb_field_string(&field, trade->symbol, XTB_SYMBOL_SIZE);
+        } else if(XTB_FIELD_IS(&field, "comment")) {
+            xtb_field_string(&field, trade->comment, XTB_COMMENT_SIZE);
+        } else if(XTB_FIELD_IS(&field, "customComment")) {
+            xtb_field_string(&field, trade->custom_comment, XTB_COMMENT_SIZE);
+        } else if(XTB_FIELD_IS(&field, "state")) {
+            xtb_field_string(&field, trade->state, XTB_SYMBOL_SIZE);
+        } else if(XTB_FIELD_IS(&field, "order")) {
+            trade->order = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "order2")) {
+            trade->order2 = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "position")) {
+            trade->position = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "open_time")) {
+            trade->open_time = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "close_time")) {
+            trade->close_time = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "expiration")) {
+            trade->expiration = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "open_price")) {
+            trade->open_price = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "close_price")) {
+            trade->close_price = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "sl")) {
+            trade->sl = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "tp")) {
+            trade->tp = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "volume")) {
+            trade->volume = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "profit")) {
+            trade->profit = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "commission")) {
+            trade->commission = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "storage")) {
+            trade->storage = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "margin_rate")) {
+            trade->margin_rate = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "cmd")) {
+            trade->cmd = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "type")) {
+            trade->type = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "digits")) {
+            trade->digits = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "offset")) {
+            trade->offset = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "closed")) {
+            trade->closed = field.value[0] == 't';
+        }
+    }
 
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
+    trade->id = xtb_symbol_intern(trade->symbol);
 }
 
 
-Json * xtb_client_get_commision_def(XTB_Client * self, char * symbol, float volume) {
-    Json * json_commision = xtb_client_send_get_commision_def(self, symbol, volume);
+static void xtb_decode_trade_status(const char * it, XTB_TradeStatus * status) {
+    XTB_Field field;
+
+    while((it = xtb_scan_field(it, &field)) != NULL) {
+        if(XTB_FIELD_IS(&field, "order")) {
+            status->order = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "price")) {
+            status->price = xtb_field_double(&field);
+        } else if(XTB_FIELD_IS(&field, "requestStatus")) {
+            status->request_status = xtb_field_integer(&field);
+        } else if(XTB_FIELD_IS(&field, "message")) {
+            xtb_field_string(&field, status->message, XTB_COMMENT_SIZE);
+        } else if(XTB_FIELD_IS(&field, "customComment")) {
+            xtb_field_string(&field, status->custom_comment, XTB_COMMENT_SIZE);
+        }
+    }
+}
 
-    if(read_status(json_commision) == false) {
-        __assert("command failed\n");
-        json_delete(json_commision);
-        return NULL;
+
+/*
+ * decoded events are passed from network thread into strategy thread through bounded
+ * single-producer/single-consumer ring, every slot is guarded by sequence number, so the
+ * producer can overwrite slot not yet consumed when dropping or conflating events
+ */
+typedef struct {
+    _Alignas(64) _Atomic uint32_t seq;
+    XTB_StreamEvent event;
+}XTB_RingSlot;
+
+
+typedef struct XTB_EventRing {
+    _Alignas(64) _Atomic size_t head;
+    size_t tail_cache;
+
+    _Alignas(64) _Atomic size_t tail;
+
+    _Alignas(64) _Atomic uint64_t received;
+    _Atomic uint64_t overflow;
+    _Atomic uint64_t dropped;
+    _Atomic uint64_t conflated;
+
+    XTB_RingPolicy policy;
+    size_t mask;
+    XTB_RingSlot * slot;
+}XTB_EventRing;
+
+
+static size_t xtb_stream_event_size(XTB_StreamEventType type) {
+    switch(type) {
+        case XTB_StreamEvent_Tick: return offsetof(XTB_StreamEvent, tick) + sizeof(XTB_Tick);
+        case XTB_StreamEvent_Candle: return offsetof(XTB_StreamEvent, candle) + sizeof(XTB_Candle);
+        case XTB_StreamEvent_Balance: return offsetof(XTB_StreamEvent, balance) + sizeof(XTB_Balance);
+        case XTB_StreamEvent_Profit: return offsetof(XTB_StreamEvent, profit) + sizeof(XTB_Profit);
+        case XTB_StreamEvent_Trade: return offsetof(XTB_StreamEvent, trade) + sizeof(XTB_TradeRecord);
+        case XTB_StreamEvent_TradeStatus: return offsetof(XTB_StreamEvent, trade_status) + sizeof(XTB_TradeStatus);
+        default: return sizeof(XTB_StreamEvent);
     }
-    
-    return extract_return_data(json_commision);
 }
 
 
-Json * xtb_client_get_margin_level(XTB_Client * self) {
-    Json * json_margin = xtb_api_transaction(&self->api, "{\"command\": \"getMarginLevel\"}");
+static XTB_EventRing * xtb_event_ring_new(size_t capacity, XTB_RingPolicy policy) {
+    size_t size = 1;
 
-    if(read_status(json_margin) == false) {
-        __assert("command failed\n");
-        json_delete(json_margin);
+    while(size < capacity) {
+        size <<= 1;
+    }
+
+    XTB_EventRing * self = aligned_alloc(64, sizeof(XTB_EventRing));
+    XTB_RingSlot * slot  = aligned_alloc(64, sizeof(XTB_RingSlot) * size);
+
+    if(self == NULL || slot == NULL) {
+        free(self);
+        free(slot);
         return NULL;
     }
-    
-    return extract_return_data(json_margin);
-}
 
+    memset(self, 0, sizeof(XTB_EventRing));
+    memset(slot, 0, sizeof(XTB_RingSlot) * size);
 
-static Json * xtb_client_send_get_margin_trade(XTB_Client * self, char * symbol, float volume) {
-    snprintf(
-        self->cmd_buffer
-        , CMD_BUFFER_SIZE
-        , "{\"command\": \"getMarginTrade\", \"arguments\": {\"symbol\": \"%s\", \"volume\":%f}}"
-        , symbol
-        , volume);
+    self->policy = policy;
+    self->mask   = size - 1;
+    self->slot   = slot;
 
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
+    return self;
 }
 
 
-Json * xtb_client_get_margin_trade(XTB_Client * self, char * symbol, float volume) {
-    Json * result = xtb_client_send_get_margin_trade(self, symbol, volume);
-
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
+static void xtb_event_ring_delete(XTB_EventRing * self) {
+    if(self != NULL) {
+        free(self->slot);
+        free(self);
     }
-    
-    return extract_return_data(result);
 }
 
 
-static Json * xtb_client_send_get_profit_calculation(
-        XTB_Client * self, char * symbol, XTB_TransMode mode, float open_price, float close_price, float volume) {
-    snprintf(
-        self->cmd_buffer
-        , CMD_BUFFER_SIZE
-        , "{\"command\": \"getProfitCalculation\", \"arguments\": "
-          "{\"closePrice\", %f, \"cmd\": %d, \"openPrice\": %f, \"symbol\": %s, \"volume\": %f}}"
-        , close_price
-        , mode
-        , open_price
-        , symbol
-        , volume);
+static void xtb_ring_slot_write(XTB_RingSlot * slot, const XTB_StreamEvent * event) {
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
 
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
+    memcpy(&slot->event, event, xtb_stream_event_size(event->type));
+
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
 }
 
 
-Json * xtb_client_get_profit_calculation(
-        XTB_Client * self, float close_price, XTB_TransMode mode, float open_price, char * symbol, float volume) {
-    Json * result = xtb_client_send_get_profit_calculation(self, symbol, mode, open_price, close_price, volume);
+static void xtb_ring_slot_read(XTB_RingSlot * slot, XTB_StreamEvent * event) {
+    uint32_t seq;
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
-    }
-    
-    return extract_return_data(result);
+    do {
+        while(((seq = atomic_load_explicit(&slot->seq, memory_order_acquire)) & 1) != 0);
+
+        memcpy(event, &slot->event, xtb_stream_event_size(slot->event.type));
+        atomic_thread_fence(memory_order_acquire);
+    } while(atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq);
 }
 
 
-Json * xtb_client_get_server_time(XTB_Client * self) {
-    Json * result = xtb_api_transaction(&self->api, "{\"command\": \"getServerTime\"}");
+/*
+ * symbols which couldn't be interned are compared by name
+ */
+static inline bool xtb_symbol_same(XTB_SymbolId a, const char * a_symbol, XTB_SymbolId b, const char * b_symbol) {
+    return a != XTB_SYMBOL_NONE ? a == b : b == XTB_SYMBOL_NONE && strcmp(a_symbol, b_symbol) == 0;
+}
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
+
+/*
+ * events with the same key describe state of the same thing, so only the newest
+ * one is needed by consumer
+ */
+static bool xtb_stream_event_same(const XTB_StreamEvent * a, const XTB_StreamEvent * b) {
+    if(a->type != b->type) {
+        return false;
+    }
+
+    switch(a->type) {
+        case XTB_StreamEvent_Tick: 
+            return a->tick.level == b->tick.level && xtb_symbol_same(a->tick.id, a->tick.symbol, b->tick.id, b->tick.symbol);
+        case XTB_StreamEvent_Candle: 
+            return a->candle.ctm == b->candle.ctm 
+                        && xtb_symbol_same(a->candle.id, a->candle.symbol, b->candle.id, b->candle.symbol);
+        case XTB_StreamEvent_Balance: 
+            return true;
+        case XTB_StreamEvent_Profit: 
+            return a->profit.position == b->profit.position;
+        default:
+            return false;
     }
-    
-    return extract_return_data(result);
 }
 
 
-static Json * xtb_client_send_get_symbol(XTB_Client * self, char * symbol) {
-    snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
-        , "{\"command\": \"getSymbol\", \"arguments\": {\"symbol\": \"%s\"}}"
-        , symbol);
+static bool xtb_event_ring_conflate(XTB_EventRing * self, size_t head, size_t tail, const XTB_StreamEvent * event) {
+    for(size_t i = head; i-- > tail;) {
+        XTB_RingSlot * slot = &self->slot[i & self->mask];
 
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
-}
+        if(xtb_stream_event_same(&slot->event, event) == true) {
+            xtb_ring_slot_write(slot, event);
+
+            /*
+             * the slot could be consumed in the meantime, then the event is published again, 
+             * so it is rather delivered twice than lost
+             */
+            return atomic_load_explicit(&self->tail, memory_order_acquire) <= i;
+        }
+    }
 
+    return false;
+}
 
-Json * xtb_client_get_symbol(XTB_Client * self, char * symbol) {
-    Json * result = xtb_client_send_get_symbol(self, symbol);
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
+static void xtb_event_ring_push(XTB_EventRing * self, const XTB_StreamEvent * event) {
+    size_t head = atomic_load_explicit(&self->head, memory_order_relaxed);
+
+    atomic_fetch_add_explicit(&self->received, 1, memory_order_relaxed);
+
+    if(head - self->tail_cache > self->mask) {
+        self->tail_cache = atomic_load_explicit(&self->tail, memory_order_acquire);
+
+        if(head - self->tail_cache > self->mask) {
+            atomic_fetch_add_explicit(&self->overflow, 1, memory_order_relaxed);
+
+            switch(self->policy) {
+                case XTB_RingPolicy_Conflate:
+                    if(xtb_event_ring_conflate(self, head, self->tail_cache, event) == true) {
+                        atomic_fetch_add_explicit(&self->conflated, 1, memory_order_relaxed);
+                        return;
+                    }
+                    /* fall through */
+                case XTB_RingPolicy_DropOldest:
+                    /*
+                     * failed exchange means that consumer released some space itself
+                     */
+                    if(atomic_compare_exchange_strong(&self->tail, &self->tail_cache, self->tail_cache + 1) == true) {
+                        atomic_fetch_add_explicit(&self->dropped, 1, memory_order_relaxed);
+                    }
+                    break;
+                case XTB_RingPolicy_Block:
+                    while(head - (self->tail_cache = atomic_load_explicit(&self->tail, memory_order_acquire)) > self->mask) {
+                        sched_yield();
+                    }
+                    break;
+            }
+        }
     }
-    
-    return extract_return_data(result);
+
+    xtb_ring_slot_write(&self->slot[head & self->mask], event);
+    atomic_store_explicit(&self->head, head + 1, memory_order_release);
 }
 
 
-static Json * xtb_client_send_get_tick_prices(
-        XTB_Client * self, size_t size, char ** symbols, int price_level, time_t timestamp) {
-    size_t pos = snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
-                    , "{\"command\": \"getTickPrices\", \"arguments\": "
-                      "{\"level\": %d, \"symbols\": ["
-                    , price_level);
+static size_t xtb_event_ring_pop(XTB_EventRing * self, XTB_StreamEvent * events, size_t size) {
+    size_t tail  = atomic_load_explicit(&self->tail, memory_order_acquire);
+    size_t head  = atomic_load_explicit(&self->head, memory_order_acquire);
+    size_t count = head - tail < size ? head - tail : size;
 
-    for(size_t i = 0; i < size; i++) {
-        pos += snprintf(self->cmd_buffer + pos, CMD_BUFFER_SIZE, i == 0 ? "\"%s\"" : ", \"%s\"", symbols[i]);
+    for(size_t i = 0; i < count; i++) {
+        xtb_ring_slot_read(&self->slot[(tail + i) & self->mask], &events[i]);
     }
 
-    snprintf(self->cmd_buffer + pos, CMD_BUFFER_SIZE, "], \"timestamp\": %ld}}", timestamp);
+    if(count == 0 || atomic_compare_exchange_strong(&self->tail, &tail, tail + count) == true) {
+        return count;
+    }
 
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
-}
+    /*
+     * producer dropped the oldest events during reading, under sustained overflow it would 
+     * do it during every batch, so the events are claimed one by one and the producer can 
+     * break only the copy of one slot
+     */
+    for(count = 0; count < size;) {
+        tail = atomic_load_explicit(&self->tail, memory_order_acquire);
 
+        if(tail == atomic_load_explicit(&self->head, memory_order_acquire)) {
+            break;
+        }
 
-Json * xtb_client_get_tick_prices(
-        XTB_Client * self, size_t size, char ** symbols, int price_level, time_t timestamp) {
-    Json * result = xtb_client_send_get_tick_prices(self, size, symbols, price_level, timestamp * 1000);
+        xtb_ring_slot_read(&self->slot[tail & self->mask], &events[count]);
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
+        if(atomic_compare_exchange_strong(&self->tail, &tail, tail + 1) == true) {
+            count++;
+        }
     }
-    
-    return extract_return_data(result);
+
+    return count;
 }
 
 
-static Json * xtb_client_send_get_news(XTB_Client * self, time_t start, time_t end) {
-    snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
-        , "{\"command\": \"getNews\", \"arguments\": {\"end\": %ld, \"start\": %ld}}"
-        , end, start);
+size_t xtb_stream_client_drain(XTB_StreamClient * self, XTB_StreamEvent * events, size_t size) {
+    return self->ring != NULL ? xtb_event_ring_pop(self->ring, events, size) : 0;
+}
+
+
+XTB_RingStats xtb_stream_client_ring_stats(XTB_StreamClient * self) {
+    if(self->ring == NULL) {
+        return (XTB_RingStats) {0};
+    }
 
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
+    return (XTB_RingStats) {
+        .received = atomic_load_explicit(&self->ring->received, memory_order_relaxed)
+        , .overflow = atomic_load_explicit(&self->ring->overflow, memory_order_relaxed)
+        , .dropped = atomic_load_explicit(&self->ring->dropped, memory_order_relaxed)
+        , .conflated = atomic_load_explicit(&self->ring->conflated, memory_order_relaxed)
+    };
 }
 
 
-Json * xtb_client_get_news(XTB_Client * self, time_t start, time_t end) {
-    Json * result = xtb_client_send_get_news(self, start, end);
+typedef enum {
+    XTB_StreamMessage_Balance
+    , XTB_StreamMessage_Candle
+    , XTB_StreamMessage_KeepAlive
+    , XTB_StreamMessage_News
+    , XTB_StreamMessage_Profit
+    , XTB_StreamMessage_TickPrices
+    , XTB_StreamMessage_Trade
+    , XTB_StreamMessage_TradeStatus
+    , XTB_StreamMessage_Unknown
+}XTB_StreamMessage;
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
+
+/*
+ * names of stream commands differ in length except candle and profit, so the 
+ * type is selected by length and first character and confirmed by one compare
+ */
+static XTB_StreamMessage xtb_stream_message_type(const char * command, size_t size) {
+    XTB_StreamMessage type;
+
+    switch(size) {
+        case 4: type = XTB_StreamMessage_News; break;
+        case 5: type = XTB_StreamMessage_Trade; break;
+        case 6: type = command[0] == 'c' ? XTB_StreamMessage_Candle : XTB_StreamMessage_Profit; break;
+        case 7: type = XTB_StreamMessage_Balance; break;
+        case 9: type = XTB_StreamMessage_KeepAlive; break;
+        case 10: type = XTB_StreamMessage_TickPrices; break;
+        case 11: type = XTB_StreamMessage_TradeStatus; break;
+        default: return XTB_StreamMessage_Unknown;
     }
-    
-    return extract_return_data(result);
+
+    static const char * const name[] = {
+        [XTB_StreamMessage_Balance] = "balance"
+        , [XTB_StreamMessage_Candle] = "candle"
+        , [XTB_StreamMessage_KeepAlive] = "keepAlive"
+        , [XTB_StreamMessage_News] = "news"
+        , [XTB_StreamMessage_Profit] = "profit"
+        , [XTB_StreamMessage_TickPrices] = "tickPrices"
+        , [XTB_StreamMessage_Trade] = "trade"
+        , [XTB_StreamMessage_TradeStatus] = "tradeStatus"
+    };
+
+    return memcmp(command, name[type], size) == 0 ? type : XTB_StreamMessage_Unknown;
 }
 
 
-Json * xtb_client_get_version(XTB_Client * self) {
-    Json * result = xtb_api_transaction(&self->api, "{\"command\": \"getVersion\"}");
+/*
+ * finds command and beginning of data object, server sends command as the first field
+ * followed by data, so usually nothing else is read, other order is handled by full scan
+ */
+static bool xtb_stream_frame_header(const char * frame, XTB_Field * command, const char ** data) {
+    XTB_Field field;
+    const char * it;
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
+    *data = NULL;
+
+    if((frame = strchr(frame, '{')) == NULL) {
+        return false;
     }
-    
-    return extract_return_data(result);
-}
 
+    if((it = xtb_scan_field(frame + 1, command)) != NULL && XTB_FIELD_IS(command, "command")) {
+        it = xtb_scan_skip(it);
+        it = xtb_scan_skip(*it == ',' ? it + 1 : it);
 
-static Json * xtb_client_send_get_trades(XTB_Client * self, bool opened_only) {
-    snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
-        , "{\"command\": \"getTrades\", \"arguments\": {\"openedOnly\": %s}}"
-        , opened_only ? "true" : "false");
+        if(strncmp(it, "\"data\"", 6) == 0) {
+            it = xtb_scan_skip(it + 6);
 
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
+            if(*it == ':' && *(it = xtb_scan_skip(it + 1)) == '{') {
+                *data = it + 1;
+            }
+
+            return true;
+        }
+    }
+
+    command->key = NULL;
+
+    for(it = frame + 1; (it = xtb_scan_field(it, &field)) != NULL;) {
+        if(XTB_FIELD_IS(&field, "command")) {
+            *command = field;
+        } else if(XTB_FIELD_IS(&field, "data") && field.value[0] == '{') {
+            *data = field.value + 1;
+        }
+    }
+
+    return command->key != NULL;
 }
 
 
-Json * xtb_client_get_trades(XTB_Client * self, bool opened_only) {
-    Json * result = xtb_client_send_get_trades(self, opened_only);
+/*
+ * the Json tree is built only if somebody listens to the message
+ */
+static void xtb_stream_client_json(XTB_StreamClient * self, StreamCallback callback, const char * frame) {
+    if(callback != NULL) {
+        Json * result = json_parse(frame);
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
+        if(result != NULL) {
+            callback(self->param, json_lookup(result, "data"));
+            json_delete(result);
+        } else {
+            __assert("stream message format error\n");
+        }
     }
-    
-    return extract_return_data(result);
 }
 
 
-static Json * xtb_client_send_get_trade_records(XTB_Client * self, size_t size, char ** orders) {
-    size_t pos = snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
-                    , "{\"command\": \"getTradeRecords\", \"arguments\": {\"orders\": [");
+/*
+ * record of stream contains frames as they were received, every frame is preceded by time of 
+ * receiving and padded to 8 bytes, so headers can be read directly from mapped file
+ */
+#define XTB_RECORD_MAGIC 0x52425458u
+#define XTB_RECORD_VERSION 1
+#define XTB_RECORD_BUFFER 65536
+
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+}XTB_RecordHeader;
 
-    for(size_t i = 0; i < size; i++) {
-        pos += snprintf(self->cmd_buffer + pos, CMD_BUFFER_SIZE, i == 0 ? "%s" : ", %s", orders[i]);
-    }
 
-    snprintf(self->cmd_buffer + pos, CMD_BUFFER_SIZE, "]}}");
+typedef struct {
+    int64_t time;
+    int64_t clock;
+    uint32_t size;
+    uint32_t reserved;
+}XTB_RecordFrame;
+
+
+struct XTB_StreamRecorder {
+    int fd;
+    uint8_t * buffer;
+    size_t size;
+    bool error;
+};
 
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
+
+static inline size_t xtb_record_padded(size_t size) {
+    return (size + 7) & ~(size_t) 7;
 }
 
 
-Json * xtb_client_get_trade_records(XTB_Client * self, size_t size, char ** orders) {
-    Json * result = xtb_client_send_get_trade_records(self, size, orders);
+XTB_StreamRecorder * xtb_stream_recorder_open(const char * path) {
+    XTB_StreamRecorder * self = calloc(1, sizeof(XTB_StreamRecorder));
+    XTB_RecordHeader header   = {.magic = XTB_RECORD_MAGIC, .version = XTB_RECORD_VERSION};
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
+    if(self == NULL || (self->buffer = malloc(XTB_RECORD_BUFFER)) == NULL) {
+        free(self);
         return NULL;
     }
-    
-    return extract_return_data(result);
+
+    if((self->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0
+            || xtb_file_write(self->fd, &header, sizeof(XTB_RecordHeader)) == false) {
+        __assert("can't open stream record\n");
+        xtb_stream_recorder_close(self);
+        return NULL;
+    }
+
+    return self;
 }
 
 
-static Json * xtb_client_send_get_trade_history(XTB_Client * self, time_t start, time_t end) {
-    snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
-        , "{\"command\": \"getTradesHistory\", \"arguments\": {\"end\": %ld, \"start\": %ld}}"
-        , end, start);
+bool xtb_stream_recorder_flush(XTB_StreamRecorder * self) {
+    if(self->size > 0 && self->error == false) {
+        self->error = xtb_file_write(self->fd, self->buffer, self->size) == false;
+    }
+
+    self->size = 0;
 
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
+    return self->error == false;
 }
 
 
-Json * xtb_client_get_trade_history(XTB_Client * self, time_t start, time_t end) {
-    Json * result = xtb_client_send_get_trade_history(self, start * 1000, end * 1000);
+void xtb_stream_recorder_write(XTB_StreamRecorder * self, const char * frame, int64_t time) {
+    size_t size            = strlen(frame) + 1;
+    size_t length          = sizeof(XTB_RecordFrame) + xtb_record_padded(size);
+    XTB_RecordFrame header = {.time = time, .clock = xtb_clock_ns(), .size = size};
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
+    if(self->size + length > XTB_RECORD_BUFFER) {
+        xtb_stream_recorder_flush(self);
     }
-    
-    return extract_return_data(result);
-}
 
+    /*
+     * frames bigger than buffer are written directly
+     */
+    if(length > XTB_RECORD_BUFFER) {
+        static const uint8_t padding[8];
+
+        self->error = self->error == true
+                        || xtb_file_write(self->fd, &header, sizeof(XTB_RecordFrame)) == false
+                        || xtb_file_write(self->fd, frame, size) == false
+                        || xtb_file_write(self->fd, padding, xtb_record_padded(size) - size) == false;
+        return;
+    }
 
-static Json * xtb_client_send_trade_transaction_status(XTB_Client * self, unsigned long order) {
-    snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
-        , "{\"command\": \"tradeTransactionStatus\", \"arguments\": {\"order\": %ld}}"
-        , order);
+    memcpy(self->buffer + self->size, &header, sizeof(XTB_RecordFrame));
+    memcpy(self->buffer + self->size + sizeof(XTB_RecordFrame), frame, size);
+    memset(self->buffer + self->size + sizeof(XTB_RecordFrame) + size, 0, xtb_record_padded(size) - size);
 
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
+    self->size += length;
 }
 
 
-Json * xtb_client_trade_transaction_status(XTB_Client * self, unsigned long order) {
-    Json * result = xtb_client_send_trade_transaction_status(self, order);
+void xtb_stream_recorder_close(XTB_StreamRecorder * self) {
+    if(self != NULL) {
+        if(self->fd >= 0) {
+            xtb_stream_recorder_flush(self);
+            close(self->fd);
+        }
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
+        free(self->buffer);
+        free(self);
     }
-    
-    return extract_return_data(result);
 }
 
 
-Json * xtb_client_get_user_data(XTB_Client * self) {
-    Json * result = xtb_api_transaction(&self->api, "{\"command\": \"getCurrentUserData\"}");
-
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
-    }
-    
-    return extract_return_data(result);
-}
+typedef void (*XTB_StreamDispatch)(XTB_StreamClient *, const char *, const char *);
 
 
-static Json * xtb_client_send_get_trading_hours(XTB_Client * self, size_t size, char ** symbols) {
-    size_t pos = snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
-                    , "{\"command\": \"getTradingHours\", \"arguments\": {\"symbols\": [");
+/*
+ * decoded event is written into ring if it is enabled, otherwise passed into typed callback
+ */
+static void xtb_stream_client_deliver(XTB_StreamClient * self, const XTB_StreamEvent * event) {
+    if(self->ring != NULL) {
+        xtb_event_ring_push(self->ring, event);
+        return;
+    }
 
-    for(size_t i = 0; i < size; i ++) {
-        pos += snprintf(self->cmd_buffer + pos, CMD_BUFFER_SIZE, i == 0 ? "\"%s\"" : ", \"%s\"", symbols[i]);
+    switch(event->type) {
+        case XTB_StreamEvent_Tick: self->handler.tick_prices(self->param, &event->tick); break;
+        case XTB_StreamEvent_Candle: self->handler.candle(self->param, &event->candle); break;
+        case XTB_StreamEvent_Balance: self->handler.balance(self->param, &event->balance); break;
+        case XTB_StreamEvent_Profit: self->handler.profit(self->param, &event->profit); break;
+        case XTB_StreamEvent_Trade: self->handler.trades(self->param, &event->trade); break;
+        case XTB_StreamEvent_TradeStatus: self->handler.trade_status(self->param, &event->trade_status); break;
     }
+}
 
-    snprintf(self->cmd_buffer + pos, CMD_BUFFER_SIZE, "]}}");
 
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
+static void xtb_stream_client_on_balance(XTB_StreamClient * self, const char * frame, const char * data) {
+    if((self->ring != NULL || self->handler.balance != NULL) && data != NULL) {
+        XTB_StreamEvent event = {.type = XTB_StreamEvent_Balance};
+        xtb_decode_balance(data, &event.balance);
+        xtb_stream_client_deliver(self, &event);
+    } else {
+        xtb_stream_client_json(self, self->callback.balance, frame);
+    }
 }
 
 
-Json * xtb_client_get_trading_hours(XTB_Client * self, size_t size, char ** symbols) {
-    Json * result = xtb_client_send_get_trading_hours(self, size, symbols);
+static void xtb_stream_client_on_candle(XTB_StreamClient * self, const char * frame, const char * data) {
+    bool typed = self->ring != NULL || self->handler.candle != NULL;
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
-    }
-    
-    return extract_return_data(result);
-}
+    if((typed == true || self->series != NULL || self->archive != NULL) && data != NULL) {
+        XTB_StreamEvent event = {.type = XTB_StreamEvent_Candle};
+        xtb_decode_candle(data, &event.candle);
 
+        if(self->archive != NULL) {
+            xtb_archive_write_candle(self->archive, &event.candle);
+        }
 
-Json * filter_market_day(Json * trading, uint8_t day) {
-    for(size_t i = 0; i < trading->array.size; i++) {
-        Json * json_day = json_lookup(trading->array.value[i], "day");
-        
-        if(json_is_type(json_day, JsonInteger) == true && (atoi(json_day->string) % 7) == day) {
-            return trading->array.value[i];
+        for(XTB_LiveSeries * series = self->series; series != NULL; series = series->next) {
+            if(series->id == event.candle.id) {
+                xtb_live_series_candle(series, self->client, &event.candle);
+            }
+        }
+
+        if(typed == true) {
+            xtb_stream_client_deliver(self, &event);
+            return;
         }
     }
 
-    return NULL;
+    xtb_stream_client_json(self, self->callback.candle, frame);
 }
 
 
-static Json * check_market_status(Json * market_day, struct tm * current_time) {
-    if(market_day != NULL) {
-        Json * json_fromT = json_lookup(market_day, "fromT");
-        Json * json_toT = json_lookup(market_day, "toT");
-
-        if(json_is_type(json_fromT, JsonInteger) == true 
-                && json_is_type(json_toT, JsonInteger) == true) {
-            long fromT = strtol(json_fromT->string, NULL, 10);
-            long toT   = strtol(json_toT->string, NULL, 10);
-            long today = (current_time->tm_hour * 3600) + (current_time->tm_min * 60) + current_time->tm_sec * 1000;
+static void xtb_stream_client_on_keep_alive(XTB_StreamClient * self, const char * frame, const char * data) {
+    (void) data;
+    xtb_stream_client_json(self, self->callback.keep_alive, frame);
+}
 
-            if(today >= fromT && today <= toT) {
-                return json_bool_new(true);
-            } else {
-                return json_bool_new(false);
-            }
-        } 
-    }
 
-    return json_bool_new(false);
+static void xtb_stream_client_on_news(XTB_StreamClient * self, const char * frame, const char * data) {
+    (void) data;
+    xtb_stream_client_json(self, self->callback.news, frame);
 }
 
 
-static Json * build_market_status(Json * market_record, struct tm * current_time) {
-    Json * trading = json_lookup(market_record, "trading");
+static void xtb_stream_client_on_profit(XTB_StreamClient * self, const char * frame, const char * data) {
+    bool typed = self->ring != NULL || self->handler.profit != NULL;
 
-    if(json_is_type(trading, JsonArray) == false) {
-        return NULL;
-    }
+    if((typed == true || self->client->positions != NULL) && data != NULL) {
+        XTB_StreamEvent event = {.type = XTB_StreamEvent_Profit};
+        xtb_decode_profit(data, &event.profit);
 
-    Json * json_symbol = json_lookup(market_record, "symbol");
+        if(self->client->positions != NULL) {
+            xtb_position_book_profit(self->client->positions, &event.profit);
+        }
 
-    if(json_is_type(json_symbol, JsonString) == false) {
-        return NULL;
+        if(typed == true) {
+            xtb_stream_client_deliver(self, &event);
+            return;
+        }
     }
 
-    Json * market_day = filter_market_day(trading, current_time->tm_wday);
-    Json * market_status = json_object_new(1);
-    json_object_set_record(market_status, 0, json_symbol->string , check_market_status(market_day, current_time));
-
-    return market_status;
+    xtb_stream_client_json(self, self->callback.profit, frame);
 }
 
 
-Json * xtb_client_check_if_market_open(XTB_Client * self, size_t size, char ** symbols) {
-    Json * result = xtb_client_get_trading_hours(self, size, symbols);
+static void xtb_stream_client_on_tick_prices(XTB_StreamClient * self, const char * frame, const char * data) {
+    bool typed = self->ring != NULL || self->handler.tick_prices != NULL;
 
-    if(json_is_type(result, JsonArray) == false) {
-        json_delete(result);
-        return NULL;
-    }
+    if((typed == true || self->client->quotes != NULL || self->bars != NULL || self->archive != NULL) 
+            && data != NULL) {
+        XTB_StreamEvent event = {.type = XTB_StreamEvent_Tick};
+        xtb_decode_tick(data, &event.tick);
 
-    time_t now = time(NULL);
-    struct tm * current_time = localtime(&now);
-    Json * trading_status = json_array_new(result->array.size);
+        if(self->archive != NULL) {
+            xtb_archive_write_tick(self->archive, &event.tick);
+        }
 
-    for(size_t i = 0; i < result->array.size; i++) {
-        Json * market_status = build_market_status(result->array.value[i], current_time);
+        if(self->client->quotes != NULL) {
+            xtb_quote_table_update(self->client->quotes, &event.tick);
+        }
 
-        if(market_status == NULL) {
-            __assert("response format error\n");
-            json_delete(market_status);
-            json_delete(result);
-            return NULL;
+        if(self->bars != NULL) {
+            xtb_bar_builder_tick(self->bars, &event.tick);
         }
 
-        trading_status->array.value[i] = market_status;
+        if(typed == true) {
+            xtb_stream_client_deliver(self, &event);
+            return;
+        }
     }
-    
-    json_delete(result);
-    return trading_status;
+
+    xtb_stream_client_json(self, self->callback.tick_prices, frame);
 }
 
 
-static Json * xtb_client_send_trade_transaction(
-        XTB_Client * self, char * symbol, XTB_TransType type, XTB_TransMode mode, float price, float volume, int offset
-        , float sl, float tp, time_t expiration, char * order, char * custom_comment) {
-    size_t pos = snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
-                    , "{\"command\": \"tradeTransaction\", \"arguments\": {\"tradeTransInfo\": {\"cmd\": %d", mode);
+static void xtb_stream_client_on_trade(XTB_StreamClient * self, const char * frame, const char * data) {
+    bool typed = self->ring != NULL || self->handler.trades != NULL;
 
-    if(custom_comment != NULL) {
-        pos += snprintf(self->cmd_buffer+pos, CMD_BUFFER_SIZE, ", \"customComment\": \"%s\"", custom_comment);
-    }
+    if((typed == true || self->client->orders != NULL || self->client->positions != NULL) && data != NULL) {
+        XTB_StreamEvent event = {.type = XTB_StreamEvent_Trade};
+        xtb_decode_trade_record(data, &event.trade);
 
-    if(expiration != 0) {
-        pos += snprintf(self->cmd_buffer+pos, CMD_BUFFER_SIZE, ", \"expiration\": %ld", expiration);
-    }
+        if(self->client->orders != NULL) {
+            xtb_order_tracker_trade(self->client->orders, &event.trade);
+        }
 
-    if(offset != 0) {
-        pos += snprintf(self->cmd_buffer+pos, CMD_BUFFER_SIZE, ", \"offset\": %d", offset);
-    }
+        if(self->client->positions != NULL) {
+            xtb_position_book_trade(self->client->positions, &event.trade);
+        }
 
-    if(order != NULL) {
-        pos += snprintf(self->cmd_buffer+pos, CMD_BUFFER_SIZE, ", \"order\": %s", order);
+        if(typed == true) {
+            xtb_stream_client_deliver(self, &event);
+            return;
+        }
     }
 
-    pos += snprintf(self->cmd_buffer+pos, CMD_BUFFER_SIZE, ", \"price\": %f", price);
-
-    snprintf(
-        self->cmd_buffer+pos
-        , CMD_BUFFER_SIZE
-        , ", \"sl\": %f, \"symbol\": \"%s\", \"tp\": %f, \"type\": %d, \"volume\": %f}}}"
-        , sl, symbol, tp, type, volume);
-
-    return xtb_api_transaction(&self->api, self->cmd_buffer);
+    xtb_stream_client_json(self, self->callback.trades, frame);
 }
 
 
-Json * xtb_client_trade_transaction(
-        XTB_Client * self, char * symbol, char * custom_comment, XTB_TransMode mode, time_t expiration, int offset
-        , char * order, float price, float tp, float sl, XTB_TransType type, float volume) {
-    Json * result = xtb_client_send_trade_transaction(
-                        self, symbol, type, mode, price, volume, offset, sl, tp, expiration, order, custom_comment);
+static void xtb_stream_client_on_trade_status(XTB_StreamClient * self, const char * frame, const char * data) {
+    bool typed = self->ring != NULL || self->handler.trade_status != NULL;
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
-    }
-    
-    return extract_return_data(result);
-}   
+    if((typed == true || self->client->orders != NULL) && data != NULL) {
+        XTB_StreamEvent event = {.type = XTB_StreamEvent_TradeStatus};
+        xtb_decode_trade_status(data, &event.trade_status);
 
+        if(self->client->orders != NULL) {
+            xtb_order_tracker_trade_status(self->client->orders, &event.trade_status);
+        }
 
-Json * xtb_client_open_trade(XTB_Client * self, char * symbol, XTB_TransMode mode, float volume, float tp, float sl) {
-    if(mode != XTB_TransMode_BUY && mode != XTB_TransMode_SELL) {
-        __assert("mode can be buy or sell\n");
-        return NULL;
+        if(typed == true) {
+            xtb_stream_client_deliver(self, &event);
+            return;
+        }
     }
 
-    Json * candle = xtb_client_get_symbol(self, symbol);
+    xtb_stream_client_json(self, self->callback.trade_status, frame);
+}
 
-    if(candle == NULL 
-            || (mode == XTB_TransMode_BUY && json_is_type(json_lookup(candle, "ask"), JsonFrac) == false)
-            || (mode == XTB_TransMode_SELL && json_is_type(json_lookup(candle, "bid"), JsonFrac) == false)) {
-        __assert("response format error\n");
-        json_delete(candle);
-        return NULL;
-    }
 
-    float price = atof((mode == XTB_TransMode_BUY) ? 
-                        json_lookup(candle, "ask")->string : 
-                        json_lookup(candle, "bid")->string);
+static const XTB_StreamDispatch xtb_stream_dispatch_table[] = {
+    [XTB_StreamMessage_Balance] = xtb_stream_client_on_balance
+    , [XTB_StreamMessage_Candle] = xtb_stream_client_on_candle
+    , [XTB_StreamMessage_KeepAlive] = xtb_stream_client_on_keep_alive
+    , [XTB_StreamMessage_News] = xtb_stream_client_on_news
+    , [XTB_StreamMessage_Profit] = xtb_stream_client_on_profit
+    , [XTB_StreamMessage_TickPrices] = xtb_stream_client_on_tick_prices
+    , [XTB_StreamMessage_Trade] = xtb_stream_client_on_trade
+    , [XTB_StreamMessage_TradeStatus] = xtb_stream_client_on_trade_status
+};
 
-    json_delete(candle);
 
-    Json * result = 
-        xtb_client_trade_transaction(
-                self, symbol, NULL, mode, 0, 0, NULL, price, tp, sl, XTB_TransType_OPEN, volume);
+static void xtb_stream_client_handle(XTB_StreamClient * self, char * frame) {
+    XTB_Field command;
+    const char * data;
 
-    return result;
-}
+    if(xtb_stream_frame_header(frame, &command, &data) == false) {
+        __assert("stream message format error\n");
+        return;
+    }
 
+    XTB_StreamMessage type = xtb_stream_message_type(command.value, command.value_size);
 
-Json * xtb_client_close_trade(
-        XTB_Client * self, char * symbol, char * order, XTB_TransMode mode, float price, float volume) {
-    return xtb_client_trade_transaction(self, symbol, NULL, mode, 0, 0, order, price, 0, 0, XTB_TransType_CLOSE, volume);
+    if(type != XTB_StreamMessage_Unknown) {
+        xtb_stream_dispatch_table[type](self, frame, data);
+    }
 }
 
 
-Json * xtb_client_get_step_rules(XTB_Client * self) {
-    Json * result = xtb_api_transaction(&self->api, "{\"command\": \"getStepRules\"}");
+static void xtb_stream_client_dispatch(XTB_StreamClient * self, char * frame) {
+    self->last_receive  = xtb_time_ms();
+    self->last_activity = xtb_clock_ms();
 
-    if(read_status(result) == false) {
-        __assert("command failed\n");
-        json_delete(result);
-        return NULL;
+    if(self->recorder != NULL) {
+        xtb_stream_recorder_write(self->recorder, frame, self->last_receive);
     }
-    
-    return extract_return_data(result);
+
+    xtb_stream_client_handle(self, frame);
 }
 
 
-void xtb_client_delete(XTB_Client * self) {
-    if(self != NULL) {
-        if(self->stream_session_id != NULL)
-            xtb_client_logout(self);
+struct XTB_StreamReplayer {
+    uint8_t * map;
+    size_t length;
+};
 
-        free(self->stream_session_id);
 
-        if(self->id != NULL)
-            free(self->id);
+XTB_StreamReplayer * xtb_stream_replayer_open(const char * path) {
+    XTB_StreamReplayer * self = calloc(1, sizeof(XTB_StreamReplayer));
+    int fd                    = open(path, O_RDONLY);
+    struct stat st;
 
-        if(self->password != NULL)
-            free(self->password);
+    if(self == NULL || fd < 0 || fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(XTB_RecordHeader)) {
+        __assert("can't open stream record\n");
+        free(self);
 
-        /*
-         * close and release stream clients
-         */
-        while(self->stream_client != NULL) {
-            XTB_StreamClient * next = self->stream_client->next;
+        if(fd >= 0) {
+            close(fd);
+        }
+
+        return NULL;
+    }
 
-            xtb_api_close(&self->stream_client->api);
+    /*
+     * private writable mapping lets frames be passed into dispatch without copying
+     */
+    self->length = st.st_size;
+    self->map    = mmap(NULL, self->length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
 
-            free(self->stream_client);
-            self->stream_client = next;
-        }
+    XTB_RecordHeader header;
 
-        xtb_api_close(&self->api);
+    if(self->map != MAP_FAILED) {
+        memcpy(&header, self->map, sizeof(XTB_RecordHeader));
+    }
+
+    if(self->map == MAP_FAILED || header.magic != XTB_RECORD_MAGIC || header.version != XTB_RECORD_VERSION) {
+        __assert("stream record format error\n");
+
+        if(self->map != MAP_FAILED) {
+            munmap(self->map, self->length);
+        }
 
         free(self);
+        return NULL;
     }
+
+    return self;
 }
 
 
-static XTB_StreamClient * xtb_stream_client_last(XTB_StreamClient * self) {
-    if(self != NULL) {
-        while(self->next != NULL) {
-            self = self->next;
+/*
+ * frames are paced by monotonic time of receiving divided by speed, the last frame cut by 
+ * crash of recorder is ignored
+ */
+int64_t xtb_stream_replayer_run(XTB_StreamReplayer * self, XTB_StreamClient * stream, double speed) {
+    size_t offset = sizeof(XTB_RecordHeader);
+    int64_t size  = 0;
+    int64_t first = 0;
+    int64_t begin = xtb_clock_ns();
+
+    while(offset + sizeof(XTB_RecordFrame) <= self->length) {
+        const XTB_RecordFrame * header = (const XTB_RecordFrame *) (self->map + offset);
+        char * frame                   = (char *) (self->map + offset + sizeof(XTB_RecordFrame));
+
+        if(header->size == 0 
+                || offset + sizeof(XTB_RecordFrame) + xtb_record_padded(header->size) > self->length
+                || frame[header->size - 1] != '\0') {
+            break;
         }
-    }
 
-    return self;  
-}
+        if(speed > 0) {
+            if(size == 0) {
+                first = header->clock;
+            }
 
+            int64_t due = begin + (int64_t) ((header->clock - first) / speed);
 
-XTB_StreamClient * xtb_stream_client_new(XTB_Client * self, StreamClientCallback *callback, void * param) {
-    XTB_Api api = {0};
+            if(due > xtb_clock_ns()) {
+                struct timespec ts = {.tv_sec = due / 1000000000, .tv_nsec = due % 1000000000};
+                while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+            }
+        }
+
+        stream->last_receive  = header->time;
+        stream->last_activity = xtb_clock_ms();
+
+        xtb_stream_client_handle(stream, frame);
+
+        offset += sizeof(XTB_RecordFrame) + xtb_record_padded(header->size);
+        size++;
+    }
+
+    return size;
+}
 
-    const char * url = XTB_API_STREAM_URL(self->mode);
 
-    if(xtb_api_connect(&api, url) == true) {
-        XTB_StreamClient * stream_client = malloc(sizeof(XTB_StreamClient));
+void xtb_stream_replayer_close(XTB_StreamReplayer * self) {
+    if(self != NULL) {
+        munmap(self->map, self->length);
+        free(self);
+    }
+}
 
-        /*
-         * get last stream client from linked list
-         */
-        XTB_StreamClient * last = xtb_stream_client_last(self->stream_client);
-        
-        *stream_client = (XTB_StreamClient) {
-            .api = api
-            , .stream_session_id = self->stream_session_id
-            , .callback = *callback
-            , .param = param
-            , .prev = last
-            , .next = NULL
-        };
 
-        if(last != NULL) {
-            last->next = stream_client;
-        }
+/*
+ * history loaded asynchronously is merged and bars of quiet symbols are closed also when 
+ * nothing is received
+ */
+static void xtb_stream_client_idle(XTB_StreamClient * self) {
+    for(XTB_LiveSeries * series = self->series; series != NULL; series = series->next) {
+        xtb_live_series_poll(series, self->client);
+    }
 
-        return stream_client;
-    } else {
-        return NULL;
+    if(self->bars != NULL) {
+        xtb_bar_builder_flush(self->bars, xtb_time_ms());
     }
 }
 
@@ -1114,58 +9045,45 @@ XTB_StreamClient * xtb_stream_client_new(XTB_Client * self, StreamClientCallback
 void xtb_stream_client_process(XTB_StreamClient * self) {
     char * rcv = NULL;
 
-    if((rcv = xtb_api_receive(&self->api)) != NULL) {
-        Json * result = json_parse(rcv);
-
-        if(result != NULL) {
-            Json * command = json_lookup(result, "command");
-
-            if(json_is_type(command, JsonString) == true) {
-                if(strcmp(command->string, "balance") == 0 && self->callback.balance != NULL) {
-                    self->callback.balance(self->param, json_lookup(result, "data"));
-                } else if(strcmp(command->string, "candle") == 0 && self->callback.candle != NULL) {
-                    self->callback.candle(self->param, json_lookup(result, "data"));
-                } else if(strcmp(command->string, "keepAlive") == 0 && self->callback.keep_alive != NULL) {
-                    self->callback.keep_alive(self->param, json_lookup(result, "data"));
-                } else if(strcmp(command->string, "news") == 0 && self->callback.news != NULL) {
-                    self->callback.news(self->param, json_lookup(result, "data"));
-                } else if(strcmp(command->string, "profit") == 0 && self->callback.profit != NULL) {
-                    self->callback.profit(self->param, json_lookup(result, "data"));
-                } else if(strcmp(command->string, "tickPrices") == 0 && self->callback.tick_prices != NULL) {
-                    self->callback.tick_prices(self->param, json_lookup(result, "data"));
-                } else if(strcmp(command->string, "trade") == 0 && self->callback.trades != NULL) {
-                    self->callback.trades(self->param, json_lookup(result, "data"));
-                } else if(strcmp(command->string, "tradeStatus") == 0 && self->callback.trade_status != NULL) {
-                    self->callback.trade_status(self->param, json_lookup(result, "data"));
-                } else {
-                    // TODO: treat unknown response error
-                }
-            }
+    if(self->api.bio != NULL && (rcv = xtb_api_receive(&self->api, self->stale_timeout)) != NULL) {
+        /*
+         * one read can contain more messages, all of them are dispatched
+         * before the next read
+         */
+        do {
+            xtb_stream_client_dispatch(self, rcv);
+        } while((rcv = xtb_buffer_next_frame(&self->api.rcv)) != NULL);
+    } else if(self->api.bio != NULL) {
+        /*
+         * connection failed or nothing was received, not even keep alive
+         */
+        xtb_stream_client_disconnect(self);
+        xtb_stream_client_connect(self);
+    } else if(self->offline == false) {
+        /*
+         * blocking processing waits for the planned attempt, so the caller doesn't spin
+         */
+        int64_t wait = self->next_attempt - xtb_clock_ms();
 
-            json_delete(result);
-        } else {
-            // TODO: treat json format error
+        if(wait > 0) {
+            poll(NULL, 0, wait);
         }
-    } else {
-        // TODO: treat empty response error
-    }
-}
 
+        xtb_stream_client_connect(self);
+    }
 
-static bool xtb_stream_client_subscribe_command(XTB_StreamClient * self, char * command) {
-    snprintf(self->cmd_buffer, CMD_BUFFER_SIZE, "{\"command\": \"%s\", \"streamSessionId\": \"%s\"}", command, self->stream_session_id);
-    return xtb_api_send(&self->api, self->cmd_buffer);
+    xtb_stream_client_idle(self);
 }
 
 
 static inline bool xtb_stream_client_unsubscribe_command(XTB_StreamClient * self, char * msg) {
-    return xtb_api_send(&self->api, msg);
+    return self->api.bio != NULL && xtb_api_send(&self->api, msg);
 }
 
 
 bool xtb_stream_client_subscribe_news(XTB_StreamClient * self) {
     if(self->callback.news != NULL) {
-        return xtb_stream_client_subscribe_command(self, "getNews");
+        return xtb_stream_client_subscribe(self, "getNews", NULL, 0, -1);
     } else {
         return false;
     }
@@ -1173,13 +9091,14 @@ bool xtb_stream_client_subscribe_news(XTB_StreamClient * self) {
 
 
 bool xtb_stream_client_unsubscribe_news(XTB_StreamClient * self) {
+    xtb_stream_client_forget(self, "getNews", NULL);
     return xtb_stream_client_unsubscribe_command(self, "{\"command\": \"stopNews\"}");
 }
 
 
 bool xtb_stream_client_subscribe_balance(XTB_StreamClient * self) {
-    if(self->callback.balance != NULL) {
-        return xtb_stream_client_subscribe_command(self, "getBalance");
+    if(self->callback.balance != NULL || self->handler.balance != NULL || self->ring != NULL) {
+        return xtb_stream_client_subscribe(self, "getBalance", NULL, 0, -1);
     } else {
         return false;
     }
@@ -1187,32 +9106,37 @@ bool xtb_stream_client_subscribe_balance(XTB_StreamClient * self) {
 
 
 bool xtb_stream_client_unsubscribe_balance(XTB_StreamClient * self) {
+    xtb_stream_client_forget(self, "getBalance", NULL);
     return xtb_stream_client_unsubscribe_command(self, "{\"command\": \"stopBalance\"}");
 }
 
 
 bool xtb_stream_client_subscribe_candles(XTB_StreamClient * self, char * symbol) {
-    if(self->callback.candle != NULL) {
-        snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
-                , "{\"command\": \"getCandles\", \"streamSessionId\": \"%s\", \"symbol\": \"%s\"}"
-                , self->stream_session_id, symbol);
-
-        return xtb_api_send(&self->api, self->cmd_buffer);
+    if(self->callback.candle != NULL || self->handler.candle != NULL || self->ring != NULL 
+            || self->series != NULL || self->archive != NULL) {
+        return xtb_stream_client_subscribe(self, "getCandles", symbol, 0, -1);
     } else {
         return false;
     }
 }
 
 
+bool xtb_stream_client_subscribe_candles_by_id(XTB_StreamClient * self, XTB_SymbolId id) {
+    const char * symbol = xtb_symbol_name(id);
+    return symbol != NULL && xtb_stream_client_subscribe_candles(self, (char *) symbol);
+}
+
+
 bool xtb_stream_client_unsubscribe_candles(XTB_StreamClient * self, char * symbol) {
+    xtb_stream_client_forget(self, "getCandles", symbol);
     snprintf(self->cmd_buffer, CMD_BUFFER_SIZE, "{\"command\": \"stopCandles\", \"symbol\": \"%s\"}", symbol);
-    return xtb_api_send(&self->api, self->cmd_buffer);
+    return xtb_stream_client_unsubscribe_command(self, self->cmd_buffer);
 }
 
 
 bool xtb_stream_client_subscribe_keep_alive(XTB_StreamClient * self) {
     if(self->callback.keep_alive != NULL) {
-        return xtb_stream_client_subscribe_command(self, "getKeepAlive");
+        return xtb_stream_client_subscribe(self, "getKeepAlive", NULL, 0, -1);
     } else {
         return false;
     }
@@ -1220,13 +9144,15 @@ bool xtb_stream_client_subscribe_keep_alive(XTB_StreamClient * self) {
 
 
 bool xtb_stream_client_unsubscribe_keep_alive(XTB_StreamClient * self) {
+    xtb_stream_client_forget(self, "getKeepAlive", NULL);
     return xtb_stream_client_unsubscribe_command(self, "{\"command\": \"stopKeepAlive\"}");
 }
 
 
 bool xtb_stream_client_subscribe_profits(XTB_StreamClient * self) {
-    if(self->callback.profit != NULL) {
-        return xtb_stream_client_subscribe_command(self, "getProfits");
+    if(self->callback.profit != NULL || self->handler.profit != NULL || self->ring != NULL
+            || self->client->positions != NULL) {
+        return xtb_stream_client_subscribe(self, "getProfits", NULL, 0, -1);
     } else {
         return false;
     }
@@ -1234,32 +9160,39 @@ bool xtb_stream_client_subscribe_profits(XTB_StreamClient * self) {
 
 
 bool xtb_stream_client_unsubscribe_profits(XTB_StreamClient * self) {
+    xtb_stream_client_forget(self, "getProfits", NULL);
     return xtb_stream_client_unsubscribe_command(self, "{\"command\": \"stopProfits\"}");
 }
 
 
 bool xtb_stream_client_subscribe_tick_prices(XTB_StreamClient * self, char * symbol, time_t min_arrive_time, int max_level) {
-    if(self->callback.tick_prices != NULL) {
-        snprintf(self->cmd_buffer, CMD_BUFFER_SIZE
-                , "{\"command\": \"getTickPrices\", \"streamSessionId\": \"%s\", \"symbol\": \"%s\", \"minArrivalTime\": %ld, \"maxLevel\": %d}"
-                , self->stream_session_id, symbol, min_arrive_time, max_level);
-
-        return xtb_api_send(&self->api, self->cmd_buffer);
+    if(self->callback.tick_prices != NULL || self->handler.tick_prices != NULL || self->ring != NULL 
+            || self->client->quotes != NULL || self->bars != NULL || self->archive != NULL) {
+        return xtb_stream_client_subscribe(self, "getTickPrices", symbol, min_arrive_time, max_level);
     } else {
         return false;
     }
 }
 
 
+bool xtb_stream_client_subscribe_tick_prices_by_id(
+        XTB_StreamClient * self, XTB_SymbolId id, time_t min_arrive_time, int max_level) {
+    const char * symbol = xtb_symbol_name(id);
+    return symbol != NULL && xtb_stream_client_subscribe_tick_prices(self, (char *) symbol, min_arrive_time, max_level);
+}
+
+
 bool xtb_stream_client_unsubscribe_tick_price(XTB_StreamClient * self, char * symbol) {
+    xtb_stream_client_forget(self, "getTickPrices", symbol);
     snprintf(self->cmd_buffer, CMD_BUFFER_SIZE, "{\"command\": \"stopTickPrices\", \"symbol\": \"%s\"}", symbol);
-    return xtb_api_send(&self->api, self->cmd_buffer);
+    return xtb_stream_client_unsubscribe_command(self, self->cmd_buffer);
 }
 
 
 bool xtb_stream_client_subscribe_trades(XTB_StreamClient * self) {
-    if(self->callback.trades != NULL) {
-        return xtb_stream_client_subscribe_command(self, "getTrades");
+    if(self->callback.trades != NULL || self->handler.trades != NULL || self->ring != NULL
+            || self->client->orders != NULL || self->client->positions != NULL) {
+        return xtb_stream_client_subscribe(self, "getTrades", NULL, 0, -1);
     } else {
         return false;
     }
@@ -1267,13 +9200,15 @@ bool xtb_stream_client_subscribe_trades(XTB_StreamClient * self) {
 
 
 bool xtb_stream_client_unsubscribe_trades(XTB_StreamClient * self) {
+    xtb_stream_client_forget(self, "getTrades", NULL);
     return xtb_stream_client_unsubscribe_command(self, "{\"command\": \"stopTrades\"}");
 }
 
 
 bool xtb_stream_client_subscribe_trade_status(XTB_StreamClient * self) {
-    if(self->callback.trade_status != NULL) {   
-        return xtb_stream_client_subscribe_command(self, "getTradeStatus");
+    if(self->callback.trade_status != NULL || self->handler.trade_status != NULL || self->ring != NULL
+            || self->client->orders != NULL) {
+        return xtb_stream_client_subscribe(self, "getTradeStatus", NULL, 0, -1);
     } else {
         return false;
     }
@@ -1281,12 +9216,13 @@ bool xtb_stream_client_subscribe_trade_status(XTB_StreamClient * self) {
 
 
 bool xtb_stream_client_unsubscribe_trade_status(XTB_StreamClient * self) {
+    xtb_stream_client_forget(self, "getTradeStatus", NULL);
     return xtb_stream_client_unsubscribe_command(self, "{\"command\": \"stopTradeStatus\"}");
 }
 
 
 bool xtb_stream_client_ping(XTB_StreamClient * self) {
-    return xtb_stream_client_subscribe_command(self, "ping");
+    return self->api.bio != NULL && xtb_stream_client_subscribe_command(self, "ping");
 }
 
 
@@ -1297,16 +9233,416 @@ void xtb_stream_client_delete(XTB_StreamClient * self) {
          */
         if(self->prev != NULL) {
             self->prev->next = self->next;
+        } else if(self->offline == false) {
+            self->client->stream_client = self->next;
+        }
+
+        if(self->next != NULL) {
+            self->next->prev = self->prev;
+        }
+
+        while(self->subscription != NULL) {
+            xtb_stream_client_forget(self, self->subscription->command, self->subscription->symbol);
+        }
+
+        while(self->series != NULL) {
+            XTB_LiveSeries * next = self->series->next;
+
+            xtb_live_series_delete(self->series);
+            self->series = next;
         }
 
         xtb_api_close(&self->api);
+        xtb_session_check_release(self->session);
+        xtb_connect_release(self->connect);
+        xtb_event_ring_delete(self->ring);
         free(self);
     }
 }
 
 
+static void xtb_stream_client_dispatch_frame(void * self, char * frame) {
+    xtb_stream_client_dispatch(self, frame);
+}
+
+
+static bool xtb_stream_client_poll(void * self) {
+    if(xtb_api_drain(&((XTB_StreamClient *) self)->api, xtb_stream_client_dispatch_frame, self) == false) {
+        xtb_stream_client_disconnect(self);
+    }
+
+    return true;
+}
+
+
+/*
+ * disconnected client tries one attempt whenever the planned time passes, so other
+ * connections of the loop aren't blocked by waiting between attempts
+ */
+static bool xtb_stream_client_check(void * param) {
+    XTB_StreamClient * self = param;
+
+    xtb_stream_client_idle(self);
+
+    if(self->api.bio == NULL) {
+        xtb_stream_client_connect(self);
+    } else if(self->stale_timeout >= 0 && xtb_clock_ms() - self->last_activity >= self->stale_timeout) {
+        __assert("stream connection is silent\n");
+        xtb_stream_client_disconnect(self);
+    }
+
+    return true;
+}
+
+
+/*
+ * disconnected client wakes up the loop when the next step of connecting is planned
+ */
+static int xtb_stream_client_timer(void * param) {
+    XTB_StreamClient * self = param;
+
+    if(self->api.bio != NULL || self->offline == true) {
+        return -1;
+    }
+
+    int64_t wait = self->next_attempt - xtb_clock_ms();
+
+    return wait > 0 ? (int) wait : 0;
+}
+
+
+#define XTB_EVENT_LOOP_MAX_EVENTS 64
+
+
+/*
+ * check is called in every iteration of loop, stream clients use it for recognizing
+ * of silent connection
+ */
+#define XTB_EVENT_LOOP_CHECK_INTERVAL 1000
+
+
+typedef struct XTB_EventSource {
+    XTB_Api * api;
+    bool (*process)(void *);
+    bool (*check)(void *);
+    void * object;
+
+    /*
+     * milliseconds until the source needs its check, -1 if it has no timer
+     */
+    int (*timeout)(void *);
+
+    /*
+     * disconnected stream client stays in the loop without socket, so its check 
+     * can connect again
+     */
+    bool attached;
+
+    struct XTB_EventSource * next;
+}XTB_EventSource;
+
+
+struct XTB_EventLoop {
+    int epoll_fd;
+    bool running;
+
+    XTB_EventSource * source;
+
+    struct epoll_event events[XTB_EVENT_LOOP_MAX_EVENTS];
+    int size;
+};
+
+
+XTB_EventLoop * xtb_event_loop_new(void) {
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+    if(epoll_fd < 0) {
+        __assert("epoll create error\n");
+        return NULL;
+    }
+
+    XTB_EventLoop * self = malloc(sizeof(XTB_EventLoop));
+
+    *self = (XTB_EventLoop) {
+        .epoll_fd = epoll_fd
+    };
+
+    return self;
+}
+
+
+static bool xtb_event_loop_register(
+        XTB_EventLoop * self, XTB_Api * api, bool (*process)(void *), bool (*check)(void *)
+        , int (*timeout)(void *), void * object) {
+    if(api->loop != NULL) {
+        __assert("connection is already registered in event loop\n");
+        return false;
+    }
+
+    XTB_EventSource * source = malloc(sizeof(XTB_EventSource));
+
+    *source = (XTB_EventSource) {
+        .api = api
+        , .process = process
+        , .check = check
+        , .object = object
+        , .timeout = timeout
+        , .attached = api->bio != NULL
+        , .next = self->source
+    };
+
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = source};
+
+    if(source->attached == true && epoll_ctl(self->epoll_fd, EPOLL_CTL_ADD, api->fd, &event) != 0) {
+        __assert("epoll register error\n");
+        free(source);
+        return false;
+    }
+
+    self->source = source;
+    api->loop    = self;
+
+    return true;
+}
+
+
+static XTB_EventSource * xtb_event_loop_find(XTB_EventLoop * self, XTB_Api * api) {
+    XTB_EventSource * source = self->source;
+
+    while(source != NULL && source->api != api) {
+        source = source->next;
+    }
+
+    return source;
+}
+
+
+/*
+ * socket of the source is removed from epoll before it is closed, events already waiting 
+ * for processing in current iteration have to forget the source
+ */
+static void xtb_event_loop_forget(XTB_EventLoop * self, XTB_EventSource * source) {
+    for(int i = 0; i < self->size; i++) {
+        if(self->events[i].data.ptr == source) {
+            self->events[i].data.ptr = NULL;
+        }
+    }
+
+    if(source->attached == true) {
+        epoll_ctl(self->epoll_fd, EPOLL_CTL_DEL, source->api->fd, NULL);
+        source->attached = false;
+    }
+}
+
+
+static void xtb_event_loop_detach(XTB_EventLoop * self, XTB_Api * api) {
+    XTB_EventSource * source = xtb_event_loop_find(self, api);
+
+    if(source != NULL) {
+        xtb_event_loop_forget(self, source);
+    }
+}
+
+
+static bool xtb_event_loop_attach(XTB_EventLoop * self, XTB_Api * api) {
+    XTB_EventSource * source = xtb_event_loop_find(self, api);
+
+    if(source == NULL) {
+        return false;
+    }
+
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = source};
+
+    if(source->attached == false && epoll_ctl(self->epoll_fd, EPOLL_CTL_ADD, api->fd, &event) != 0) {
+        __assert("epoll register error\n");
+        return false;
+    }
+
+    source->attached = true;
+    api->loop        = self;
+
+    return true;
+}
+
+
+/*
+ * connections can be closed and opened again by reconnect while the loop iterates 
+ * over sources, so released sources are only marked and freed at the end of iteration
+ */
+static void xtb_event_loop_unregister(XTB_EventLoop * self, XTB_Api * api) {
+    XTB_EventSource * source = xtb_event_loop_find(self, api);
+
+    if(source != NULL) {
+        xtb_event_loop_forget(self, source);
+
+        source->api = NULL;
+        api->loop   = NULL;
+    }
+}
+
+
+static void xtb_event_loop_collect(XTB_EventLoop * self) {
+    XTB_EventSource ** it = &self->source;
+
+    while(*it != NULL) {
+        if((*it)->api == NULL) {
+            XTB_EventSource * source = *it;
+
+            *it = source->next;
+            free(source);
+        } else {
+            it = &(*it)->next;
+        }
+    }
+}
+
+
+static void xtb_event_loop_process(XTB_EventLoop * self, XTB_EventSource * source, bool (*process)(void *)) {
+    XTB_Api * api = source->api;
+
+    if(process(source->object) == false) {
+        __assert("connection failed\n");
+        xtb_event_loop_unregister(self, api);
+    }
+}
+
+
+bool xtb_event_loop_add_client(XTB_EventLoop * self, XTB_Client * client) {
+    if(atomic_load(&client->io_running) == true) {
+        __assert("client is processed by I/O thread\n");
+        return false;
+    }
+
+    return xtb_event_loop_register(
+                self, &client->api, xtb_client_poll, xtb_client_check, xtb_client_timer, client);
+}
+
+
+void xtb_event_loop_remove_client(XTB_EventLoop * self, XTB_Client * client) {
+    if(client->api.loop == self) {
+        xtb_event_loop_unregister(self, &client->api);
+    }
+}
+
+
+bool xtb_event_loop_add_stream_client(XTB_EventLoop * self, XTB_StreamClient * stream_client) {
+    return xtb_event_loop_register(
+                self, &stream_client->api, xtb_stream_client_poll, xtb_stream_client_check, xtb_stream_client_timer, stream_client);
+}
+
+
+void xtb_event_loop_remove_stream_client(XTB_EventLoop * self, XTB_StreamClient * stream_client) {
+    if(stream_client->api.loop == self) {
+        xtb_event_loop_unregister(self, &stream_client->api);
+    }
+}
+
+
+int xtb_event_loop_run_once(XTB_EventLoop * self, int timeout) {
+    int processed = 0;
+
+    /*
+     * messages can be already waiting in receive buffer of the connection after the
+     * last blocking command, they are dispatched without waiting on socket
+     */
+    for(XTB_EventSource * it = self->source; it != NULL; it = it->next) {
+        if(it->api != NULL && xtb_buffer_has_frame(&it->api->rcv) == true) {
+            xtb_event_loop_process(self, it, it->process);
+            processed++;
+        }
+
+        if(it->check != NULL && (timeout < 0 || timeout > XTB_EVENT_LOOP_CHECK_INTERVAL)) {
+            timeout = XTB_EVENT_LOOP_CHECK_INTERVAL;
+        }
+
+        int timer = it->api != NULL && it->timeout != NULL ? it->timeout(it->object) : -1;
+
+        if(timer >= 0 && (timeout < 0 || timer < timeout)) {
+            timeout = timer;
+        }
+    }
+
+    int size = epoll_wait(self->epoll_fd, self->events, XTB_EVENT_LOOP_MAX_EVENTS, processed > 0 ? 0 : timeout);
+
+    if(size < 0) {
+        if(errno == EINTR) {
+            xtb_event_loop_collect(self);
+            return processed;
+        }
+
+        __assert("epoll wait error\n");
+        return -1;
+    }
+
+    self->size = size;
+
+    for(int i = 0; i < size; i++) {
+        XTB_EventSource * source = self->events[i].data.ptr;
+
+        if(source != NULL) {
+            xtb_event_loop_process(self, source, source->process);
+        }
+    }
+
+    self->size = 0;
+
+    for(XTB_EventSource * it = self->source; it != NULL; it = it->next) {
+        if(it->api != NULL && it->check != NULL) {
+            xtb_event_loop_process(self, it, it->check);
+        }
+    }
+
+    xtb_event_loop_collect(self);
+
+    return processed + size;
+}
+
+
+bool xtb_event_loop_run(XTB_EventLoop * self, int duration) {
+    int64_t end = xtb_clock_ms() + duration;
+    int timeout = duration;
+
+    self->running = true;
+
+    while(self->running == true && self->source != NULL) {
+        if(xtb_event_loop_run_once(self, timeout) < 0) {
+            self->running = false;
+            return false;
+        }
+
+        if(duration >= 0) {
+            int64_t now = xtb_clock_ms();
+
+            if(now >= end) {
+                break;
+            }
+
+            timeout = end - now;
+        }
+    }
+
+    self->running = false;
+
+    return true;
+}
 
 
+void xtb_event_loop_stop(XTB_EventLoop * self) {
+    self->running = false;
+}
+
 
+void xtb_event_loop_delete(XTB_EventLoop * self) {
+    if(self != NULL) {
+        for(XTB_EventSource * it = self->source; it != NULL; it = it->next) {
+            if(it->api != NULL) {
+                xtb_event_loop_unregister(self, it->api);
+            }
+        }
 
+        xtb_event_loop_collect(self);
 
+        close(self->epoll_fd);
+        free(self);
+    }
+}
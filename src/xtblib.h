@@ -27,6 +27,47 @@
 #define XTB_LIB_VERSION 1.2.0
 
 
+#define XTB_SYMBOL_SIZE 32
+#define XTB_COMMENT_SIZE 128
+#define XTB_CURRENCY_SIZE 8
+
+
+/**
+ * @brief Dense integer id of interned symbol, ids are shared by all clients of the process and
+ * are lower than XTB_SYMBOL_ID_CAPACITY, so per symbol state can be kept in flat arrays.
+ */
+typedef uint32_t XTB_SymbolId;
+
+
+#define XTB_SYMBOL_ID_CAPACITY 16384
+#define XTB_SYMBOL_NONE UINT32_MAX
+
+
+/**
+ * @brief Returns id of symbol, new id is assigned on the first call. Returns XTB_SYMBOL_NONE
+ * if the symbol is too long or the table is full. It can be called from any thread.
+ */
+XTB_SymbolId xtb_symbol_intern(const char * symbol);
+
+
+/**
+ * @brief Returns id of already interned symbol or XTB_SYMBOL_NONE.
+ */
+XTB_SymbolId xtb_symbol_find(const char * symbol);
+
+
+/**
+ * @brief Returns name of interned symbol or NULL, the name is valid until end of the process.
+ */
+const char * xtb_symbol_name(XTB_SymbolId id);
+
+
+/**
+ * @brief Number of interned symbols.
+ */
+size_t xtb_symbol_count(void);
+
+
 /**
  * @brief
  */
@@ -79,6 +120,25 @@ typedef enum {
 }XTB_Period;
 
 
+/**
+ * @brief Result code of asynchronous command
+ */
+typedef enum {
+    XTB_Error_None
+    , XTB_Error_Connection
+    , XTB_Error_Format
+    , XTB_Error_Command
+}XTB_Error;
+
+
+/**
+ * @brief Completion callback of asynchronous command. Ownership of result is passed to the callback.
+ * The result is returnData of the response, for XTB_Error_Command it is the whole response with
+ * errorCode and errorDescr and for other errors it is NULL.
+ */
+typedef void (*XTB_Callback)(void *, XTB_Error, Json *);
+
+
 /**
  * @brief
  */
@@ -128,6 +188,13 @@ Json * xtb_client_get_chart_last_request(
     XTB_Client * self, char * symbol, XTB_Period period, time_t start);
 
 
+/**
+ * @brief
+ */
+Json * xtb_client_get_chart_last_request_by_id(
+    XTB_Client * self, XTB_SymbolId id, XTB_Period period, time_t start);
+
+
 /**
  * @brief
  */
@@ -138,10 +205,63 @@ Json * xtb_client_get_chart_range_request(
 /**
  * @brief
  */
+Json * xtb_client_get_chart_range_request_by_id(
+    XTB_Client * self, XTB_SymbolId id, XTB_Period period, time_t start, time_t end, int32_t tick);
+
+
+/**
+ * @brief returns the newest number of candles in chronological order, history is downloaded 
+ * by range requests covering trading hours of symbol
+ */
 Json * xtb_client_get_lastn_candle_history(
     XTB_Client * self, char * symbol, XTB_Period period, size_t number);
 
 
+/**
+ * @brief Candles in columns, prices are already scaled by digits of symbol. Columns are
+ * allocated together with the series and are released by xtb_candle_series_delete.
+ */
+typedef struct {
+    char symbol[XTB_SYMBOL_SIZE];
+    XTB_Period period;
+    size_t size;
+
+    int64_t * timestamp;
+    double * open;
+    double * high;
+    double * low;
+    double * close;
+    double * vol;
+}XTB_CandleSeries;
+
+
+/**
+ * @brief Same as xtb_client_get_chart_last_request, bars are returned as columns.
+ */
+XTB_CandleSeries * xtb_client_get_chart_last_series(
+    XTB_Client * self, char * symbol, XTB_Period period, time_t start);
+
+
+/**
+ * @brief Same as xtb_client_get_chart_range_request, bars are returned as columns.
+ */
+XTB_CandleSeries * xtb_client_get_chart_range_series(
+    XTB_Client * self, char * symbol, XTB_Period period, time_t start, time_t end, int32_t tick);
+
+
+/**
+ * @brief Same as xtb_client_get_lastn_candle_history, bars are returned as columns.
+ */
+XTB_CandleSeries * xtb_client_get_lastn_candle_series(
+    XTB_Client * self, char * symbol, XTB_Period period, size_t number);
+
+
+/**
+ * @brief
+ */
+void xtb_candle_series_delete(XTB_CandleSeries * self);
+
+
 /*
  * @brief
  */
@@ -277,6 +397,13 @@ Json * xtb_client_open_trade(
         XTB_Client * self, char * symbol, XTB_TransMode mode, float volume, float tp, float sl);
 
 
+/*
+ * @brief
+ */
+Json * xtb_client_open_trade_by_id(
+        XTB_Client * self, XTB_SymbolId id, XTB_TransMode mode, float volume, float tp, float sl);
+
+
 /*
  * @brief
  */
@@ -290,167 +417,1516 @@ Json * xtb_client_close_trade(
 void xtb_client_delete(XTB_Client * self);
 
 
-/*
- * @brief Streaming client is connection into XTB server for automatic reading of reacent data
- * This is the fastest way for getting the newst data.
- *
- * Every StreamClient command takes as argument streaming_session_id received from loggin to main port. 
- *
- * <a href="http://developers.xstore.pro/documentation/#available-streaming-commands">Available streaming commands</a> 
- *
- * Main problem of subscribing and unsubcribing of streaming commands is that, there is not 
- * confimed and only thing that confirm subcription is receiving of given streaming data, but
- * if the command is wrong, it is hard to detect
+/**
+ * @brief Socket of main connection for the external poll loop
  */
-typedef struct XTB_StreamClient XTB_StreamClient;
+int xtb_client_fd(XTB_Client * self);
 
 
-/*
+/**
+ * @brief Milliseconds until commands held back by the request spacing required by server can be 
+ * sent by xtb_client_process, -1 if no command is held back. External poll loop should use it as
+ * timeout of waiting on xtb_client_fd.
+ */
+int xtb_client_timeout(XTB_Client * self);
+
+
+/**
+ * @brief Sends commands held back by the request spacing, reads all responses available on main 
+ * connection without blocking and calls completion callbacks of asynchronous commands. Returns 
+ * false if the connection failed.
+ */
+bool xtb_client_process(XTB_Client * self);
+
+
+/**
+ * @brief The newest quote of symbol on given level of market depth, times are in unix time of ms.
+ */
+typedef struct {
+    char symbol[XTB_SYMBOL_SIZE];
+    double bid;
+    double ask;
+    double spread;
+    int64_t bid_volume;
+    int64_t ask_volume;
+    int64_t timestamp;
+    int level;
+    XTB_SymbolId id;
+}XTB_Quote;
+
+
+/**
+ * @brief Creates table of quotes fed by tick prices of all stream clients of this client. It has 
+ * to be called before stream clients start to receive data. Capacity is the maximal number of 
+ * symbol and level pairs. Streamed quotes not older than one minute are used for pricing of 
+ * orders opened by xtb_client_open_trade instead of requesting the symbol from server.
+ */
+bool xtb_client_enable_quotes(XTB_Client * self, size_t capacity);
+
+
+/**
+ * @brief Copies the newest quote without locking, it can be called from any thread. Returns false
+ * if no quote of the symbol was received yet.
+ */
+bool xtb_client_get_quote(XTB_Client * self, const char * symbol, int level, XTB_Quote * quote);
+
+
+/**
+ * @brief Copies the newest quote of the top level by index of symbol id.
+ */
+bool xtb_client_get_quote_by_id(XTB_Client * self, XTB_SymbolId id, XTB_Quote * quote);
+
+
+/**
+ * @brief Life cycle of tracked order, the state moves only forward.
+ */
+typedef enum {
+    XTB_OrderState_Pending
+    , XTB_OrderState_Accepted
+    , XTB_OrderState_Rejected
+    , XTB_OrderState_Opened
+    , XTB_OrderState_Closed
+}XTB_OrderState;
+
+
+/**
+ * @brief Values of request_status in XTB_TradeStatus.
+ */
+typedef enum {
+    XTB_RequestStatus_ERROR = 0
+    , XTB_RequestStatus_PENDING = 1
+    , XTB_RequestStatus_ACCEPTED = 3
+    , XTB_RequestStatus_REJECTED = 4
+}XTB_RequestStatus;
+
+
+/**
+ * @brief Change of tracked order state, times are monotonic ns (see xtb_monotonic_ns), price is 
+ * the price of status, open price of position or close price of position.
+ */
+typedef struct {
+    uint64_t order;
+    uint64_t position;
+    XTB_OrderState state;
+    XTB_OrderState previous;
+    int64_t submitted;
+    int64_t timestamp;
+    double price;
+}XTB_OrderEvent;
+
+
+typedef void (*XTB_OrderCallback)(void *, const XTB_OrderEvent *);
+
+
+/**
+ * @brief Creates order tracker of the client fed by tradeStatus and trade messages of its stream
+ * clients, both have to be subscribed. It has to be called before stream clients start to 
+ * receive data. Orders sent by tradeTransaction functions and order templates are tracked 
+ * automatically with the default callback.
+ */
+bool xtb_client_enable_order_tracking(XTB_Client * self);
+
+
+/**
+ * @brief Sets callback of automatically tracked orders.
+ */
+void xtb_client_set_order_callback(XTB_Client * self, XTB_OrderCallback callback, void * param);
+
+
+/**
+ * @brief Registers order number returned by tradeTransaction, callback is called from the thread
+ * processing the stream on every change of order state. Messages of the order received before 
+ * it was registered are applied immediately, order already tracked automatically gets the given
+ * callback. The order is matched also by its position number once opened, rejected and closed 
+ * orders are released. Submitted is monotonic time of sending of the order, 0 means now.
+ */
+bool xtb_client_track_order(
+        XTB_Client * self, uint64_t order, int64_t submitted, XTB_OrderCallback callback, void * param);
+
+
+/**
+ * @brief Monotonic clock in ns used for timestamps of order events.
+ */
+int64_t xtb_monotonic_ns(void);
+
+
+/**
+ * @brief Starts thread which becomes single owner of the client connection. Afterwards the client
+ * can be used from any number of threads, commands are passed to the I/O thread through lock-free
+ * queue and blocking commands wait for their own response only. Callbacks of asynchronous commands
+ * are called from the I/O thread. The client can't be added into event loop in this mode.
+ */
+bool xtb_client_start_io_thread(XTB_Client * self);
+
+
+/**
+ * @brief Stops the I/O thread, commands which weren't sent yet are completed with
+ * XTB_Error_Connection. Called also from xtb_client_delete.
+ */
+void xtb_client_stop_io_thread(XTB_Client * self);
+
+
+/**
+ * @brief Asynchronous variants of commands send the command and return immediately, the result is
+ * passed into callback from xtb_client_process or from any blocking command of the same client.
+ * Returns false if the command can't be sent.
+ */
+bool xtb_client_async_ping(XTB_Client * self, XTB_Callback callback, void * param);
+
+
+/**
  * @brief
  */
-typedef void (*StreamCallback)(void *, Json *);
+bool xtb_client_async_get_all_symbols(XTB_Client * self, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-typedef struct {
-    StreamCallback balance;
-    StreamCallback news;
-    StreamCallback candle;
-    StreamCallback keep_alive;
-    StreamCallback profit;
-    StreamCallback tick_prices;
-    StreamCallback trades;
-    StreamCallback trade_status;
-} StreamClientCallback;
+bool xtb_client_async_get_calendar(XTB_Client * self, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-XTB_StreamClient * xtb_stream_client_new(
-        XTB_Client * self, StreamClientCallback * callback, void * param);
+bool xtb_client_async_get_chart_last_request(
+    XTB_Client * self, char * symbol, XTB_Period period, time_t start, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-void xtb_stream_client_process(XTB_StreamClient * self);
+bool xtb_client_async_get_chart_range_request(
+    XTB_Client * self, char * symbol, XTB_Period period, time_t start, time_t end, int32_t tick
+    , XTB_Callback callback, void * param);
+
+
+/**
+ * @brief Asynchronous version of xtb_client_get_lastn_candle_history, the newest number of candles 
+ * is downloaded by the same chunks covering trading hours of symbol and passed to callback in
+ * chronological order.
+ */
+bool xtb_client_async_get_lastn_candle_history(
+    XTB_Client * self, char * symbol, XTB_Period period, size_t number, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_subscribe_news(XTB_StreamClient * self);
+bool xtb_client_async_get_commision(
+    XTB_Client * self, char * symbol, float volume, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_unsubscribe_news(XTB_StreamClient * self);
+bool xtb_client_async_get_commision_def(
+    XTB_Client * self, char * symbol, float volume, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_subscribe_balance(XTB_StreamClient * self);
+bool xtb_client_async_get_margin_level(XTB_Client * self, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_unsubscribe_balance(XTB_StreamClient * self);
+bool xtb_client_async_get_margin_trade(
+    XTB_Client * self, char * symbol, float volume, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_subscribe_candles(XTB_StreamClient * self, char * symbol);
+bool xtb_client_async_get_profit_calculation(
+    XTB_Client * self, float close_price, XTB_TransMode mode, float open_price, char * symbol, float volume
+    , XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_unsubscribe_candles(XTB_StreamClient * self, char * symbol);
+bool xtb_client_async_get_server_time(XTB_Client * self, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_subscribe_keep_alive(XTB_StreamClient * self);
+bool xtb_client_async_get_symbol(XTB_Client * self, char * symbol, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_unsubscribe_keep_alive(XTB_StreamClient * self);
+bool xtb_client_async_get_tick_prices(
+    XTB_Client * self, size_t size, char ** symbols, int price_level, time_t timestamp
+    , XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_subscribe_profits(XTB_StreamClient * self);
+bool xtb_client_async_get_news(XTB_Client * self, time_t start, time_t end, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_unsubscribe_profits(XTB_StreamClient * self);
+bool xtb_client_async_get_version(XTB_Client * self, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_subscribe_tick_prices(
-        XTB_StreamClient * self, char * symbol, time_t min_arrive_time, int max_level);
+bool xtb_client_async_get_trades(XTB_Client * self, bool opened_only, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_unsubscribe_tick_price(XTB_StreamClient * self, char * symbol);
+bool xtb_client_async_get_trade_records(
+    XTB_Client * self, size_t size, char ** orders, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_subscribe_trades(XTB_StreamClient * self);
+bool xtb_client_async_get_trade_history(
+    XTB_Client * self, time_t start, time_t end, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_unsubscribe_trades(XTB_StreamClient * self);
+bool xtb_client_async_trade_transaction_status(
+    XTB_Client * self, unsigned long order, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_subscribe_trade_status(XTB_StreamClient * self);
+bool xtb_client_async_get_user_data(XTB_Client * self, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_unsubscribe_trade_status(XTB_StreamClient * self);
+bool xtb_client_async_get_trading_hours(
+    XTB_Client * self, size_t size, char ** symbols, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-bool xtb_stream_client_ping(XTB_StreamClient * self);
+bool xtb_client_async_check_if_market_open(
+    XTB_Client * self, size_t size, char ** symbols, XTB_Callback callback, void * param);
 
 
 /**
  * @brief
  */
-void xtb_stream_client_delete(XTB_StreamClient * self);
+bool xtb_client_async_get_step_rules(XTB_Client * self, XTB_Callback callback, void * param);
 
 
-#endif
+/**
+ * @brief
+ */
+bool xtb_client_async_trade_transaction(
+    XTB_Client * self
+    , char * symbol
+    , char * custom_comment
+    , XTB_TransMode mode
+    , time_t expriration
+    , int offset
+    , char * order
+    , float price
+    , float tp
+    , float sl
+    , XTB_TransType type
+    , float volume
+    , XTB_Callback callback
+    , void * param);
+
+
+/**
+ * @brief
+ */
+bool xtb_client_async_open_trade(
+        XTB_Client * self, char * symbol, XTB_TransMode mode, float volume, float tp, float sl
+        , XTB_Callback callback, void * param);
+
+
+/**
+ * @brief
+ */
+bool xtb_client_async_close_trade(
+        XTB_Client * self, char * symbol, char * order, XTB_TransMode mode, float price, float volume
+        , XTB_Callback callback, void * param);
+
+
+/**
+ * @brief Order template keeps tradeTransaction message for opening of position in given symbol and 
+ * mode serialized in advance. Sending of order only writes price, volume, sl and tp into the message
+ * and sends it in one write. Price precision is loaded by getSymbol when the template is created.
+ * The template can be used only by one thread at a time.
+ */
+typedef struct XTB_OrderTemplate XTB_OrderTemplate;
 
 
+/**
+ * @brief
+ */
+XTB_OrderTemplate * xtb_order_template_new(XTB_Client * client, const char * symbol, XTB_TransMode mode);
+
+
+/**
+ * @brief
+ */
+XTB_OrderTemplate * xtb_order_template_new_by_id(XTB_Client * client, XTB_SymbolId id, XTB_TransMode mode);
+
+
+/**
+ * @brief Sends the order with given price and waits for the response, order number is written into
+ * order. Returns false if the order wasn't accepted for processing.
+ */
+bool xtb_order_template_send(
+        XTB_OrderTemplate * self, float price, float volume, float sl, float tp, uint64_t * order);
+
+
+/**
+ * @brief Sends the order priced by the newest streamed quote (see xtb_client_enable_quotes), 
+ * fails without sending if the quote of symbol isn't available.
+ */
+bool xtb_order_template_open(XTB_OrderTemplate * self, float volume, float sl, float tp, uint64_t * order);
 
 
+/**
+ * @brief
+ */
+bool xtb_order_template_send_async(
+        XTB_OrderTemplate * self, float price, float volume, float sl, float tp, XTB_Callback callback, void * param);
+
+
+/**
+ * @brief
+ */
+bool xtb_order_template_open_async(
+        XTB_OrderTemplate * self, float volume, float sl, float tp, XTB_Callback callback, void * param);
 
+
+/**
+ * @brief
+ */
+void xtb_order_template_delete(XTB_OrderTemplate * self);
+
+
+/**
+ * @brief Pool of independently logged connections to the same account. Every connection can be 
+ * acquired by one thread at a time and used with any xtb_client_* command, so commands of more 
+ * threads run in parallel instead of waiting for each other. Idle connections are handed out in 
+ * order of release. Every client keeps the request spacing required by server on its own.
+ */
+typedef struct XTB_ClientPool XTB_ClientPool;
+
+
+/**
+ * @brief Opens and logs in size connections, returns NULL if any of them fails.
+ */
+XTB_ClientPool * xtb_client_pool_new(XTB_AccountMode mode, char * id, char * password, size_t size);
+
+
+/**
+ * @brief
+ */
+size_t xtb_client_pool_size(XTB_ClientPool * self);
+
+
+/**
+ * @brief Returns idle connection, blocks until some connection is released if all are in use.
+ */
+XTB_Client * xtb_client_pool_acquire(XTB_ClientPool * self);
+
+
+/**
+ * @brief Returns idle connection or NULL if all are in use.
+ */
+XTB_Client * xtb_client_pool_try_acquire(XTB_ClientPool * self);
+
+
+/**
+ * @brief Returns the connection back to pool, the client must not be used by the caller afterwards.
+ */
+void xtb_client_pool_release(XTB_ClientPool * self, XTB_Client * client);
+
+
+/**
+ * @brief Logs out and closes all connections, none of them may be acquired at this point.
+ */
+void xtb_client_pool_delete(XTB_ClientPool * self);
+
+
+/**
+ * @brief Pipeline sends all its commands at once on the main connection of the client and matches 
+ * responses to the commands by customTag, so the whole batch costs approximately one round trip. 
+ * Batches longer than 5 commands are slowed down to the request spacing required by server.
+ * Every xtb_pipeline_* command returns index of its result, or SIZE_MAX if the command can't be 
+ * stored into the pipeline.
+ */
+typedef struct XTB_Pipeline XTB_Pipeline;
+
+
+/**
+ * @brief
+ */
+XTB_Pipeline * xtb_pipeline_new(XTB_Client * client);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_size(XTB_Pipeline * self);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_all_symbols(XTB_Pipeline * self);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_calendar(XTB_Pipeline * self);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_chart_last_request(XTB_Pipeline * self, char * symbol, XTB_Period period, time_t start);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_chart_range_request(
+    XTB_Pipeline * self, char * symbol, XTB_Period period, time_t start, time_t end, int32_t tick);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_commision(XTB_Pipeline * self, char * symbol, float volume);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_commision_def(XTB_Pipeline * self, char * symbol, float volume);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_margin_level(XTB_Pipeline * self);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_margin_trade(XTB_Pipeline * self, char * symbol, float volume);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_profit_calculation(
+    XTB_Pipeline * self, float close_price, XTB_TransMode mode, float open_price, char * symbol, float volume);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_server_time(XTB_Pipeline * self);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_symbol(XTB_Pipeline * self, char * symbol);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_tick_prices(
+    XTB_Pipeline * self, size_t size, char ** symbols, int price_level, time_t timestamp);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_news(XTB_Pipeline * self, time_t start, time_t end);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_version(XTB_Pipeline * self);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_trades(XTB_Pipeline * self, bool opened_only);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_trade_records(XTB_Pipeline * self, size_t size, char ** orders);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_trade_history(XTB_Pipeline * self, time_t start, time_t end);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_trade_transaction_status(XTB_Pipeline * self, unsigned long order);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_user_data(XTB_Pipeline * self);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_trading_hours(XTB_Pipeline * self, size_t size, char ** symbols);
+
+
+/**
+ * @brief
+ */
+size_t xtb_pipeline_get_step_rules(XTB_Pipeline * self);
+
+
+/**
+ * @brief Sends all commands of pipeline and waits for all responses. Returns false if any of the
+ * commands failed. Pipeline can be executed repeatedly, results of previous execution are released.
+ */
+bool xtb_pipeline_execute(XTB_Pipeline * self);
+
+
+/**
+ * @brief Returns result of the command with given index, ownership of result is passed to caller,
+ * NULL is returned for failed command
+ */
+Json * xtb_pipeline_result(XTB_Pipeline * self, size_t index);
+
+
+/**
+ * @brief Removes all commands and results from pipeline
+ */
+void xtb_pipeline_clear(XTB_Pipeline * self);
+
+
+/**
+ * @brief
+ */
+void xtb_pipeline_delete(XTB_Pipeline * self);
+
+
+/*
+ * @brief Streaming client is connection into XTB server for automatic reading of reacent data
+ * This is the fastest way for getting the newst data.
+ *
+ * Every StreamClient command takes as argument streaming_session_id received from loggin to main port. 
+ *
+ * <a href="http://developers.xstore.pro/documentation/#available-streaming-commands">Available streaming commands</a> 
+ *
+ * Main problem of subscribing and unsubcribing of streaming commands is that, there is not 
+ * confimed and only thing that confirm subcription is receiving of given streaming data, but
+ * if the command is wrong, it is hard to detect
+ */
+typedef struct XTB_StreamClient XTB_StreamClient;
+
+
+/*
+ * @brief
+ */
+typedef void (*StreamCallback)(void *, Json *);
+
+
+/*
+ * @brief Called after reconnect of stream client with time of the last message received before
+ * the connection failed and time when the subscriptions were restored, both in unix time of ms.
+ * Data of this interval are missing and have to be loaded by main client if needed.
+ */
+typedef void (*StreamGapCallback)(void *, int64_t, int64_t);
+
+
+/**
+ * @brief
+ */
+typedef struct {
+    StreamCallback balance;
+    StreamCallback news;
+    StreamCallback candle;
+    StreamCallback keep_alive;
+    StreamCallback profit;
+    StreamCallback tick_prices;
+    StreamCallback trades;
+    StreamCallback trade_status;
+    StreamGapCallback gap;
+} StreamClientCallback;
+
+
+/**
+ * @brief Stream messages decoded directly from received data without building of Json tree.
+ * Prices are in quote currency, times in unix time of ms. Strings are copied without unescaping
+ * and truncated to the size of their buffer. Symbols are interned, id is the symbol id.
+ */
+typedef struct {
+    char symbol[XTB_SYMBOL_SIZE];
+    double ask;
+    double bid;
+    double high;
+    double low;
+    double spread_raw;
+    double spread_table;
+    int64_t ask_volume;
+    int64_t bid_volume;
+    int64_t timestamp;
+    int level;
+    int quote_id;
+    XTB_SymbolId id;
+}XTB_Tick;
+
+
+typedef struct {
+    char symbol[XTB_SYMBOL_SIZE];
+    int64_t ctm;
+    double open;
+    double close;
+    double high;
+    double low;
+    double vol;
+    int quote_id;
+    XTB_SymbolId id;
+}XTB_Candle;
+
+
+typedef struct {
+    double balance;
+    double credit;
+    double equity;
+    double margin;
+    double margin_free;
+    double margin_level;
+}XTB_Balance;
+
+
+typedef struct {
+    int64_t order;
+    int64_t order2;
+    int64_t position;
+    double profit;
+}XTB_Profit;
+
+
+typedef struct {
+    char symbol[XTB_SYMBOL_SIZE];
+    char comment[XTB_COMMENT_SIZE];
+    char custom_comment[XTB_COMMENT_SIZE];
+    char state[XTB_SYMBOL_SIZE];
+    int64_t order;
+    int64_t order2;
+    int64_t position;
+    int64_t open_time;
+    int64_t close_time;
+    int64_t expiration;
+    double open_price;
+    double close_price;
+    double sl;
+    double tp;
+    double volume;
+    double profit;
+    double commission;
+    double storage;
+    double margin_rate;
+    XTB_TransMode cmd;
+    int type;
+    int digits;
+    int offset;
+    XTB_SymbolId id;
+    bool closed;
+}XTB_TradeRecord;
+
+
+typedef struct {
+    char custom_comment[XTB_COMMENT_SIZE];
+    char message[XTB_COMMENT_SIZE];
+    int64_t order;
+    double price;
+    int request_status;
+}XTB_TradeStatus;
+
+
+/**
+ * @brief Typed alternative of StreamClientCallback, the decoded message is valid only during
+ * the call. If both typed and Json callbacks are set for the same message, only the typed one 
+ * is called.
+ */
+typedef struct {
+    void (*tick_prices)(void *, const XTB_Tick *);
+    void (*candle)(void *, const XTB_Candle *);
+    void (*balance)(void *, const XTB_Balance *);
+    void (*profit)(void *, const XTB_Profit *);
+    void (*trades)(void *, const XTB_TradeRecord *);
+    void (*trade_status)(void *, const XTB_TradeStatus *);
+}XTB_StreamHandler;
+
+
+typedef enum {
+    XTB_StreamEvent_Tick
+    , XTB_StreamEvent_Candle
+    , XTB_StreamEvent_Balance
+    , XTB_StreamEvent_Profit
+    , XTB_StreamEvent_Trade
+    , XTB_StreamEvent_TradeStatus
+}XTB_StreamEventType;
+
+
+/**
+ * @brief Decoded stream message delivered through ring of stream client.
+ */
+typedef struct {
+    XTB_StreamEventType type;
+
+    union {
+        XTB_Tick tick;
+        XTB_Candle candle;
+        XTB_Balance balance;
+        XTB_Profit profit;
+        XTB_TradeRecord trade;
+        XTB_TradeStatus trade_status;
+    };
+}XTB_StreamEvent;
+
+
+/**
+ * @brief Behaviour of full ring. Block waits until consumer releases space, DropOldest overwrites 
+ * the oldest event and Conflate replaces the pending event of the same symbol (tick level, candle, 
+ * balance or position profit) and drops the oldest event if there is none. Conflated event read
+ * by consumer exactly at the moment of replacement is delivered twice.
+ */
+typedef enum {
+    XTB_RingPolicy_Block
+    , XTB_RingPolicy_DropOldest
+    , XTB_RingPolicy_Conflate
+}XTB_RingPolicy;
+
+
+/**
+ * @brief Counters of ring, overflow is number of events which found the ring full.
+ */
+typedef struct {
+    uint64_t received;
+    uint64_t overflow;
+    uint64_t dropped;
+    uint64_t conflated;
+}XTB_RingStats;
+
+
+/**
+ * @brief Bar of period milliseconds long starting at start in unix time of ms, prices are bid 
+ * prices, ticks is the number of ticks in the bar.
+ */
+typedef struct {
+    const char * symbol;
+    XTB_SymbolId id;
+    int64_t period;
+    int64_t start;
+    double open;
+    double high;
+    double low;
+    double close;
+    int64_t ticks;
+}XTB_Bar;
+
+
+typedef void (*XTB_BarCallback)(void *, const XTB_Bar *);
+
+
+/**
+ * @brief Builds bars of any periods, including periods shorter than minute, from tick prices. 
+ * Bars are aligned to multiples of period since the epoch and the callback is called when the 
+ * bar is closed by tick of the same symbol after the end of its period, or by flush for quiet 
+ * symbols. Periods without ticks produce no bar. The builder can be used only by one thread 
+ * at a time.
+ */
+typedef struct XTB_BarBuilder XTB_BarBuilder;
+
+
+/**
+ * @brief
+ */
+XTB_BarBuilder * xtb_bar_builder_new(XTB_BarCallback callback, void * param);
+
+
+/**
+ * @brief Adds series of bars of symbol with period in milliseconds.
+ */
+bool xtb_bar_builder_add(XTB_BarBuilder * self, const char * symbol, int64_t period);
+
+
+/**
+ * @brief Adds tick into bars of its symbol, ticks of other symbols and levels are ignored.
+ */
+void xtb_bar_builder_tick(XTB_BarBuilder * self, const XTB_Tick * tick);
+
+
+/**
+ * @brief Closes bars which ended more than lateness before now in unix time of ms, it can be 
+ * called by timer when no ticks arrive, stream clients call it whenever they are processed. 
+ * Ticks of closed bars received later are ignored.
+ */
+void xtb_bar_builder_flush(XTB_BarBuilder * self, int64_t now);
+
+
+/**
+ * @brief Sets how long after the end of period flush waits for late ticks, 2000 ms by default.
+ */
+void xtb_bar_builder_set_lateness(XTB_BarBuilder * self, int64_t lateness);
+
+
+/**
+ * @brief
+ */
+void xtb_bar_builder_delete(XTB_BarBuilder * self);
+
+
+/**
+ * @brief Series of bars of one symbol and period joining history with live candles of stream.
+ */
+typedef struct XTB_LiveSeries XTB_LiveSeries;
+
+
+/**
+ * @brief The last size bars of series in columns, the oldest bar is at index 0. Forming is true
+ * if the newest bar isn't closed yet. Arrays are valid until the next update of series.
+ */
+typedef struct {
+    const char * symbol;
+    XTB_Period period;
+    size_t size;
+    const int64_t * time;
+    const double * open;
+    const double * high;
+    const double * low;
+    const double * close;
+    const double * vol;
+    bool forming;
+}XTB_SeriesView;
+
+
+typedef void (*XTB_SeriesCallback)(void *, const XTB_LiveSeries *);
+
+
+/**
+ * @brief
+ */
+XTB_SeriesView xtb_live_series_view(const XTB_LiveSeries * self);
+
+
+/**
+ * @brief Local history of one symbol and period kept in memory mapped file, bars are only
+ * appended, so restart needs just to download bars newer than the stored ones.
+ */
+typedef struct XTB_HistoryStore XTB_HistoryStore;
+
+
+/**
+ * @brief Opens or creates file SYMBOL_MINUTES.xtbh in directory.
+ */
+XTB_HistoryStore * xtb_history_store_open(const char * directory, const char * symbol, XTB_Period period);
+
+
+/**
+ * @brief Downloads bars since the last stored bar, empty store is filled with the last depth bars.
+ */
+bool xtb_history_store_sync(XTB_HistoryStore * self, XTB_Client * client, size_t depth);
+
+
+/**
+ * @brief Appends bars newer than the last stored bar, the last stored bar is updated.
+ */
+bool xtb_history_store_append(XTB_HistoryStore * self, const XTB_CandleSeries * series);
+
+
+/**
+ * @brief
+ */
+size_t xtb_history_store_size(const XTB_HistoryStore * self);
+
+
+/**
+ * @brief Bars with time from from to to in unix ms pointing directly into the mapped file. 
+ * Arrays are valid until the next append or sync.
+ */
+XTB_SeriesView xtb_history_store_range(const XTB_HistoryStore * self, int64_t from, int64_t to);
+
+
+/**
+ * @brief
+ */
+void xtb_history_store_close(XTB_HistoryStore * self);
+
+
+/**
+ * @brief Compressed archive of tick prices and candles. Events are buffered into blocks of
+ * 64 KiB which are written when full, by xtb_archive_writer_flush or on close.
+ */
+typedef struct XTB_ArchiveWriter XTB_ArchiveWriter;
+
+
+typedef struct XTB_ArchiveReader XTB_ArchiveReader;
+
+
+/**
+ * @brief Block of archive, first and last are the oldest and the newest time of its events.
+ */
+typedef struct {
+    int64_t offset;
+    int64_t first;
+    int64_t last;
+    uint32_t count;
+}XTB_ArchiveIndex;
+
+
+/**
+ * @brief Opens archive for appending, it is created if it doesn't exist.
+ */
+XTB_ArchiveWriter * xtb_archive_writer_open(const char * path);
+
+
+/**
+ * @brief Time of tick is the timestamp, time of candle is ctm.
+ */
+bool xtb_archive_write_tick(XTB_ArchiveWriter * self, const XTB_Tick * tick);
+
+
+/**
+ * @brief
+ */
+bool xtb_archive_write_candle(XTB_ArchiveWriter * self, const XTB_Candle * candle);
+
+
+/**
+ * @brief
+ */
+bool xtb_archive_writer_flush(XTB_ArchiveWriter * self);
+
+
+/**
+ * @brief
+ */
+void xtb_archive_writer_close(XTB_ArchiveWriter * self);
+
+
+/**
+ * @brief
+ */
+XTB_ArchiveReader * xtb_archive_reader_open(const char * path);
+
+
+/**
+ * @brief
+ */
+const XTB_ArchiveIndex * xtb_archive_reader_index(const XTB_ArchiveReader * self, size_t * size);
+
+
+/**
+ * @brief Decodes events with time from from to to in unix ms and passes them into tick_prices 
+ * and candle callbacks of handler in order of writing. Returns number of delivered events or 
+ * -1 if the archive is broken.
+ */
+int64_t xtb_archive_reader_replay(
+    XTB_ArchiveReader * self, int64_t from, int64_t to, const XTB_StreamHandler * handler, void * param);
+
+
+/**
+ * @brief
+ */
+void xtb_archive_reader_close(XTB_ArchiveReader * self);
+
+
+/**
+ * @brief Record of raw stream frames with time of receiving.
+ */
+typedef struct XTB_StreamRecorder XTB_StreamRecorder;
+
+
+typedef struct XTB_StreamReplayer XTB_StreamReplayer;
+
+
+/**
+ * @brief Creates new record, existing file is overwritten.
+ */
+XTB_StreamRecorder * xtb_stream_recorder_open(const char * path);
+
+
+/**
+ * @brief Appends frame received at time in unix ms, stream clients with recorder call it for 
+ * every received frame. Records can be built also from other sources, for example as fixtures.
+ */
+void xtb_stream_recorder_write(XTB_StreamRecorder * self, const char * frame, int64_t time);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_recorder_flush(XTB_StreamRecorder * self);
+
+
+/**
+ * @brief
+ */
+void xtb_stream_recorder_close(XTB_StreamRecorder * self);
+
+
+/**
+ * @brief
+ */
+XTB_StreamReplayer * xtb_stream_replayer_open(const char * path);
+
+
+/**
+ * @brief Passes all recorded frames into stream client in the same way as received frames, 
+ * so the same callbacks, handler and ring are used. Speed 1 keeps the original pace, 2 is twice 
+ * faster and 0 replays as fast as possible. Returns number of replayed frames.
+ */
+int64_t xtb_stream_replayer_run(XTB_StreamReplayer * self, XTB_StreamClient * stream, double speed);
+
+
+/**
+ * @brief
+ */
+void xtb_stream_replayer_close(XTB_StreamReplayer * self);
+
+
+/**
+ * @brief
+ */
+XTB_StreamClient * xtb_stream_client_new(
+        XTB_Client * self, StreamClientCallback * callback, void * param);
+
+
+/**
+ * @brief Stream client without connection fed by xtb_stream_replayer_run. Quotes, orders and 
+ * positions of client are updated by replayed messages, client can be NULL.
+ */
+XTB_StreamClient * xtb_stream_client_new_offline(
+        XTB_Client * self, StreamClientCallback * callback, void * param);
+
+
+/**
+ * @brief Sets typed callbacks, they get the same param as callbacks passed into xtb_stream_client_new.
+ */
+void xtb_stream_client_set_handler(XTB_StreamClient * self, const XTB_StreamHandler * handler);
+
+
+/**
+ * @brief Switches delivery of ticks, candles, balance, profits, trades and trade statuses from
+ * callbacks into bounded single-producer/single-consumer ring. Thread calling 
+ * xtb_stream_client_process (or event loop) is the producer and one other thread reads events
+ * in batches by xtb_stream_client_drain. Capacity is rounded up to power of two. Keep alive and 
+ * news are still passed into callbacks.
+ */
+bool xtb_stream_client_enable_ring(XTB_StreamClient * self, size_t capacity, XTB_RingPolicy policy);
+
+
+/**
+ * @brief Moves up to size events from ring into events without blocking, returns number of events.
+ */
+size_t xtb_stream_client_drain(XTB_StreamClient * self, XTB_StreamEvent * events, size_t size);
+
+
+/**
+ * @brief
+ */
+XTB_RingStats xtb_stream_client_ring_stats(XTB_StreamClient * self);
+
+
+/**
+ * @brief Stream client keeps its active subscriptions. When the connection fails or nothing is 
+ * received for stale timeout (15 s by default, keep alive messages are requested for this purpose),
+ * the client is disconnected and tries to connect again with growing randomized delay (up to 30 s)
+ * until it succeeds, then it subscribes everything again and reports the gap by callback. 
+ * Connections are opened and logged in by worker thread and taken over by the stream client when 
+ * finished, so an unreachable server doesn't block other connections of the event loop. Session 
+ * of main client is verified by asynchronous ping, main client which isn't processed by I/O thread 
+ * or event loop is processed by the stream client meanwhile, so the stream has to be processed by 
+ * the thread owning the main client. Lost session is logged in again only by the owner thread 
+ * (same event loop or no I/O thread), with I/O thread the application has to log in again itself. 
+ * Negative timeout disables the check of silent connection.
+ */
+void xtb_stream_client_set_stale_timeout(XTB_StreamClient * self, int timeout);
+
+
+/**
+ * @brief Feeds received tick prices into bar builder, the bar callbacks are called from the 
+ * thread processing the stream client. NULL stops feeding.
+ */
+void xtb_stream_client_set_bar_builder(XTB_StreamClient * self, XTB_BarBuilder * bars);
+
+
+/**
+ * @brief Writes received tick prices and candles into archive. NULL stops writing.
+ */
+void xtb_stream_client_set_archive(XTB_StreamClient * self, XTB_ArchiveWriter * archive);
+
+
+/**
+ * @brief Writes every received frame into record. Stream clients sharing one recorder have to
+ * be processed by the same thread. NULL stops recording.
+ */
+void xtb_stream_client_set_recorder(XTB_StreamClient * self, XTB_StreamRecorder * recorder);
+
+
+/**
+ * @brief Creates series of the last capacity bars of symbol owned by the stream client. History 
+ * is loaded by getChartRangeRequest, closed minute candles of stream are merged into the bars 
+ * afterwards without gaps or duplicates, minutes missed during reconnect are loaded again. 
+ * When the main client is processed by I/O thread or event loop, the history is loaded 
+ * asynchronously, the series is empty until it is merged and candles received meanwhile are
+ * merged after it. Callback is called from the thread processing the stream after every update. Periods up to 
+ * XTB_PERIOD_W1 are supported.
+ */
+XTB_LiveSeries * xtb_stream_client_add_series(
+        XTB_StreamClient * self, const char * symbol, XTB_Period period, size_t capacity
+        , XTB_SeriesCallback callback, void * param);
+
+
+/**
+ * @brief
+ */
+void xtb_stream_client_process(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_subscribe_news(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_unsubscribe_news(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_subscribe_balance(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_unsubscribe_balance(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_subscribe_candles(XTB_StreamClient * self, char * symbol);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_subscribe_candles_by_id(XTB_StreamClient * self, XTB_SymbolId id);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_unsubscribe_candles(XTB_StreamClient * self, char * symbol);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_subscribe_keep_alive(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_unsubscribe_keep_alive(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_subscribe_profits(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_unsubscribe_profits(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_subscribe_tick_prices(
+        XTB_StreamClient * self, char * symbol, time_t min_arrive_time, int max_level);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_subscribe_tick_prices_by_id(
+        XTB_StreamClient * self, XTB_SymbolId id, time_t min_arrive_time, int max_level);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_unsubscribe_tick_price(XTB_StreamClient * self, char * symbol);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_subscribe_trades(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_unsubscribe_trades(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_subscribe_trade_status(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_unsubscribe_trade_status(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+bool xtb_stream_client_ping(XTB_StreamClient * self);
+
+
+/**
+ * @brief
+ */
+void xtb_stream_client_delete(XTB_StreamClient * self);
+
+
+/**
+ * @brief Creates book of open positions and pending orders of the client loaded by getTrades. 
+ * The book is kept current by trades and profits messages of stream clients of this client, 
+ * both have to be subscribed. Positions are loaded again after reconnect of stream client, 
+ * asynchronously when the client is processed by I/O thread or event loop.
+ */
+bool xtb_client_enable_positions(XTB_Client * self);
+
+
+/**
+ * @brief Loads the book of positions again by getTrades.
+ */
+bool xtb_client_sync_positions(XTB_Client * self);
+
+
+/**
+ * @brief Copies position by its position number, it can be called from any thread.
+ */
+bool xtb_client_get_position(XTB_Client * self, uint64_t position, XTB_TradeRecord * trade);
+
+
+/**
+ * @brief Copies consistent snapshot of open positions of symbol, or of all positions if symbol 
+ * is NULL, into buffer. Returns the number of positions, which can be greater than size, only 
+ * the first size positions are copied then.
+ */
+size_t xtb_client_get_positions(XTB_Client * self, const char * symbol, XTB_TradeRecord * buffer, size_t size);
+
+
+/**
+ * @brief Specification of symbol used for local calculation of profit and margin, leverage is 
+ * the margin in percent of nominal value.
+ */
+typedef struct {
+    char symbol[XTB_SYMBOL_SIZE];
+    char currency[XTB_CURRENCY_SIZE];
+    char currency_profit[XTB_CURRENCY_SIZE];
+    double contract_size;
+    double tick_size;
+    double tick_value;
+    double leverage;
+    double bid;
+    double ask;
+    int precision;
+    int margin_mode;
+    int profit_mode;
+}XTB_SymbolSpec;
+
+
+/**
+ * @brief Value of position in currency of account, price is the price for which the position 
+ * would be closed now. Positions which can't be valued have valid set to false and zero values, 
+ * pending orders have zero profit and margin.
+ */
+typedef struct {
+    double price;
+    double profit;
+    double margin;
+    bool valid;
+}XTB_PositionValue;
+
+
+/**
+ * @brief Loads specifications of all symbols by getAllSymbols and the currency of account into
+ * the cache of client. Currency pairs needed for conversion into currency of account have to be
+ * in the cache, so it should be called before valuation of positions in foreign currencies.
+ */
+bool xtb_client_load_symbol_specs(XTB_Client * self);
+
+
+/**
+ * @brief Loads cache of symbol specifications from memory mapped catalog file. If the file is 
+ * missing or older than max_age milliseconds, the catalog is downloaded by separate connection 
+ * in background thread, the cache is replaced and the file is written afterwards. Returns false 
+ * if neither the file was loaded nor the refresh started.
+ */
+bool xtb_client_open_symbol_catalog(XTB_Client * self, const char * path, int64_t max_age);
+
+
+/**
+ * @brief Waits for the end of background refresh of symbol catalog. Called also from xtb_client_delete.
+ */
+void xtb_client_wait_symbol_catalog(XTB_Client * self);
+
+
+/**
+ * @brief Number of cached symbol specifications.
+ */
+size_t xtb_client_symbol_catalog_size(XTB_Client * self);
+
+
+/**
+ * @brief Copies cached specification of symbol, missing specification is loaded by getSymbol.
+ */
+bool xtb_client_get_symbol_spec(XTB_Client * self, const char * symbol, XTB_SymbolSpec * spec);
+
+
+/**
+ * @brief Local alternative of xtb_client_get_profit_calculation, the result is in currency of
+ * account.
+ */
+bool xtb_client_calculate_profit(
+        XTB_Client * self, const char * symbol, XTB_TransMode mode
+        , double open_price, double close_price, double volume, double * profit);
+
+
+/**
+ * @brief Local alternative of xtb_client_get_margin_trade, the result is in currency of account.
+ */
+bool xtb_client_calculate_margin(XTB_Client * self, const char * symbol, double volume, double * margin);
+
+
+/**
+ * @brief Values positions by streamed quotes (see xtb_client_enable_quotes), or by prices of cached
+ * specifications if quotes aren't available, without any request to server. Specifications of
+ * symbols have to be cached already. Returns the number of valued positions.
+ */
+size_t xtb_client_value_positions(
+        XTB_Client * self, const XTB_TradeRecord * position, size_t size, XTB_PositionValue * value);
+
+
+/**
+ * @brief Event loop drives main connections of XTB_Client and all XTB_StreamClient connections
+ * from one thread by epoll, stream callbacks are called as soon as the whole message is received.
+ * Connections are non-blocking, so one slow connection does not starve the others.
+ */
+typedef struct XTB_EventLoop XTB_EventLoop;
+
+
+/**
+ * @brief
+ */
+XTB_EventLoop * xtb_event_loop_new(void);
+
+
+/**
+ * @brief
+ */
+bool xtb_event_loop_add_client(XTB_EventLoop * self, XTB_Client * client);
+
+
+/**
+ * @brief
+ */
+void xtb_event_loop_remove_client(XTB_EventLoop * self, XTB_Client * client);
+
+
+/**
+ * @brief
+ */
+bool xtb_event_loop_add_stream_client(XTB_EventLoop * self, XTB_StreamClient * stream_client);
+
+
+/**
+ * @brief
+ */
+void xtb_event_loop_remove_stream_client(XTB_EventLoop * self, XTB_StreamClient * stream_client);
+
+
+/**
+ * @brief Waits at most timeout milliseconds (-1 forever, 0 do not wait) for incoming data and processes 
+ * all ready connections. Returns number of processed connections or -1 on error.
+ */
+int xtb_event_loop_run_once(XTB_EventLoop * self, int timeout);
+
+
+/**
+ * @brief Processes registered connections for duration milliseconds, negative duration runs until 
+ * xtb_event_loop_stop is called or all connections are removed
+ */
+bool xtb_event_loop_run(XTB_EventLoop * self, int duration);
+
+
+/**
+ * @brief
+ */
+void xtb_event_loop_stop(XTB_EventLoop * self);
+
+
+/**
+ * @brief
+ */
+void xtb_event_loop_delete(XTB_EventLoop * self);
+
+
+#endif
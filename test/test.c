@@ -1,6 +1,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <throw.h>
 #include <vector.h>
 
@@ -332,6 +336,129 @@ void __open_trade(XTB_Client * client) {
 }   
 
 
+void __order_template(XTB_Client * client) {
+    XTB_OrderTemplate * order_template = xtb_order_template_new(client, "BITCOIN", XTB_TransMode_BUY);
+    Json * symbol = xtb_client_get_symbol(client, "BITCOIN");
+    uint64_t order;
+
+    if(order_template != NULL && symbol != NULL) {
+        float price = atof(json_lookup(symbol, "ask")->string);
+
+        if(xtb_order_template_send(order_template, price, 0.01, 0, 0, &order) == true) {
+            printf("order: %lu\n", order);
+        } else {
+            printf("Trade can't be open\n");
+        }
+    }
+
+    json_delete(symbol);
+    xtb_order_template_delete(order_template);
+}
+
+
+void __pipeline(XTB_Client * client) {
+    char * symbols[] = {"BITCOIN", "ETHEREUM", "EURUSD", "GOLD"};
+    XTB_Pipeline * pipeline = xtb_pipeline_new(client);
+
+    for(size_t i = 0; i < sizeof(symbols) / sizeof(*symbols); i++) {
+        xtb_pipeline_get_symbol(pipeline, symbols[i]);
+    }
+
+    size_t margin = xtb_pipeline_get_margin_trade(pipeline, "BITCOIN", 1);
+    size_t commision = xtb_pipeline_get_commision_def(pipeline, "BITCOIN", 1);
+
+    if(margin == SIZE_MAX || commision == SIZE_MAX) {
+        printf("pipeline allocation error\n");
+        xtb_pipeline_delete(pipeline);
+        return;
+    }
+
+    if(xtb_pipeline_execute(pipeline) == false) {
+        printf("some of pipeline commands failed\n");
+    }
+
+    for(size_t i = 0; i < xtb_pipeline_size(pipeline); i++) {
+        Json * result = xtb_pipeline_result(pipeline, i);
+
+        if(result != NULL) {
+            printf("%s%ld:\n", i == margin ? "margin " : i == commision ? "commision " : "", i);
+            json_show(result, stdout);
+            json_delete(result);
+        }
+    }
+
+    xtb_pipeline_delete(pipeline);
+}
+
+
+void __async_result(void * param, XTB_Error error, Json * result) {
+    size_t * waiting = param;
+
+    if(error == XTB_Error_None) {
+        json_show(result, stdout);
+    } else {
+        printf("async command failed: %d\n", error);
+    }
+
+    json_delete(result);
+    (*waiting)--;
+}
+
+
+void __async(XTB_Client * client) {
+    size_t waiting = 3;
+    
+    xtb_client_async_get_trade_history(client, time(NULL) - (XTB_PERIOD_D1 * 10), 0, __async_result, &waiting);
+    xtb_client_async_get_symbol(client, "BITCOIN", __async_result, &waiting);
+    xtb_client_async_get_server_time(client, __async_result, &waiting);
+
+    while(waiting > 0) {
+        struct pollfd pfd = {.fd = xtb_client_fd(client), .events = POLLIN};
+
+        if(poll(&pfd, 1, 1000) > 0 && xtb_client_process(client) == false) {
+            printf("connection failed\n");
+            break;
+        }
+    }
+}
+
+
+void * __threaded_worker(void * param) {
+    XTB_Client * client = param;
+
+    for(size_t i = 0; i < 5; i++) {
+        Json * server_time = xtb_client_get_server_time(client);
+
+        if(server_time != NULL) {
+            json_show(server_time, stdout);
+            json_delete(server_time);
+        }
+    }
+
+    return NULL;
+}
+
+
+void __threaded(XTB_Client * client) {
+    pthread_t workers[4];
+
+    if(xtb_client_start_io_thread(client) == false) {
+        printf("I/O thread start failed\n");
+        return;
+    }
+
+    for(size_t i = 0; i < sizeof(workers) / sizeof(*workers); i++) {
+        pthread_create(&workers[i], NULL, __threaded_worker, client);
+    }
+
+    for(size_t i = 0; i < sizeof(workers) / sizeof(*workers); i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    xtb_client_stop_io_thread(client);
+}
+
+
 typedef struct {
     char * symbol;
     char * order; 
@@ -471,8 +598,12 @@ client_run(XTB_Client * client) {
     //__get_step_rules(client);
     //__get_commision_def(client);
     //__open_trade(client);
+    //__order_template(client);
     //__close_trade(client);
     //__close_all_trade(client);
+    //__pipeline(client);
+    //__async(client);
+    //__threaded(client);
     //EURUSD
 }
 
@@ -607,6 +738,12 @@ void process_trade_status(void * param, Json * trade_status) {
 }
 
 
+void process_gap(void * param, int64_t from, int64_t to) {
+    (void) param;
+    printf("stream data missing from %ld to %ld\n", from, to);
+}
+
+
 void scalping(XTB_Client * client) {
     StreamClientCallback callback = {
         .balance = process_balance
@@ -617,6 +754,7 @@ void scalping(XTB_Client * client) {
         , .profit = process_profit
         , .trades = process_trades
         , .trade_status = process_trade_status
+        , .gap = process_gap
     };  
     
 	time_t start, end;
@@ -672,17 +810,732 @@ void scalping(XTB_Client * client) {
 
 
 
+void process_typed_tick(void * param, const XTB_Tick * tick) {
+    (void) param;
+    printf("%s bid: %f ask: %f time: %ld\n", tick->symbol, tick->bid, tick->ask, tick->timestamp);
+}
+
+
+void typed_stream(XTB_Client * client) {
+    StreamClientCallback callback = {0};
+    XTB_StreamHandler handler = {.tick_prices = process_typed_tick};
+    XTB_StreamClient * stream = xtb_stream_client_new(client, &callback, NULL);
+
+    xtb_stream_client_set_handler(stream, &handler);
+    xtb_stream_client_subscribe_tick_prices(stream, "EURUSD", 0, 0);
+
+    for(size_t i = 0; i < 100; i++) {
+        xtb_stream_client_process(stream);
+    }
+
+    xtb_stream_client_delete(stream);
+}
+
+
+typedef struct {
+    XTB_StreamClient * stream;
+    atomic_bool running;
+}Strategy;
+
+
+void * strategy_thread(void * param) {
+    Strategy * strategy = param;
+    XTB_StreamEvent events[64];
+
+    while(atomic_load(&strategy->running) == true) {
+        size_t size = xtb_stream_client_drain(strategy->stream, events, 64);
+
+        for(size_t i = 0; i < size; i++) {
+            if(events[i].type == XTB_StreamEvent_Tick) {
+                printf("%s bid: %f ask: %f\n", events[i].tick.symbol, events[i].tick.bid, events[i].tick.ask);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+
+void ring_stream(XTB_Client * client) {
+    StreamClientCallback callback = {0};
+    Strategy strategy = {.stream = xtb_stream_client_new(client, &callback, NULL), .running = true};
+    pthread_t thread;
+
+    xtb_stream_client_enable_ring(strategy.stream, 1024, XTB_RingPolicy_Conflate);
+    xtb_stream_client_subscribe_tick_prices(strategy.stream, "EURUSD", 0, 0);
+    pthread_create(&thread, NULL, strategy_thread, &strategy);
+
+    for(size_t i = 0; i < 100; i++) {
+        xtb_stream_client_process(strategy.stream);
+    }
+
+    atomic_store(&strategy.running, false);
+    pthread_join(thread, NULL);
+
+    XTB_RingStats stats = xtb_stream_client_ring_stats(strategy.stream);
+    printf("received: %lu dropped: %lu conflated: %lu\n", stats.received, stats.dropped, stats.conflated);
+
+    xtb_stream_client_delete(strategy.stream);
+}
+
+
+void quotes(XTB_Client * client) {
+    StreamClientCallback callback = {0};
+    XTB_Quote quote;
+
+    xtb_client_enable_quotes(client, 256);
+
+    XTB_StreamClient * stream = xtb_stream_client_new(client, &callback, NULL);
+    xtb_stream_client_subscribe_tick_prices(stream, "EURUSD", 0, 0);
+
+    for(size_t i = 0; i < 10; i++) {
+        xtb_stream_client_process(stream);
+
+        if(xtb_client_get_quote(client, "EURUSD", 0, &quote) == true) {
+            printf("%s bid: %f ask: %f spread: %f\n", quote.symbol, quote.bid, quote.ask, quote.spread);
+        }
+    }
+
+    xtb_stream_client_delete(stream);
+}
+
+
+void process_order(void * param, const XTB_OrderEvent * event) {
+    (void) param;
+    printf(
+        "order: %lu position: %lu state: %d -> %d price: %f after: %ld us\n"
+        , event->order, event->position, event->previous, event->state, event->price
+        , (event->timestamp - event->submitted) / 1000);
+}
+
+
+void order_tracking(XTB_Client * client) {
+    StreamClientCallback callback = {0};
+    uint64_t order;
+
+    xtb_client_enable_quotes(client, 256);
+    xtb_client_enable_order_tracking(client);
+    xtb_client_set_order_callback(client, process_order, NULL);
+
+    XTB_StreamClient * stream = xtb_stream_client_new(client, &callback, NULL);
+    xtb_stream_client_subscribe_tick_prices(stream, "EURUSD", 0, 0);
+    xtb_stream_client_subscribe_trade_status(stream);
+    xtb_stream_client_subscribe_trades(stream);
+
+    XTB_OrderTemplate * order_template = xtb_order_template_new(client, "EURUSD", XTB_TransMode_BUY);
+
+    for(size_t i = 0; i < 10; i++) {
+        xtb_stream_client_process(stream);
+    }
+
+    if(xtb_order_template_open(order_template, 0.01, 0, 0, &order) == true) {
+        printf("order: %lu sent\n", order);
+    }
+
+    for(size_t i = 0; i < 10; i++) {
+        xtb_stream_client_process(stream);
+    }
+
+    xtb_order_template_delete(order_template);
+    xtb_stream_client_delete(stream);
+}
+
+
+void positions(XTB_Client * client) {
+    StreamClientCallback callback = {0};
+    XTB_TradeRecord position[16];
+
+    xtb_client_enable_positions(client);
+
+    XTB_StreamClient * stream = xtb_stream_client_new(client, &callback, NULL);
+    xtb_stream_client_subscribe_trades(stream);
+    xtb_stream_client_subscribe_profits(stream);
+
+    for(size_t i = 0; i < 10; i++) {
+        xtb_stream_client_process(stream);
+
+        size_t size = xtb_client_get_positions(client, "EURUSD", position, 16);
+
+        for(size_t j = 0; j < size && j < 16; j++) {
+            printf("%s position: %ld volume: %f profit: %f\n"
+                    , position[j].symbol, position[j].position, position[j].volume, position[j].profit);
+        }
+    }
+
+    xtb_stream_client_delete(stream);
+}
+
+
+void portfolio_value(XTB_Client * client) {
+    StreamClientCallback callback = {0};
+    XTB_TradeRecord position[256];
+    XTB_PositionValue value[256];
+    double profit;
+
+    xtb_client_load_symbol_specs(client);
+    xtb_client_enable_quotes(client, 1024);
+    xtb_client_enable_positions(client);
+
+    if(xtb_client_calculate_profit(client, "EURUSD", XTB_TransMode_BUY, 1.08, 1.09, 0.1, &profit) == true) {
+        printf("EURUSD profit: %f\n", profit);
+    }
+
+    XTB_StreamClient * stream = xtb_stream_client_new(client, &callback, NULL);
+    xtb_stream_client_subscribe_trades(stream);
+    xtb_stream_client_subscribe_tick_prices(stream, "EURUSD", 0, 0);
+
+    for(size_t i = 0; i < 10; i++) {
+        xtb_stream_client_process(stream);
+
+        size_t size = xtb_client_get_positions(client, NULL, position, 256);
+        size        = size < 256 ? size : 256;
+
+        xtb_client_value_positions(client, position, size, value);
+
+        for(size_t j = 0; j < size; j++) {
+            if(value[j].valid == true) {
+                printf("%s profit: %f margin: %f\n", position[j].symbol, value[j].profit, value[j].margin);
+            } else {
+                printf("%s can't be valued\n", position[j].symbol);
+            }
+        }
+    }
+
+    xtb_stream_client_delete(stream);
+}
+
+
+void symbol_catalog(XTB_Client * client) {
+    XTB_SymbolSpec spec;
+
+    xtb_client_open_symbol_catalog(client, "symbols.cache", 24 * 3600 * 1000);
+    xtb_client_wait_symbol_catalog(client);
+
+    printf("symbols: %lu\n", xtb_client_symbol_catalog_size(client));
+
+    if(xtb_client_get_symbol_spec(client, "EURUSD", &spec) == true) {
+        printf("%s contract size: %f leverage: %f\n", spec.symbol, spec.contract_size, spec.leverage);
+    }
+}
+
+
+void process_tick_by_id(void * param, const XTB_Tick * tick) {
+    double * last_bid = param;
+
+    printf("%s bid: %f change: %f\n", xtb_symbol_name(tick->id), tick->bid, tick->bid - last_bid[tick->id]);
+    last_bid[tick->id] = tick->bid;
+}
+
+
+void symbol_ids(XTB_Client * client) {
+    StreamClientCallback callback = {0};
+    XTB_StreamHandler handler = {.tick_prices = process_tick_by_id};
+    double * last_bid = calloc(XTB_SYMBOL_ID_CAPACITY, sizeof(double));
+
+    XTB_SymbolId eurusd  = xtb_symbol_intern("EURUSD");
+    XTB_SymbolId bitcoin = xtb_symbol_intern("BITCOIN");
+
+    XTB_StreamClient * stream = xtb_stream_client_new(client, &callback, last_bid);
+    xtb_stream_client_set_handler(stream, &handler);
+    xtb_stream_client_subscribe_tick_prices_by_id(stream, eurusd, 0, 0);
+    xtb_stream_client_subscribe_tick_prices_by_id(stream, bitcoin, 0, 0);
+
+    for(size_t i = 0; i < 10; i++) {
+        xtb_stream_client_process(stream);
+    }
+
+    xtb_stream_client_delete(stream);
+    free(last_bid);
+}
+
+
+void process_bar(void * param, const XTB_Bar * bar) {
+    (void) param;
+    printf(
+        "%s %lds %ld o: %f h: %f l: %f c: %f ticks: %ld\n"
+        , bar->symbol, bar->period / 1000, bar->start, bar->open, bar->high, bar->low, bar->close, bar->ticks);
+}
+
+
+void tick_bars(XTB_Client * client) {
+    StreamClientCallback callback = {0};
+    XTB_BarBuilder * bars = xtb_bar_builder_new(process_bar, NULL);
+
+    xtb_bar_builder_add(bars, "EURUSD", 5 * 1000);
+    xtb_bar_builder_add(bars, "EURUSD", 15 * 1000);
+    xtb_bar_builder_add(bars, "EURUSD", 5 * 60 * 1000);
+
+    XTB_StreamClient * stream = xtb_stream_client_new(client, &callback, NULL);
+    xtb_stream_client_set_bar_builder(stream, bars);
+    xtb_stream_client_subscribe_tick_prices(stream, "EURUSD", 0, 0);
+
+    for(size_t i = 0; i < 100; i++) {
+        xtb_stream_client_process(stream);
+    }
+
+    xtb_stream_client_delete(stream);
+    xtb_bar_builder_delete(bars);
+}
+
+
+void process_series(void * param, const XTB_LiveSeries * series) {
+    XTB_SeriesView view = xtb_live_series_view(series);
+    double sum          = 0;
+    size_t length       = view.size < 20 ? view.size : 20;
+
+    (void) param;
+
+    for(size_t i = view.size - length; i < view.size; i++) {
+        sum += view.close[i];
+    }
+
+    printf("%s bars: %lu close: %f sma: %f\n", view.symbol, view.size, view.close[view.size - 1], sum / length);
+}
+
+
+void live_series(XTB_Client * client) {
+    StreamClientCallback callback = {0};
+    XTB_StreamClient * stream     = xtb_stream_client_new(client, &callback, NULL);
+
+    xtb_stream_client_add_series(stream, "EURUSD", XTB_PERIOD_M5, 500, process_series, NULL);
+
+    for(size_t i = 0; i < 100; i++) {
+        xtb_stream_client_process(stream);
+    }
+
+    xtb_stream_client_delete(stream);
+}
+
+
+void candle_series(XTB_Client * client) {
+    XTB_CandleSeries * series = xtb_client_get_lastn_candle_series(client, "EURUSD", XTB_PERIOD_M15, 1000);
+
+    if(series != NULL) {
+        double sum = 0;
+
+        for(size_t i = 0; i < series->size; i++) {
+            sum += series->close[i];
+        }
+
+        printf("%s %zu bars, mean close %f\n", series->symbol, series->size, sum / series->size);
+        xtb_candle_series_delete(series);
+    }
+}
+
+
+void history_store(XTB_Client * client) {
+    XTB_HistoryStore * store = xtb_history_store_open(".", "EURUSD", XTB_PERIOD_M5);
+
+    if(store != NULL) {
+        xtb_history_store_sync(store, client, 10000);
+
+        XTB_SeriesView view = xtb_history_store_range(store, (time(NULL) - 86400) * 1000LL, time(NULL) * 1000LL);
+
+        printf("%zu bars stored, %zu bars in the last day\n", xtb_history_store_size(store), view.size);
+        xtb_history_store_close(store);
+    }
+}
+
+
+void process_archived_tick(void * param, const XTB_Tick * tick) {
+    (void) param;
+    printf("%ld %s %f %f\n", tick->timestamp, tick->symbol, tick->bid, tick->ask);
+}
+
+
+void tick_archive(XTB_Client * client) {
+    StreamClientCallback callback = {0};
+    XTB_StreamClient * stream     = xtb_stream_client_new(client, &callback, NULL);
+    XTB_ArchiveWriter * writer    = xtb_archive_writer_open("ticks.xar");
+
+    xtb_stream_client_set_archive(stream, writer);
+    xtb_stream_client_subscribe_tick_prices(stream, "EURUSD", 0, 0);
+
+    for(size_t i = 0; i < 100; i++) {
+        xtb_stream_client_process(stream);
+    }
+
+    xtb_stream_client_delete(stream);
+    xtb_archive_writer_close(writer);
+
+    XTB_ArchiveReader * reader = xtb_archive_reader_open("ticks.xar");
+    XTB_StreamHandler handler  = {.tick_prices = process_archived_tick};
+
+    if(reader != NULL) {
+        xtb_archive_reader_replay(reader, 0, INT64_MAX, &handler, NULL);
+        xtb_archive_reader_close(reader);
+    }
+}
+
+
+/*
+ * offline check of archive, written ticks and candles have to be read back unchanged, 
+ * values are chosen to use all encodings, -0.0 followed by value encoded by xor checks that 
+ * writer and reader keep the same previous value
+ */
+#define ROUND_TRIP_SIZE 64
+
+
+typedef struct {
+    XTB_Tick tick[ROUND_TRIP_SIZE];
+    XTB_Candle candle[ROUND_TRIP_SIZE];
+    size_t ticks;
+    size_t candles;
+    size_t errors;
+}RoundTrip;
+
+
+/*
+ * values are compared by bits, the test is built with fast math as the library
+ */
+bool round_trip_same(double value, double expected) {
+    return memcmp(&value, &expected, sizeof(double)) == 0;
+}
+
+
+void round_trip_tick(void * param, const XTB_Tick * tick) {
+    RoundTrip * trip = param;
+    XTB_Tick * expected = &trip->tick[trip->ticks++ % ROUND_TRIP_SIZE];
+
+    if(tick->timestamp != expected->timestamp || tick->id != expected->id
+            || round_trip_same(tick->ask, expected->ask) == false
+            || round_trip_same(tick->bid, expected->bid) == false
+            || round_trip_same(tick->high, expected->high) == false
+            || round_trip_same(tick->low, expected->low) == false
+            || round_trip_same(tick->spread_raw, expected->spread_raw) == false
+            || round_trip_same(tick->spread_table, expected->spread_table) == false
+            || tick->ask_volume != expected->ask_volume || tick->bid_volume != expected->bid_volume
+            || tick->level != expected->level || tick->quote_id != expected->quote_id) {
+        printf("tick %ld differs: %f %f %f\n", tick->timestamp, tick->bid, tick->spread_raw, tick->spread_table);
+        trip->errors++;
+    }
+}
+
+
+void round_trip_candle(void * param, const XTB_Candle * candle) {
+    RoundTrip * trip = param;
+    XTB_Candle * expected = &trip->candle[trip->candles++ % ROUND_TRIP_SIZE];
+
+    if(candle->ctm != expected->ctm || candle->id != expected->id
+            || round_trip_same(candle->open, expected->open) == false
+            || round_trip_same(candle->close, expected->close) == false
+            || round_trip_same(candle->high, expected->high) == false
+            || round_trip_same(candle->low, expected->low) == false
+            || round_trip_same(candle->vol, expected->vol) == false
+            || candle->quote_id != expected->quote_id) {
+        printf("candle %ld differs: %f %f\n", candle->ctm, candle->close, candle->vol);
+        trip->errors++;
+    }
+}
+
+
+bool archive_round_trip(void) {
+    static RoundTrip trip;
+    const char * path = "round_trip.xar";
+    int64_t time      = 1700000000000;
+
+    remove(path);
+
+    XTB_ArchiveWriter * writer = xtb_archive_writer_open(path);
+
+    if(writer == NULL) {
+        printf("archive can't be created\n");
+        return false;
+    }
+
+    for(size_t i = 0; i < ROUND_TRIP_SIZE; i++) {
+        double bid = 1.08 + (double) (i % 7) / 100000;
+
+        trip.tick[i] = (XTB_Tick) {
+            .symbol = "EURUSD"
+            , .id = xtb_symbol_intern("EURUSD")
+            , .bid = bid
+            , .ask = bid + 0.00008
+            , .high = 1.0812
+            , .low = i % 5 == 0 ? 1.0 / 3.0 : 1.0791
+            , .spread_raw = i % 3 == 0 ? -0.0 : i % 3 == 1 ? 1.0 / 3.0 : 0.00008
+            , .spread_table = i % 3 == 1 ? 0.8 : 1.0 / 7.0
+            , .ask_volume = 1000000 * (i % 4)
+            , .bid_volume = 500000
+            , .timestamp = time + (int64_t) i * 250 + (int64_t) (i % 3)
+            , .level = 0
+            , .quote_id = i % 2
+        };
+
+        trip.candle[i] = (XTB_Candle) {
+            .symbol = "GOLD"
+            , .id = xtb_symbol_intern("GOLD")
+            , .ctm = time + (int64_t) i * 60000
+            , .open = 2000.5 + i
+            , .close = i % 4 == 0 ? -0.0 : i % 4 == 1 ? 2001.0 / 3.0 : 2001.25 + i
+            , .high = 2002.0 + i
+            , .low = 1999.75 + i
+            , .vol = i % 6 == 0 ? 0.1 + 0.2 : 12.0 + i
+            , .quote_id = 1
+        };
+
+        xtb_archive_write_tick(writer, &trip.tick[i]);
+        xtb_archive_write_candle(writer, &trip.candle[i]);
+    }
+
+    xtb_archive_writer_close(writer);
+
+    XTB_ArchiveReader * reader = xtb_archive_reader_open(path);
+    XTB_StreamHandler handler  = {.tick_prices = round_trip_tick, .candle = round_trip_candle};
+    int64_t delivered          = -1;
+
+    if(reader != NULL) {
+        delivered = xtb_archive_reader_replay(reader, 0, INT64_MAX, &handler, &trip);
+        xtb_archive_reader_close(reader);
+    }
+
+    remove(path);
+
+    bool success = delivered == 2 * ROUND_TRIP_SIZE && trip.ticks == ROUND_TRIP_SIZE 
+                    && trip.candles == ROUND_TRIP_SIZE && trip.errors == 0;
+
+    printf("archive round trip: %s\n", success == true ? "ok" : "failed");
+
+    return success;
+}
+
+
+void stream_replay(XTB_Client * client) {
+    StreamClientCallback callback = {
+        .tick_prices = process_tick_price
+        , .balance = process_balance
+        , .profit = process_profit
+    };
+
+    Predictor predictor              = predictor_new(5);
+    XTB_StreamClient * stream_client = xtb_stream_client_new(client, &callback, &predictor);
+    XTB_StreamRecorder * recorder    = xtb_stream_recorder_open("stream.rec");
+
+    xtb_stream_client_set_recorder(stream_client, recorder);
+    xtb_stream_client_subscribe_tick_prices(stream_client, "ETHEREUM", 0, 0);
+    xtb_stream_client_subscribe_balance(stream_client);
+
+    for(size_t i = 0; i < 100; i++) {
+        xtb_stream_client_process(stream_client);
+    }
+
+    xtb_stream_client_delete(stream_client);
+    xtb_stream_recorder_close(recorder);
+    predictor_delete(&predictor);
+
+    /*
+     * the same session replayed offline as fast as possible
+     */
+    XTB_StreamReplayer * replayer = xtb_stream_replayer_open("stream.rec");
+
+    if(replayer != NULL) {
+        predictor     = predictor_new(5);
+        stream_client = xtb_stream_client_new_offline(NULL, &callback, &predictor);
+
+        printf("replayed %ld frames\n", xtb_stream_replayer_run(replayer, stream_client, 0));
+
+        xtb_stream_client_delete(stream_client);
+        xtb_stream_replayer_close(replayer);
+        predictor_delete(&predictor);
+    }
+}
+
+
+/*
+ * offline replay of fixture built from stream frames, no login is needed
+ */
+typedef struct {
+    size_t ticks;
+    size_t balances;
+    double last_bid;
+    double equity;
+}ReplayCheck;
+
+
+void replay_check_tick(void * param, const XTB_Tick * tick) {
+    ReplayCheck * check = param;
+
+    check->ticks++;
+    check->last_bid = tick->bid;
+}
+
+
+void replay_check_balance(void * param, const XTB_Balance * balance) {
+    ReplayCheck * check = param;
+
+    check->balances++;
+    check->equity = balance->equity;
+}
+
+
+bool stream_replay_offline(void) {
+    const char * path = "stream_fixture.rec";
+    const char * frames[] = {
+        "{\"command\":\"keepAlive\",\"data\":{\"timestamp\":1700000000000}}"
+        , "{\"command\":\"tickPrices\",\"data\":{\"symbol\":\"ETHEREUM\",\"ask\":2010.5,\"bid\":2009.5"
+            ",\"high\":2020.0,\"low\":2001.0,\"askVolume\":10,\"bidVolume\":12,\"timestamp\":1700000000100"
+            ",\"quoteId\":1,\"level\":0,\"spreadTable\":1.0,\"spreadRaw\":1.0}}"
+        , "{\"command\":\"balance\",\"data\":{\"balance\":1000.0,\"credit\":0.0,\"equity\":1002.5"
+            ",\"margin\":20.0,\"marginFree\":982.5,\"marginLevel\":5012.5}}"
+        , "{\"command\":\"tickPrices\",\"data\":{\"symbol\":\"ETHEREUM\",\"ask\":2011.5,\"bid\":2010.25"
+            ",\"high\":2020.0,\"low\":2001.0,\"askVolume\":10,\"bidVolume\":12,\"timestamp\":1700000000600"
+            ",\"quoteId\":1,\"level\":0,\"spreadTable\":1.25,\"spreadRaw\":1.25}}"
+    };
+    size_t size = sizeof(frames) / sizeof(*frames);
+
+    XTB_StreamRecorder * recorder = xtb_stream_recorder_open(path);
+
+    if(recorder == NULL) {
+        printf("stream fixture can't be created\n");
+        return false;
+    }
+
+    for(size_t i = 0; i < size; i++) {
+        xtb_stream_recorder_write(recorder, frames[i], 1700000000000 + (int64_t) i * 250);
+    }
+
+    xtb_stream_recorder_close(recorder);
+
+    StreamClientCallback callback = {0};
+    XTB_StreamHandler handler     = {.tick_prices = replay_check_tick, .balance = replay_check_balance};
+    ReplayCheck check             = {0};
+    XTB_StreamReplayer * replayer = xtb_stream_replayer_open(path);
+    XTB_StreamClient * stream     = xtb_stream_client_new_offline(NULL, &callback, &check);
+    int64_t replayed              = -1;
+
+    if(replayer != NULL && stream != NULL) {
+        xtb_stream_client_set_handler(stream, &handler);
+        replayed = xtb_stream_replayer_run(replayer, stream, 0);
+    }
+
+    xtb_stream_client_delete(stream);
+    xtb_stream_replayer_close(replayer);
+    remove(path);
+
+    bool success = replayed == (int64_t) size && check.ticks == 2 && check.balances == 1
+                    && check.last_bid == 2010.25 && check.equity == 1002.5;
+
+    printf("stream replay: %s\n", success == true ? "ok" : "failed");
+
+    return success;
+}
+
+
+void event_loop(XTB_Client * client) {
+    StreamClientCallback callback = {
+        .tick_prices = process_tick_price
+        , .balance = process_balance
+        , .profit = process_profit
+    };
+
+	Predictor predictor = predictor_new(5);
+    XTB_EventLoop * loop = xtb_event_loop_new();
+    XTB_StreamClient * ethereum = xtb_stream_client_new(client, &callback, &predictor);
+    XTB_StreamClient * bitcoin = xtb_stream_client_new(client, &callback, &predictor);
+
+    xtb_stream_client_subscribe_tick_prices(ethereum, "ETHEREUM", 0, 0);
+    xtb_stream_client_subscribe_tick_prices(bitcoin, "BITCOIN", 0, 0);
+    xtb_stream_client_subscribe_balance(bitcoin);
+
+    xtb_event_loop_add_client(loop, client);
+    xtb_event_loop_add_stream_client(loop, ethereum);
+    xtb_event_loop_add_stream_client(loop, bitcoin);
+
+    xtb_event_loop_run(loop, 10000);
+
+    xtb_event_loop_delete(loop);
+	predictor_delete(&predictor);
+}
+
+
 
 #define ID       "15713459"
 #define PASSWORD "4xl74fx0.H"
 
 
+typedef struct {
+    XTB_ClientPool * pool;
+    char ** symbols;
+    size_t size;
+    _Atomic size_t next;
+}ChartJob;
+
+
+void * __client_pool_worker(void * param) {
+    ChartJob * job = param;
+    size_t index;
+
+    while((index = atomic_fetch_add(&job->next, 1)) < job->size) {
+        XTB_Client * client = xtb_client_pool_acquire(job->pool);
+        Json * chart = xtb_client_get_chart_range_request(
+                client, job->symbols[index], XTB_PERIOD_H1, time(NULL) - XTB_PERIOD_D1 * 30, time(NULL), 0);
+        xtb_client_pool_release(job->pool, client);
+
+        if(chart != NULL) {
+            printf("%s: %ld\n", job->symbols[index], json_lookup(chart, "rateInfos")->array.size);
+            json_delete(chart);
+        } else {
+            printf("%s: chart can't be load\n", job->symbols[index]);
+        }
+    }
+
+    return NULL;
+}
+
+
+void __client_pool(void) {
+    char * symbols[] = {"EURUSD", "GBPUSD", "USDJPY", "BITCOIN", "ETHEREUM", "GOLD", "SILVER", "OIL"};
+    pthread_t workers[4];
+    ChartJob job = {
+        .pool = xtb_client_pool_new(XTB_AccountMode_Demo, ID, PASSWORD, 4)
+        , .symbols = symbols
+        , .size = sizeof(symbols) / sizeof(*symbols)
+    };
+
+    if(job.pool == NULL) {
+        printf("Can't create connection pool\n");
+        return;
+    }
+
+    for(size_t i = 0; i < sizeof(workers) / sizeof(*workers); i++) {
+        pthread_create(&workers[i], NULL, __client_pool_worker, &job);
+    }
+
+    for(size_t i = 0; i < sizeof(workers) / sizeof(*workers); i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    xtb_client_pool_delete(job.pool);
+}
+
+
 int main(void) {
+    //__client_pool();
+
+    if(archive_round_trip() == false || stream_replay_offline() == false) {
+        return EXIT_FAILURE;
+    }
+
     XTB_Client * client = xtb_client_new(XTB_AccountMode_Demo, ID, PASSWORD);
 
     if(client != NULL && xtb_client_logged(client) == true) {
         //client_run(client);
 		scalping(client);
+        //event_loop(client);
+        //typed_stream(client);
+        //ring_stream(client);
+        //quotes(client);
+        //order_tracking(client);
+        //positions(client);
+        //portfolio_value(client);
+        //symbol_catalog(client);
+        //symbol_ids(client);
+        //tick_bars(client);
+        //live_series(client);
+        //candle_series(client);
+        //history_store(client);
+        //tick_archive(client);
+        //stream_replay(client);
         xtb_client_delete(client);
     } else {
         printf("Can't login to XTB\n");